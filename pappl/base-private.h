@@ -36,8 +36,12 @@ extern char **environ;
 #    define _PAPPL_DEBUG(...)
 #  endif // DEBUG
 
+#  define _PAPPL_HASH_INIT 2166136261u	// Initial FNV-1a hash value
+#  define _PAPPL_HASH_STEP(hash,ch) (((hash) ^ (unsigned char)(ch)) * 16777619u)
 #  define _PAPPL_LOOKUP_STRING(bit,strings) _papplLookupString(bit, sizeof(strings) / sizeof(strings[0]), strings)
 #  define _PAPPL_LOOKUP_VALUE(keyword,strings) _papplLookupValue(keyword, sizeof(strings) / sizeof(strings[0]), strings)
+#  define _PAPPL_RA_NAMES 727		// Number of names in the known attribute name table
+#  define _PAPPL_REQUESTED(ra,name) (!(ra) || ((ra)->bits[(name) / 32] & (1U << ((name) & 31))))
 
 #  ifndef HAVE_STRLCPY
 #    define strlcpy(dst,src,dstsize) _pappl_strlcpy(dst,src,dstsize)
@@ -48,9 +52,114 @@ extern char **environ;
 // Types and structures...
 //
 
+typedef enum _pappl_raname_e		// Known requested attribute names
+{
+  _PAPPL_RA_COPIES,				// "copies"
+  _PAPPL_RA_DATE_TIME_AT_COMPLETED,		// "date-time-at-completed"
+  _PAPPL_RA_DATE_TIME_AT_CREATION,		// "date-time-at-creation"
+  _PAPPL_RA_DATE_TIME_AT_PROCESSING,		// "date-time-at-processing"
+  _PAPPL_RA_DOCUMENT_FORMAT,			// "document-format"
+  _PAPPL_RA_DOCUMENT_NAME,			// "document-name"
+  _PAPPL_RA_JOB_HOLD_UNTIL,			// "job-hold-until"
+  _PAPPL_RA_JOB_ID,				// "job-id"
+  _PAPPL_RA_JOB_IMPRESSIONS,			// "job-impressions"
+  _PAPPL_RA_JOB_IMPRESSIONS_COMPLETED,		// "job-impressions-completed"
+  _PAPPL_RA_JOB_NAME,				// "job-name"
+  _PAPPL_RA_JOB_ORIGINATING_USER_NAME,		// "job-originating-user-name"
+  _PAPPL_RA_JOB_PRINTER_UP_TIME,		// "job-printer-up-time"
+  _PAPPL_RA_JOB_PRINTER_URI,			// "job-printer-uri"
+  _PAPPL_RA_JOB_PRIORITY,			// "job-priority"
+  _PAPPL_RA_JOB_STATE,				// "job-state"
+  _PAPPL_RA_JOB_STATE_MESSAGE,			// "job-state-message"
+  _PAPPL_RA_JOB_STATE_REASONS,			// "job-state-reasons"
+  _PAPPL_RA_JOB_URI,				// "job-uri"
+  _PAPPL_RA_JOB_UUID,				// "job-uuid"
+  _PAPPL_RA_MARKER_COLORS,			// "marker-colors"
+  _PAPPL_RA_MARKER_HIGH_LEVELS,			// "marker-high-levels"
+  _PAPPL_RA_MARKER_LEVELS,			// "marker-levels"
+  _PAPPL_RA_MARKER_LOW_LEVELS,			// "marker-low-levels"
+  _PAPPL_RA_MARKER_NAMES,			// "marker-names"
+  _PAPPL_RA_MARKER_TYPES,			// "marker-types"
+  _PAPPL_RA_MEDIA,				// "media"
+  _PAPPL_RA_MEDIA_COL,				// "media-col"
+  _PAPPL_RA_MEDIA_COL_DATABASE,			// "media-col-database"
+  _PAPPL_RA_MULTIPLE_DOCUMENT_HANDLING,		// "multiple-document-handling"
+  _PAPPL_RA_ORIENTATION_REQUESTED,		// "orientation-requested"
+  _PAPPL_RA_OUTPUT_BIN,				// "output-bin"
+  _PAPPL_RA_PRINT_COLOR_MODE,			// "print-color-mode"
+  _PAPPL_RA_PRINT_CONTENT_OPTIMIZE,		// "print-content-optimize"
+  _PAPPL_RA_PRINT_DARKNESS,			// "print-darkness"
+  _PAPPL_RA_PRINT_QUALITY,			// "print-quality"
+  _PAPPL_RA_PRINT_SCALING,			// "print-scaling"
+  _PAPPL_RA_PRINT_SPEED,			// "print-speed"
+  _PAPPL_RA_PRINTER_CREATION_ATTRIBUTES_SUPPORTED, // "printer-creation-attributes-supported"
+  _PAPPL_RA_PRINTER_CURRENT_TIME,		// "printer-current-time"
+  _PAPPL_RA_PRINTER_FIRMWARE_NAME,		// "printer-firmware-name"
+  _PAPPL_RA_PRINTER_FIRMWARE_PATCHES,		// "printer-firmware-patches"
+  _PAPPL_RA_PRINTER_FIRMWARE_STRING_VERSION,	// "printer-firmware-string-version"
+  _PAPPL_RA_PRINTER_FIRMWARE_VERSION,		// "printer-firmware-version"
+  _PAPPL_RA_PRINTER_ICONS,			// "printer-icons"
+  _PAPPL_RA_PRINTER_ID,				// "printer-id"
+  _PAPPL_RA_PRINTER_IMPRESSIONS_COMPLETED,	// "printer-impressions-completed"
+  _PAPPL_RA_PRINTER_IS_ACCEPTING_JOBS,		// "printer-is-accepting-jobs"
+  _PAPPL_RA_PRINTER_MORE_INFO,			// "printer-more-info"
+  _PAPPL_RA_PRINTER_RESOLUTION,			// "printer-resolution"
+  _PAPPL_RA_PRINTER_STATE,			// "printer-state"
+  _PAPPL_RA_PRINTER_STATE_CHANGE_DATE_TIME,	// "printer-state-change-date-time"
+  _PAPPL_RA_PRINTER_STATE_CHANGE_TIME,		// "printer-state-change-time"
+  _PAPPL_RA_PRINTER_STATE_MESSAGE,		// "printer-state-message"
+  _PAPPL_RA_PRINTER_STATE_REASONS,		// "printer-state-reasons"
+  _PAPPL_RA_PRINTER_STRINGS_URI,		// "printer-strings-uri"
+  _PAPPL_RA_PRINTER_SUPPLY,			// "printer-supply"
+  _PAPPL_RA_PRINTER_SUPPLY_DESCRIPTION,		// "printer-supply-description"
+  _PAPPL_RA_PRINTER_SUPPLY_INFO_URI,		// "printer-supply-info-uri"
+  _PAPPL_RA_PRINTER_UP_TIME,			// "printer-up-time"
+  _PAPPL_RA_PRINTER_URI_SUPPORTED,		// "printer-uri-supported"
+  _PAPPL_RA_PRINTER_UUID,			// "printer-uuid"
+  _PAPPL_RA_PRINTER_XRI_SUPPORTED,		// "printer-xri-supported"
+  _PAPPL_RA_QUEUED_JOB_COUNT,			// "queued-job-count"
+  _PAPPL_RA_SIDES,				// "sides"
+  _PAPPL_RA_SMI2699_DEVICE_COMMAND_SUPPORTED,	// "smi2699-device-command-supported"
+  _PAPPL_RA_SMI2699_DEVICE_URI_SCHEMES_SUPPORTED, // "smi2699-device-uri-schemes-supported"
+  _PAPPL_RA_SYSTEM_CONFIG_CHANGE_DATE_TIME,	// "system-config-change-date-time"
+  _PAPPL_RA_SYSTEM_CONFIG_CHANGE_TIME,		// "system-config-change-time"
+  _PAPPL_RA_SYSTEM_CONFIGURED_PRINTERS,		// "system-configured-printers"
+  _PAPPL_RA_SYSTEM_CONTACT_COL,			// "system-contact-col"
+  _PAPPL_RA_SYSTEM_CURRENT_TIME,		// "system-current-time"
+  _PAPPL_RA_SYSTEM_DEFAULT_PRINTER_ID,		// "system-default-printer-id"
+  _PAPPL_RA_SYSTEM_FIRMWARE_NAME,		// "system-firmware-name"
+  _PAPPL_RA_SYSTEM_FIRMWARE_PATCHES,		// "system-firmware-patches"
+  _PAPPL_RA_SYSTEM_FIRMWARE_STRING_VERSION,	// "system-firmware-string-version"
+  _PAPPL_RA_SYSTEM_FIRMWARE_VERSION,		// "system-firmware-version"
+  _PAPPL_RA_SYSTEM_GEO_LOCATION,		// "system-geo-location"
+  _PAPPL_RA_SYSTEM_LOCATION,			// "system-location"
+  _PAPPL_RA_SYSTEM_MANDATORY_PRINTER_ATTRIBUTES, // "system-mandatory-printer-attributes"
+  _PAPPL_RA_SYSTEM_ORGANIZATION,		// "system-organization"
+  _PAPPL_RA_SYSTEM_ORGANIZATIONAL_UNIT,		// "system-organizational-unit"
+  _PAPPL_RA_SYSTEM_SETTABLE_ATTRIBUTES_SUPPORTED, // "system-settable-attributes-supported"
+  _PAPPL_RA_SYSTEM_STATE,			// "system-state"
+  _PAPPL_RA_SYSTEM_STATE_CHANGE_DATE_TIME,	// "system-state-change-date-time"
+  _PAPPL_RA_SYSTEM_STATE_CHANGE_TIME,		// "system-state-change-time"
+  _PAPPL_RA_SYSTEM_STATE_REASONS,		// "system-state-reasons"
+  _PAPPL_RA_SYSTEM_UP_TIME,			// "system-up-time"
+  _PAPPL_RA_TIME_AT_COMPLETED,			// "time-at-completed"
+  _PAPPL_RA_TIME_AT_CREATION,			// "time-at-creation"
+  _PAPPL_RA_TIME_AT_PROCESSING,			// "time-at-processing"
+  _PAPPL_RA_URI_AUTHENTICATION_SUPPORTED,	// "uri-authentication-supported"
+  _PAPPL_RA_MAX				// Number of attribute name constants
+} _pappl_raname_t;
+
+typedef struct _pappl_ra_s		// Compiled requested attributes
+{
+  cups_array_t		*array;			// Requested attributes array
+  bool			unknown;		// Were any unknown attributes requested?
+  unsigned		bits[(_PAPPL_RA_NAMES + 31) / 32];
+						// Requested known attributes
+} _pappl_ra_t;
+
 typedef struct _pappl_ipp_filter_s	// Attribute filter
 {
-  cups_array_t		*ra;			// Requested attributes
+  _pappl_ra_t		*ra;			// Requested attributes
   ipp_tag_t		group_tag;		// Group to copy
 } _pappl_ipp_filter_t;
 
@@ -71,10 +180,14 @@ extern size_t		_pappl_strlcpy(char *dst, const char *src, size_t dstsize) _PAPPL
 #  endif // !HAVE_STRLCPY
 extern ipp_t		*_papplContactExport(pappl_contact_t *contact) _PAPPL_PRIVATE;
 extern void		_papplContactImport(ipp_t *col, pappl_contact_t *contact) _PAPPL_PRIVATE;
-extern void		_papplCopyAttributes(ipp_t *to, ipp_t *from, cups_array_t *ra, ipp_tag_t group_tag, int quickcopy) _PAPPL_PRIVATE;
+extern void		_papplCopyAttributes(ipp_t *to, ipp_t *from, _pappl_ra_t *ra, ipp_tag_t group_tag, int quickcopy) _PAPPL_PRIVATE;
 extern unsigned		_papplGetRand(void) _PAPPL_PRIVATE;
+extern unsigned		_papplHashString(const char *s, size_t *slen) _PAPPL_PRIVATE;
 extern const char	*_papplLookupString(unsigned bit, size_t num_strings, const char * const *strings) _PAPPL_PRIVATE;
 extern unsigned		_papplLookupValue(const char *keyword, size_t num_strings, const char * const *strings) _PAPPL_PRIVATE;
+extern _pappl_ra_t	*_papplRACreate(cups_array_t *array) _PAPPL_PRIVATE;
+extern void		_papplRADelete(_pappl_ra_t *ra) _PAPPL_PRIVATE;
+extern bool		_papplRAFind(_pappl_ra_t *ra, const char *name) _PAPPL_PRIVATE;
 
 
 #endif // !_PAPPL_BASE_PRIVATE_H_
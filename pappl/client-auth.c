@@ -38,6 +38,9 @@ typedef struct _pappl_authdata_s	// PAM authentication data
 // Local functions...
 //
 
+static void	add_cached_auth(pappl_client_t *client, const char *username, const char *password, _pappl_auth_t *auth);
+static bool	get_cached_auth(pappl_client_t *client, const char *username, const char *password, _pappl_auth_t *auth);
+static void	hash_auth(pappl_system_t *system, const char *username, const char *password, unsigned char *hash);
 static int	pappl_authenticate_user(pappl_client_t *client, const char *username, const char *password);
 #ifdef HAVE_LIBPAM
 static int	pappl_pam_func(int num_msg, const struct pam_message **msg, struct pam_response **resp, _pappl_authdata_t *data);
@@ -82,12 +85,7 @@ papplClientIsAuthorized(
       int	userlen = sizeof(username);
 					// Length of username:password
       struct passwd *user;		// User information
-      int	num_groups;		// Number of autbenticated groups, if any
-#  ifdef __APPLE__
-      int	groups[32];		// Authenticated groups, if any
-#  else
-      gid_t	groups[32];		// Authenticated groups, if any
-#  endif // __APPLE__
+      _pappl_auth_t auth;		// Authentication information
 
 
       for (authorization += 6; *authorization && isspace(*authorization & 255); authorization ++);
@@ -97,61 +95,67 @@ papplClientIsAuthorized(
       {
 	*password++ = '\0';
 
-        // Authenticate the username and password...
-	if (pappl_authenticate_user(client, username, password))
+        // Use a cached authentication or authenticate the username and
+        // password...
+        if (get_cached_auth(client, username, password, &auth))
+	  papplLogClient(client, PAPPL_LOGLEVEL_INFO, "Authenticated as \"%s\" using cached Basic credentials.", username);
+	else if (pappl_authenticate_user(client, username, password))
 	{
 	  // Get the user information (groups, etc.)
-	  if ((user = getpwnam(username)) != NULL)
+	  if ((user = getpwnam(username)) == NULL)
 	  {
-	    papplLogClient(client, PAPPL_LOGLEVEL_INFO, "Authenticated as \"%s\" using Basic.", username);
-	    strlcpy(client->username, username, sizeof(client->username));
+	    papplLogClient(client, PAPPL_LOGLEVEL_ERROR, "Unable to lookup user '%s'.", username);
+	    return (HTTP_STATUS_SERVER_ERROR);
+	  }
+
+	  papplLogClient(client, PAPPL_LOGLEVEL_INFO, "Authenticated as \"%s\" using Basic.", username);
 
-	    num_groups = (int)(sizeof(groups) / sizeof(groups[0]));
+	  auth.gid        = user->pw_gid;
+	  auth.num_groups = (int)(sizeof(auth.groups) / sizeof(auth.groups[0]));
 
 #ifdef __APPLE__
-	    if (getgrouplist(username, (int)user->pw_gid, groups, &num_groups))
+	  if (getgrouplist(username, (int)user->pw_gid, auth.groups, &auth.num_groups))
 #else
-	    if (getgrouplist(username, user->pw_gid, groups, &num_groups))
+	  if (getgrouplist(username, user->pw_gid, auth.groups, &auth.num_groups))
 #endif // __APPLE__
-	    {
-	      papplLogClient(client, PAPPL_LOGLEVEL_ERROR, "Unable to lookup groups for user '%s': %s", username, strerror(errno));
-	      num_groups = 0;
-	    }
-
-            // Check group membership...
-            if (client->system->admin_gid != -1)
-            {
-              if (user->pw_gid != client->system->admin_gid)
-              {
-                int i;			// Looping var
-
-                for (i = 0; i < num_groups; i ++)
-		{
-		  if (groups[i] == client->system->admin_gid)
-		    break;
-		}
-
-                if (i >= num_groups)
-                {
-                  // Not in the admin group, access is forbidden...
-                  return (HTTP_STATUS_FORBIDDEN);
-		}
-              }
-            }
-
-            // If we get this far, authentication and authorization are good...
-            return (HTTP_STATUS_CONTINUE);
-	  }
-	  else
 	  {
-	    papplLogClient(client, PAPPL_LOGLEVEL_ERROR, "Unable to lookup user '%s'.", username);
-	    return (HTTP_STATUS_SERVER_ERROR);
+	    papplLogClient(client, PAPPL_LOGLEVEL_ERROR, "Unable to lookup groups for user '%s': %s", username, strerror(errno));
+	    auth.num_groups = 0;
 	  }
+
+	  add_cached_auth(client, username, password, &auth);
 	}
 	else
 	{
 	  papplLogClient(client, PAPPL_LOGLEVEL_INFO, "Basic authentication of '%s' failed.", username);
+	  return (HTTP_STATUS_UNAUTHORIZED);
+	}
+
+	strlcpy(client->username, username, sizeof(client->username));
+
+	// Check group membership...
+	if (client->system->admin_gid != -1)
+	{
+	  if (auth.gid != client->system->admin_gid)
+	  {
+	    int i;			// Looping var
+
+	    for (i = 0; i < auth.num_groups; i ++)
+	    {
+	      if (auth.groups[i] == client->system->admin_gid)
+		break;
+	    }
+
+	    if (i >= auth.num_groups)
+	    {
+	      // Not in the admin group, access is forbidden...
+	      return (HTTP_STATUS_FORBIDDEN);
+	    }
+	  }
 	}
+
+	// If we get this far, authentication and authorization are good...
+	return (HTTP_STATUS_CONTINUE);
       }
       else
       {
@@ -171,6 +175,137 @@ papplClientIsAuthorized(
 }
 
 
+//
+// '_papplSystemClearAuthCache()' - Clear all cached authentications.
+//
+
+void
+_papplSystemClearAuthCache(
+    pappl_system_t *system)		// I - System
+{
+  pthread_mutex_lock(&system->auth_mutex);
+  memset(system->auth_cache, 0, sizeof(system->auth_cache));
+  pthread_mutex_unlock(&system->auth_mutex);
+}
+
+
+//
+// 'add_cached_auth()' - Cache a successful authentication.
+//
+// The least recently authenticated entry is replaced when the cache is full.
+//
+
+static void
+add_cached_auth(
+    pappl_client_t *client,		// I - Client
+    const char     *username,		// I - Username string
+    const char     *password,		// I - Password string
+    _pappl_auth_t  *auth)		// I - Authentication information
+{
+  pappl_system_t	*system = client->system;
+					// System
+  _pappl_auth_t		*entry,		// Current cache entry
+			*oldest;	// Oldest cache entry
+  int			i;		// Looping var
+
+
+  hash_auth(system, username, password, auth->hash);
+  auth->expires = time(NULL) + _PAPPL_AUTH_TTL;
+
+  pthread_mutex_lock(&system->auth_mutex);
+
+  for (i = 0, entry = system->auth_cache, oldest = entry; i < _PAPPL_AUTH_CACHE; i ++, entry ++)
+  {
+    if (!memcmp(entry->hash, auth->hash, sizeof(entry->hash)))
+    {
+      oldest = entry;
+      break;
+    }
+    else if (entry->expires < oldest->expires)
+      oldest = entry;
+  }
+
+  *oldest = *auth;
+
+  pthread_mutex_unlock(&system->auth_mutex);
+}
+
+
+//
+// 'get_cached_auth()' - Look up a cached authentication.
+//
+
+static bool				// O - `true` if found, `false` otherwise
+get_cached_auth(
+    pappl_client_t *client,		// I - Client
+    const char     *username,		// I - Username string
+    const char     *password,		// I - Password string
+    _pappl_auth_t  *auth)		// O - Authentication information
+{
+  pappl_system_t	*system = client->system;
+					// System
+  unsigned char		hash[32];	// Hash of credentials
+  _pappl_auth_t		*entry;		// Current cache entry
+  int			i;		// Looping var
+  bool			ret = false;	// Return value
+  size_t		hits,		// Number of cache hits
+			total;		// Number of cache lookups
+  time_t		curtime = time(NULL);
+					// Current time
+
+
+  hash_auth(system, username, password, hash);
+
+  pthread_mutex_lock(&system->auth_mutex);
+
+  for (i = 0, entry = system->auth_cache; i < _PAPPL_AUTH_CACHE; i ++, entry ++)
+  {
+    if (entry->expires > curtime && !memcmp(entry->hash, hash, sizeof(hash)))
+    {
+      *auth = *entry;
+      ret   = true;
+      break;
+    }
+  }
+
+  if (ret)
+    system->auth_hits ++;
+  else
+    system->auth_misses ++;
+
+  hits  = system->auth_hits;
+  total = system->auth_hits + system->auth_misses;
+
+  pthread_mutex_unlock(&system->auth_mutex);
+
+  if ((total % 100) == 0)
+    papplLog(system, PAPPL_LOGLEVEL_INFO, "Authentication cache hit rate is %u%% (%lu of %lu).", (unsigned)(100 * hits / total), (unsigned long)hits, (unsigned long)total);
+
+  return (ret);
+}
+
+
+//
+// 'hash_auth()' - Compute the salted hash of a username and password.
+//
+
+static void
+hash_auth(pappl_system_t *system,	// I - System
+          const char     *username,	// I - Username string
+          const char     *password,	// I - Password string
+          unsigned char  *hash)		// O - SHA-256 hash (32 bytes)
+{
+  char	data[1024];			// Data to hash
+
+
+  snprintf(data, sizeof(data), "%s:%s:%s", system->auth_salt, username, password);
+  cupsHashData("sha2-256", (unsigned char *)data, strlen(data), hash, 32);
+
+  // Don't leave the password on the stack...
+  memset(data, 0, sizeof(data));
+}
+
+
 //
 // 'pappl_authenticate_user()' - Validate a username + password combination.
 //
@@ -29,6 +29,12 @@ struct _pappl_client_s			// Client data
   pappl_system_t	*system;		// Containing system
   int			number;			// Connection number
   pthread_t		thread_id;		// Thread ID
+  struct _pappl_client_s *idle_prev,		// Previous idle client
+			*idle_next;		// Next idle client
+  time_t		idle_time,		// Time connection became idle
+			header_time;		// Deadline for request header fields
+  bool			started;		// Has the first request been received?
+  struct _pappl_addr_s	*address;		// Client address data, if any
   http_t		*http;			// HTTP connection
   ipp_t			*request,		// IPP request
 			*response;		// IPP response
@@ -56,8 +62,10 @@ struct _pappl_client_s			// Client data
 
 extern void		_papplClientCleanTempFiles(pappl_client_t *client) _PAPPL_PRIVATE;
 extern char		*_papplClientCreateTempFile(pappl_client_t *client, const void *data, size_t datasize) _PAPPL_PRIVATE;
+extern const char	*_papplClientGetEncoding(pappl_client_t *client, const char *type, size_t length) _PAPPL_PRIVATE;
 extern bool		_papplClientProcessHTTP(pappl_client_t *client) _PAPPL_PRIVATE;
 extern bool		_papplClientProcessIPP(pappl_client_t *client) _PAPPL_PRIVATE;
+extern bool		_papplClientProcessRequests(pappl_client_t *client) _PAPPL_PRIVATE;
 extern void		*_papplClientRun(pappl_client_t *client) _PAPPL_PRIVATE;
 extern void		_papplClientHTMLInfo(pappl_client_t *client, bool is_form, const char *dns_sd_name, const char *location, const char *geo_location, const char *organization, const char *org_unit, pappl_contact_t *contact);
 extern void		_papplClientHTMLPutLinks(pappl_client_t *client, cups_array_t *links);
@@ -586,11 +586,13 @@ papplClientHTMLHeader(
 {
   pappl_system_t	*system = client->system;
 					// System
+  _pappl_plist_t	*plist;		// Printer list
   pappl_printer_t	*printer;	// Printer
   const char		*name;		// Name for title/header
 
 
-  printer = (pappl_printer_t *)cupsArrayFirst(system->printers);
+  plist   = _papplSystemGetPrinters(system);
+  printer = plist->num_printers > 0 ? plist->printers[0] : NULL;
 
   if ((system->options & PAPPL_SOPTIONS_MULTI_QUEUE) || !printer)
     name = system->name;
@@ -616,7 +618,7 @@ papplClientHTMLHeader(
 		      "        <div class=\"col-12 nav\">\n"
 		      "          <a class=\"btn\" href=\"/\"><img src=\"/navicon.png\"></a>\n");
 
-  pthread_rwlock_rdlock(&system->rwlock);
+  _papplSystemRDLock(system);
 
   _papplClientHTMLPutLinks(client, system->links);
 
@@ -634,6 +636,8 @@ papplClientHTMLHeader(
     pthread_rwlock_unlock(&printer->rwlock);
   }
 
+  _papplSystemReleasePrinters(system, plist);
+
   papplClientHTMLPuts(client,
 		      "        </div>\n"
 		      "      </div>\n"
@@ -20,6 +20,7 @@
 //
 
 static bool	eval_if_modified(pappl_client_t *client, _pappl_resource_t *r);
+static bool	respond_resource(pappl_client_t *client, _pappl_resource_t *resource);
 
 
 //
@@ -63,7 +64,7 @@ papplClientCreate(
 
   client->system = system;
 
-  pthread_rwlock_wrlock(&system->rwlock);
+  _papplSystemWRLock(system);
   client->number = system->next_client ++;
   pthread_rwlock_unlock(&system->rwlock);
 
@@ -77,6 +78,10 @@ papplClientCreate(
 
   httpGetHostname(client->http, client->hostname, sizeof(client->hostname));
 
+  pthread_mutex_lock(&system->clients_mutex);
+  system->num_clients ++;
+  pthread_mutex_unlock(&system->clients_mutex);
+
   papplLogClient(client, PAPPL_LOGLEVEL_INFO, "Accepted connection from '%s'.", client->hostname);
 
   return (client);
@@ -137,6 +142,9 @@ papplClientDelete(
 {
   papplLogClient(client, PAPPL_LOGLEVEL_INFO, "Closing connection from '%s'.", client->hostname);
 
+  // Stop watching for slow request headers...
+  _papplSystemUnwatchClient(client->system, client);
+
   // Flush pending writes before closing...
   httpFlushWrite(client->http);
 
@@ -148,10 +156,50 @@ papplClientDelete(
   ippDelete(client->request);
   ippDelete(client->response);
 
+  pthread_mutex_lock(&client->system->clients_mutex);
+  client->system->num_clients --;
+  if (client->address)
+    client->address->num_clients --;
+  pthread_mutex_unlock(&client->system->clients_mutex);
+
   free(client);
 }
 
 
+//
+// '_papplClientGetEncoding()' - Get the Content-Encoding to use for a response.
+//
+// Responses are compressed when the client supports it, compression is
+// enabled, the response is at least the compression threshold (a length of
+// `0` is used for streamed responses), and the format is not already
+// compressed.
+//
+
+const char *				// O - Content-Encoding or `NULL` for none
+_papplClientGetEncoding(
+    pappl_client_t *client,		// I - Client
+    const char     *type,		// I - MIME media type of response
+    size_t         length)		// I - Length of response or `0` if streamed
+{
+  size_t	threshold;		// Minimum size of compressed responses
+
+
+  // Only compress the bodies of GET and POST responses...
+  if (client->operation != HTTP_STATE_GET && client->operation != HTTP_STATE_POST)
+    return (NULL);
+
+  if ((threshold = papplSystemGetCompressionThreshold(client->system)) == 0 || (length > 0 && length < threshold))
+    return (NULL);
+
+  // Don't compress formats that are already compressed...
+  if (strncmp(type, "text/", 5) && strcmp(type, "application/ipp") && strcmp(type, "application/javascript") && strcmp(type, "application/json") && strcmp(type, "image/svg+xml"))
+    return (NULL);
+
+  // Use the best encoding supported by the client, if any...
+  return (httpGetContentEncoding(client->http));
+}
+
+
 //
 // '_papplClientProcessHTTP()' - Process a HTTP request.
 //
@@ -169,6 +217,7 @@ _papplClientProcessHTTP(
 			hostname[HTTP_MAX_HOST];
 					// Hostname
   int			port;		// Port number
+  int			timeout;	// Seconds until header timeout
   char			*ptr;		// Pointer into string
   _pappl_resource_t	*resource;	// Current resource
   static const char * const http_states[] =
@@ -200,9 +249,19 @@ _papplClientProcessHTTP(
   client->response  = NULL;
   client->operation = HTTP_STATE_WAITING;
 
-  // Read a request from the connection...
+  // Read a request from the connection - clients that don't send the request
+  // line and header fields before the header timeout are disconnected...
+  _papplSystemWatchClient(client->system, client);
+
   while ((http_state = httpReadRequest(client->http, uri, sizeof(uri))) == HTTP_STATE_WAITING)
-    usleep(1);
+  {
+    // Got a blank line, wait for the request line...
+    if ((timeout = (int)(client->header_time - time(NULL))) <= 0 || !httpWait(client->http, 1000 * timeout))
+    {
+      papplLogClient(client, PAPPL_LOGLEVEL_DEBUG, "Timed out waiting for request line.");
+      return (false);
+    }
+  }
 
   // Parse the request line...
   if (http_state == HTTP_STATE_ERROR)
@@ -243,6 +302,8 @@ _papplClientProcessHTTP(
   // Parse incoming parameters until the status changes...
   while ((http_status = httpUpdate(client->http)) == HTTP_STATUS_CONTINUE);
 
+  _papplSystemUnwatchClient(client->system, client);
+
   if (http_status != HTTP_STATUS_OK)
   {
     papplClientRespondHTTP(client, HTTP_STATUS_BAD_REQUEST, NULL, NULL, 0, 0);
@@ -321,6 +382,14 @@ _papplClientProcessHTTP(
     }
   }
 
+  // Apply admission control to web requests - IPP requests are checked once
+  // the operation is known...
+  if ((client->operation != HTTP_STATE_POST || strcmp(httpGetField(client->http, HTTP_FIELD_CONTENT_TYPE), "application/ipp")) && !_papplSystemAdmitRequest(client->system, client, _PAPPL_ADMIT_PRIORITY))
+  {
+    papplClientRespondHTTP(client, HTTP_STATUS_SERVICE_UNAVAILABLE, NULL, NULL, 0, 0);
+    return (false);
+  }
+
   // Handle new transfers...
   switch (client->operation)
   {
@@ -329,63 +398,15 @@ _papplClientProcessHTTP(
 	return (papplClientRespondHTTP(client, HTTP_STATUS_OK, NULL, NULL, 0, 0));
 
     case HTTP_STATE_HEAD :
-        // See if we have a matching resource to serve...
-        if ((resource = _papplSystemFindResource(client->system, client->uri)) != NULL)
-        {
-          if (eval_if_modified(client, resource))
-	    return (papplClientRespondHTTP(client, HTTP_STATUS_OK, NULL, resource->format, resource->last_modified, 0));
-          else
-            return (papplClientRespondHTTP(client, HTTP_STATUS_NOT_MODIFIED, NULL, NULL, resource->last_modified, 0));
-	}
-
-        // If we get here the resource wasn't found...
-	return (papplClientRespondHTTP(client, HTTP_STATUS_NOT_FOUND, NULL, NULL, 0, 0));
-
     case HTTP_STATE_GET :
         // See if we have a matching resource to serve...
         if ((resource = _papplSystemFindResource(client->system, client->uri)) != NULL)
         {
-          if (!eval_if_modified(client, resource))
-          {
-            return (papplClientRespondHTTP(client, HTTP_STATUS_NOT_MODIFIED, NULL, NULL, resource->last_modified, 0));
-          }
-          else if (resource->cb)
-          {
-            // Send output of a callback...
-            return ((resource->cb)(client, resource->cbdata));
-	  }
-	  else if (resource->filename)
-	  {
-	    // Send an external file...
-	    int		fd;		// Resource file descriptor
-	    char	buffer[8192];	// Copy buffer
-	    ssize_t	bytes;		// Bytes read/written
-
-            if ((fd = open(resource->filename, O_RDONLY)) >= 0)
-	    {
-	      if (!papplClientRespondHTTP(client, HTTP_STATUS_OK, NULL, resource->format, resource->last_modified, 0))
-		return (false);
-
-              while ((bytes = read(fd, buffer, sizeof(buffer))) > 0)
-                httpWrite2(client->http, buffer, (size_t)bytes);
-
-	      httpWrite2(client->http, "", 0);
+          bool ret = respond_resource(client, resource);
+					// Return value
 
-	      close(fd);
-
-	      return (true);
-	    }
-	  }
-	  else
-	  {
-	    // Send a static resource file...
-	    if (!papplClientRespondHTTP(client, HTTP_STATUS_OK, NULL, resource->format, resource->last_modified, resource->length))
-	      return (false);
-
-	    httpWrite2(client->http, (const char *)resource->data, resource->length);
-	    httpFlushWrite(client->http);
-	    return (true);
-	  }
+          _papplSystemReleaseResource(client->system, resource);
+          return (ret);
 	}
 
         // If we get here then the resource wasn't found...
@@ -412,17 +433,22 @@ _papplClientProcessHTTP(
 	}
 	else if ((resource = _papplSystemFindResource(client->system, client->uri)) != NULL)
         {
+          bool ret;			// Return value
+
 	  // Serve a matching resource...
           if (resource->cb)
           {
             // Handle a post request through the callback...
-            return ((resource->cb)(client, resource->cbdata));
+            ret = (resource->cb)(client, resource->cbdata);
           }
           else
           {
             // Otherwise you can't POST to a resource...
-	    return (papplClientRespondHTTP(client, HTTP_STATUS_BAD_REQUEST, NULL, NULL, 0, 0));
+	    ret = papplClientRespondHTTP(client, HTTP_STATUS_BAD_REQUEST, NULL, NULL, 0, 0);
           }
+
+          _papplSystemReleaseResource(client->system, resource);
+          return (ret);
         }
         else
         {
@@ -441,6 +467,10 @@ _papplClientProcessHTTP(
 //
 // 'papplClientRespondHTTP()' - Send a HTTP response.
 //
+// Successful responses with a length of `0` are streamed using chunking and
+// are compressed automatically when the client supports it - the response
+// must be finished by calling `httpWrite2(client->http, "", 0)`.
+//
 
 bool					// O - `true` on success, `false` on failure
 papplClientRespondHTTP(
@@ -476,6 +506,10 @@ papplClientRespondHTTP(
   else
     message[0] = '\0';
 
+  // Compress streamed responses when the client supports it...
+  if (code == HTTP_STATUS_OK && type && !content_encoding && !length)
+    content_encoding = _papplClientGetEncoding(client, type, 0);
+
   // Send the HTTP response header...
   httpClearFields(client->http);
   httpSetField(client->http, HTTP_FIELD_SERVER, papplSystemGetServerHeader(client->system));
@@ -534,6 +568,9 @@ papplClientRespondHTTP(
 
     if (ippWrite(client->http, client->response) != IPP_STATE_DATA)
       return (false);
+
+    if (!length && httpWrite2(client->http, "", 0) < 0)
+      return (false);			// Finish compressed/chunked response
   }
 
   return (true);
@@ -583,45 +620,70 @@ papplClientRespondRedirect(
 
 
 //
-// '_papplClientRun()' - Process client requests on a thread.
+// '_papplClientProcessRequests()' - Process pending client requests.
+//
+// This function negotiates TLS on the first request, if needed, and then
+// processes requests until no more buffered request data remains on the
+// connection.  The connection should be closed if `false` is returned.
 //
 
-void *					// O - Exit status
-_papplClientRun(
+bool					// O - `true` to keep the connection, `false` to close it
+_papplClientProcessRequests(
     pappl_client_t *client)		// I - Client
 {
-  int first_time = 1;			// First time request?
+  if (!client->started)
+  {
+    // See if we need to negotiate a TLS connection - the TLS handshake counts
+    // against the header timeout of the first request...
+    char buf[1];			// First byte from client
 
+    _papplSystemWatchClient(client->system, client);
 
-  // Loop until we are out of requests or timeout (30 seconds)...
-  while (httpWait(client->http, 30000))
-  {
-    if (first_time)
+    if (recv(httpGetFd(client->http), buf, 1, MSG_PEEK) == 1 && (!buf[0] || !strchr("DGHOPT", buf[0])))
     {
-      // See if we need to negotiate a TLS connection...
-      char buf[1];			// First byte from client
+      papplLogClient(client, PAPPL_LOGLEVEL_INFO, "Starting HTTPS session.");
 
-      if (recv(httpGetFd(client->http), buf, 1, MSG_PEEK) == 1 && (!buf[0] || !strchr("DGHOPT", buf[0])))
+      if (httpEncryption(client->http, HTTP_ENCRYPTION_ALWAYS))
       {
-        papplLogClient(client, PAPPL_LOGLEVEL_INFO, "Starting HTTPS session.");
-
-	if (httpEncryption(client->http, HTTP_ENCRYPTION_ALWAYS))
-	{
-          papplLogClient(client, PAPPL_LOGLEVEL_ERROR, "Unable to encrypt connection: %s", cupsLastErrorString());
-	  break;
-        }
-
-        papplLogClient(client, PAPPL_LOGLEVEL_INFO, "Connection now encrypted.");
+	papplLogClient(client, PAPPL_LOGLEVEL_ERROR, "Unable to encrypt connection: %s", cupsLastErrorString());
+	return (false);
       }
 
-      first_time = 0;
+      papplLogClient(client, PAPPL_LOGLEVEL_INFO, "Connection now encrypted.");
     }
 
+    client->started = true;
+  }
+
+  // Process requests, including any pipelined requests that are already
+  // buffered...
+  do
+  {
     if (!_papplClientProcessHTTP(client))
-      break;
+      return (false);
 
     _papplClientCleanTempFiles(client);
   }
+  while (httpGetReady(client->http));
+
+  return (true);
+}
+
+
+//
+// '_papplClientRun()' - Process client requests on a thread.
+//
+
+void *					// O - Exit status
+_papplClientRun(
+    pappl_client_t *client)		// I - Client
+{
+  // Loop until we are out of requests or timeout (30 seconds)...
+  while (httpWait(client->http, 30000))
+  {
+    if (!_papplClientProcessRequests(client))
+      break;
+  }
 
   // Close the conection to the client and return...
   papplClientDelete(client);
@@ -686,3 +748,122 @@ eval_if_modified(
   // Return the evaluation based on the last modified date, time, and size...
   return ((size != 0 && size != r->length) || (date != 0 && date < r->last_modified) || (size == 0 && date == 0));
 }
+
+
+//
+// 'respond_resource()' - Respond to a HEAD or GET request for a resource.
+//
+
+static bool				// O - `true` on success, `false` on failure
+respond_resource(
+    pappl_client_t    *client,		// I - Client
+    _pappl_resource_t *resource)	// I - Resource
+{
+  const char	*encoding;		// Content-Encoding for response
+
+
+  if (client->operation == HTTP_STATE_HEAD)
+  {
+    if (eval_if_modified(client, resource))
+      return (papplClientRespondHTTP(client, HTTP_STATUS_OK, NULL, resource->format, resource->last_modified, 0));
+    else
+      return (papplClientRespondHTTP(client, HTTP_STATUS_NOT_MODIFIED, NULL, NULL, resource->last_modified, 0));
+  }
+
+  if (!eval_if_modified(client, resource))
+  {
+    return (papplClientRespondHTTP(client, HTTP_STATUS_NOT_MODIFIED, NULL, NULL, resource->last_modified, 0));
+  }
+  else if (resource->cb)
+  {
+    // Send output of a callback...
+    return ((resource->cb)(client, resource->cbdata));
+  }
+  else if (resource->filename)
+  {
+    // Send an external file...
+    int		fd;		// Resource file descriptor
+    char	buffer[8192];	// Copy buffer
+    ssize_t	bytes;		// Bytes read/written
+    size_t	offset;		// Offset in file
+    struct stat	fileinfo,	// File information
+		fdinfo;		// Information for open file
+
+    if (stat(resource->filename, &fileinfo))
+    {
+      // File has been removed...
+      papplLogClient(client, PAPPL_LOGLEVEL_ERROR, "Unable to access '%s': %s", resource->filename, strerror(errno));
+    }
+    else if (resource->fd >= 0 && !fstat(resource->fd, &fdinfo) && fdinfo.st_dev == fileinfo.st_dev && fdinfo.st_ino == fileinfo.st_ino && fileinfo.st_mtime == resource->last_modified && (size_t)fileinfo.st_size == resource->length)
+    {
+      // Send the unchanged file from the file descriptor that was opened when
+      // the resource was added...
+      encoding = _papplClientGetEncoding(client, resource->format, resource->length);
+
+      if (!papplClientRespondHTTP(client, HTTP_STATUS_OK, encoding, resource->format, resource->last_modified, encoding ? 0 : resource->length))
+	return (false);
+
+      for (offset = 0; offset < resource->length; offset += (size_t)bytes)
+      {
+        if ((bytes = pread(resource->fd, buffer, resource->length - offset < sizeof(buffer) ? resource->length - offset : sizeof(buffer), (off_t)offset)) <= 0)
+        {
+          // The file was truncated after it was checked, so the response
+          // can't be finished...
+          papplLogClient(client, PAPPL_LOGLEVEL_ERROR, "Unable to read '%s': %s", resource->filename, bytes < 0 ? strerror(errno) : "Short read");
+          return (false);
+        }
+
+	httpWrite2(client->http, buffer, (size_t)bytes);
+      }
+
+      if (encoding)
+	httpWrite2(client->http, "", 0);
+      else
+	httpFlushWrite(client->http);
+
+      return (true);
+    }
+    else if ((fd = open(resource->filename, O_RDONLY | O_CLOEXEC)) >= 0)
+    {
+      // File has changed or been replaced, copy the current contents...
+      if (!papplClientRespondHTTP(client, HTTP_STATUS_OK, NULL, resource->format, fileinfo.st_mtime, 0))
+      {
+        close(fd);
+	return (false);
+      }
+
+      while ((bytes = read(fd, buffer, sizeof(buffer))) > 0)
+	httpWrite2(client->http, buffer, (size_t)bytes);
+
+      httpWrite2(client->http, "", 0);
+
+      close(fd);
+
+      return (true);
+    }
+  }
+  else
+  {
+    // Send a static resource file...
+    if ((encoding = _papplClientGetEncoding(client, resource->format, resource->length)) != NULL)
+    {
+      if (!papplClientRespondHTTP(client, HTTP_STATUS_OK, encoding, resource->format, resource->last_modified, 0))
+	return (false);
+
+      httpWrite2(client->http, (const char *)resource->data, resource->length);
+      httpWrite2(client->http, "", 0);
+    }
+    else
+    {
+      if (!papplClientRespondHTTP(client, HTTP_STATUS_OK, NULL, resource->format, resource->last_modified, resource->length))
+	return (false);
+
+      httpWrite2(client->http, (const char *)resource->data, resource->length);
+      httpFlushWrite(client->http);
+    }
+    return (true);
+  }
+
+  // If we get here then the resource wasn't found...
+  return (papplClientRespondHTTP(client, HTTP_STATUS_NOT_FOUND, NULL, NULL, 0, 0));
+}
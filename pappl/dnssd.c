@@ -435,6 +435,7 @@ _papplPrinterRegisterDNSSDNoLock(
 
     free(printer->dns_sd_name);
     printer->dns_sd_name = strdup(new_dns_sd_name);
+    printer->config_generation ++;
 
     papplLogPrinter(printer, PAPPL_LOGLEVEL_INFO, "DNS-SD name collision, trying new DNS-SD service name '%s'.", printer->dns_sd_name);
 
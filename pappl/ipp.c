@@ -31,12 +31,13 @@ typedef struct pappl_attr_s		// Input attribute structure
 // Local functions...
 //
 
-static void		copy_job_attributes(pappl_client_t *client, pappl_job_t *job, cups_array_t *ra);
-static void		copy_printer_attributes(pappl_client_t *client, pappl_printer_t *printer, cups_array_t *ra);
-static void		copy_printer_state(ipp_t *ipp, pappl_printer_t *printer, cups_array_t *ra);
+static void		copy_job_attributes(pappl_client_t *client, pappl_job_t *job, _pappl_ra_t *ra);
+static void		copy_printer_attributes(pappl_client_t *client, pappl_printer_t *printer, _pappl_ra_t *ra);
+static void		copy_printer_state(ipp_t *ipp, pappl_printer_t *printer, _pappl_ra_t *ra);
 static void		copy_printer_xri(pappl_client_t *client, ipp_t *ipp, pappl_printer_t *printer);
 static void		finish_document_data(pappl_client_t *client, pappl_job_t *job);
 static void		flush_document_data(pappl_client_t *client);
+static _pappl_admit_t	get_admit(ipp_op_t op);
 static bool		have_document_data(pappl_client_t *client);
 
 static void		ipp_cancel_job(pappl_client_t *client);
@@ -60,6 +61,8 @@ static void		ipp_set_system_attributes(pappl_client_t *client);
 static void		ipp_shutdown_all_printers(pappl_client_t *client);
 static void		ipp_validate_job(pappl_client_t *client);
 
+static ipp_t		*make_printer_attrs(pappl_printer_t *printer);
+
 static void		respond_unsupported(pappl_client_t *client, ipp_attribute_t *attr);
 
 static int		set_printer_attributes(pappl_client_t *client, pappl_printer_t *printer);
@@ -86,6 +89,7 @@ _papplClientProcessIPP(
   const char		*name;		// Name of attribute
   bool			printer_op = true;
 					// Printer operation?
+  const char		*encoding;	// Content-Encoding for response
 
 
   // First build an empty response message for this request...
@@ -98,7 +102,12 @@ _papplClientProcessIPP(
 
   papplLogAttributes(client, ippOpString(op), client->request, false);
 
-  if (major < 1 || major > 2)
+  if (!_papplSystemAdmitRequest(client->system, client, get_admit(op)))
+  {
+    // Too many requests, have the client try again later...
+    papplClientRespondIPP(client, IPP_STATUS_ERROR_BUSY, "Too many requests.");
+  }
+  else if (major < 1 || major > 2)
   {
     // Return an error, since we only support IPP 1.x and 2.x.
     papplClientRespondIPP(client, IPP_STATUS_ERROR_VERSION_NOT_SUPPORTED, "Bad request version number %d.%d.", major, minor);
@@ -340,7 +349,10 @@ _papplClientProcessIPP(
   if (httpGetState(client->http) != HTTP_STATE_POST_SEND)
     flush_document_data(client);	// Flush trailing (junk) data
 
-  return (papplClientRespondHTTP(client, HTTP_STATUS_OK, NULL, "application/ipp", 0, ippLength(client->response)));
+  if ((encoding = _papplClientGetEncoding(client, "application/ipp", ippLength(client->response))) != NULL)
+    return (papplClientRespondHTTP(client, HTTP_STATUS_OK, encoding, "application/ipp", 0, 0));
+  else
+    return (papplClientRespondHTTP(client, HTTP_STATUS_OK, NULL, "application/ipp", 0, ippLength(client->response)));
 }
 
 
@@ -390,11 +402,11 @@ static void
 copy_job_attributes(
     pappl_client_t *client,		// I - Client
     pappl_job_t    *job,		// I - Job
-    cups_array_t  *ra)			// I - requested-attributes
+    _pappl_ra_t    *ra)			// I - requested-attributes
 {
   _papplCopyAttributes(client->response, job->attrs, ra, IPP_TAG_JOB, 0);
 
-  if (!ra || cupsArrayFind(ra, "date-time-at-completed"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_DATE_TIME_AT_COMPLETED))
   {
     if (job->completed)
       ippAddDate(client->response, IPP_TAG_JOB, "date-time-at-completed", ippTimeToDate(job->completed));
@@ -402,7 +414,7 @@ copy_job_attributes(
       ippAddOutOfBand(client->response, IPP_TAG_JOB, IPP_TAG_NOVALUE, "date-time-at-completed");
   }
 
-  if (!ra || cupsArrayFind(ra, "date-time-at-processing"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_DATE_TIME_AT_PROCESSING))
   {
     if (job->processing)
       ippAddDate(client->response, IPP_TAG_JOB, "date-time-at-processing", ippTimeToDate(job->processing));
@@ -410,19 +422,19 @@ copy_job_attributes(
       ippAddOutOfBand(client->response, IPP_TAG_JOB, IPP_TAG_NOVALUE, "date-time-at-processing");
   }
 
-  if (!ra || cupsArrayFind(ra, "job-impressions"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_JOB_IMPRESSIONS))
     ippAddInteger(client->response, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-impressions", job->impressions);
 
-  if (!ra || cupsArrayFind(ra, "job-impressions-completed"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_JOB_IMPRESSIONS_COMPLETED))
     ippAddInteger(client->response, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-impressions-completed", job->impcompleted);
 
-  if (!ra || cupsArrayFind(ra, "job-printer-up-time"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_JOB_PRINTER_UP_TIME))
     ippAddInteger(client->response, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-printer-up-time", (int)(time(NULL) - client->printer->start_time));
 
-  if (!ra || cupsArrayFind(ra, "job-state"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_JOB_STATE))
     ippAddInteger(client->response, IPP_TAG_JOB, IPP_TAG_ENUM, "job-state", (int)job->state);
 
-  if (!ra || cupsArrayFind(ra, "job-state-message"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_JOB_STATE_MESSAGE))
   {
     if (job->message)
     {
@@ -471,7 +483,7 @@ copy_job_attributes(
     }
   }
 
-  if (!ra || cupsArrayFind(ra, "job-state-reasons"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_JOB_STATE_REASONS))
   {
     if (job->state_reasons)
     {
@@ -528,10 +540,10 @@ copy_job_attributes(
     }
   }
 
-  if (!ra || cupsArrayFind(ra, "time-at-completed"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_TIME_AT_COMPLETED))
     ippAddInteger(client->response, IPP_TAG_JOB, job->completed ? IPP_TAG_INTEGER : IPP_TAG_NOVALUE, "time-at-completed", (int)(job->completed - client->printer->start_time));
 
-  if (!ra || cupsArrayFind(ra, "time-at-processing"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_TIME_AT_PROCESSING))
     ippAddInteger(client->response, IPP_TAG_JOB, job->processing ? IPP_TAG_INTEGER : IPP_TAG_NOVALUE, "time-at-processing", (int)(job->processing - client->printer->start_time));
 }
 
@@ -539,52 +551,57 @@ copy_job_attributes(
 //
 // 'copy_printer_attributes()' - Copy printer attributes to a response...
 //
+// The attributes that only change with the printer configuration are cached
+// and rebuilt when the printer configuration generation changes.
+//
 
 static void
 copy_printer_attributes(
     pappl_client_t  *client,		// I - Client
     pappl_printer_t *printer,		// I - Printer
-    cups_array_t     *ra)		// I - Requested attributes
+    _pappl_ra_t      *ra)		// I - Requested attributes
 {
-  int		i,			// Looping var
-		num_values;		// Number of values
-  unsigned	bit;			// Current bit value
+  int		i;			// Looping var
   const char	*svalues[100];		// String values
   int		ivalues[100];		// Integer values
-  pappl_pdriver_data_t	*data = &printer->driver_data;
-					// Driver data
+  size_t	generation = printer->config_generation;
+					// Current configuration generation
 
 
   _papplCopyAttributes(client->response, printer->attrs, ra, IPP_TAG_ZERO, IPP_TAG_CUPS_CONST);
   _papplCopyAttributes(client->response, printer->driver_attrs, ra, IPP_TAG_ZERO, IPP_TAG_CUPS_CONST);
-  copy_printer_state(client->response, printer, ra);
 
-  if (!ra || cupsArrayFind(ra, "identify-actions-default"))
+  // Copy the cached configuration attributes, rebuilding them if the
+  // configuration has changed since they were cached...
+  pthread_rwlock_rdlock(&printer->attrs_rwlock);
+
+  if (!printer->attrs_cache || printer->attrs_generation != generation)
   {
-    for (num_values = 0, bit = PAPPL_IDENTIFY_ACTIONS_DISPLAY; bit <= PAPPL_IDENTIFY_ACTIONS_SPEAK; bit *= 2)
+    pthread_rwlock_unlock(&printer->attrs_rwlock);
+    pthread_rwlock_wrlock(&printer->attrs_rwlock);
+
+    if (!printer->attrs_cache || printer->attrs_generation != generation)
     {
-      if (data->identify_default & bit)
-	svalues[num_values ++] = _papplIdentifyActionsString(bit);
-    }
+      ippDelete(printer->attrs_cache);
 
-    if (num_values > 0)
-      ippAddStrings(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "identify-actions-default", num_values, NULL, svalues);
-    else
-      ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "identify-actions-default", NULL, "none");
+      printer->attrs_cache      = make_printer_attrs(printer);
+      printer->attrs_generation = generation;
+    }
   }
 
-  if ((!ra || cupsArrayFind(ra, "label-mode-configured")) && data->mode_configured)
-    ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "label-mode-configured", NULL, _papplLabelModeString(data->mode_configured));
+  _papplCopyAttributes(client->response, printer->attrs_cache, ra, IPP_TAG_ZERO, 0);
 
-  if ((!ra || cupsArrayFind(ra, "label-tear-offset-configured")) && data->tear_offset_supported[1] > 0)
-    ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "label-tear-offset-configured", data->tear_offset_configured);
+  pthread_rwlock_unlock(&printer->attrs_rwlock);
+
+  // Then add the attributes that change all the time or depend on the client...
+  copy_printer_state(client->response, printer, ra);
 
   if (printer->num_supply > 0)
   {
     pappl_supply_t *supply = printer->supply;
 					// Supply values...
 
-    if (!ra || cupsArrayFind(ra, "marker-colors"))
+    if (_PAPPL_REQUESTED(ra, _PAPPL_RA_MARKER_COLORS))
     {
       for (i = 0; i < printer->num_supply; i ++)
         svalues[i] = _papplMarkerColorString(supply[i].color);
@@ -592,7 +609,7 @@ copy_printer_attributes(
       ippAddStrings(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_NAME), "marker-colors", printer->num_supply, NULL, svalues);
     }
 
-    if (!ra || cupsArrayFind(ra, "marker-high-levels"))
+    if (_PAPPL_REQUESTED(ra, _PAPPL_RA_MARKER_HIGH_LEVELS))
     {
       for (i = 0; i < printer->num_supply; i ++)
         ivalues[i] = supply[i].is_consumed ? 100 : 90;
@@ -600,7 +617,7 @@ copy_printer_attributes(
       ippAddIntegers(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "marker-high-levels", printer->num_supply, ivalues);
     }
 
-    if (!ra || cupsArrayFind(ra, "marker-levels"))
+    if (_PAPPL_REQUESTED(ra, _PAPPL_RA_MARKER_LEVELS))
     {
       for (i = 0; i < printer->num_supply; i ++)
         ivalues[i] = supply[i].level;
@@ -608,7 +625,7 @@ copy_printer_attributes(
       ippAddIntegers(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "marker-levels", printer->num_supply, ivalues);
     }
 
-    if (!ra || cupsArrayFind(ra, "marker-low-levels"))
+    if (_PAPPL_REQUESTED(ra, _PAPPL_RA_MARKER_LOW_LEVELS))
     {
       for (i = 0; i < printer->num_supply; i ++)
         ivalues[i] = supply[i].is_consumed ? 10 : 0;
@@ -616,7 +633,7 @@ copy_printer_attributes(
       ippAddIntegers(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "marker-low-levels", printer->num_supply, ivalues);
     }
 
-    if (!ra || cupsArrayFind(ra, "marker-names"))
+    if (_PAPPL_REQUESTED(ra, _PAPPL_RA_MARKER_NAMES))
     {
       for (i = 0; i < printer->num_supply; i ++)
         svalues[i] = supply[i].description;
@@ -624,7 +641,7 @@ copy_printer_attributes(
       ippAddStrings(client->response, IPP_TAG_PRINTER, IPP_TAG_NAME, "marker-names", printer->num_supply, NULL, svalues);
     }
 
-    if (!ra || cupsArrayFind(ra, "marker-types"))
+    if (_PAPPL_REQUESTED(ra, _PAPPL_RA_MARKER_TYPES))
     {
       for (i = 0; i < printer->num_supply; i ++)
         svalues[i] = _papplMarkerTypeString(supply[i].type);
@@ -633,172 +650,12 @@ copy_printer_attributes(
     }
   }
 
-  if ((!ra || cupsArrayFind(ra, "media-col-default")) && data->media_default.size_name[0])
-  {
-    ipp_t *col = _papplMediaColExport(&printer->driver_data, &data->media_default, 0);
-					// Collection value
-
-    ippAddCollection(client->response, IPP_TAG_PRINTER, "media-col-default", col);
-    ippDelete(col);
-  }
-
-  if (!ra || cupsArrayFind(ra, "media-col-ready"))
-  {
-    int			i, j,		// Looping vars
-			count;		// Number of values
-    ipp_t		*col;		// Collection value
-    ipp_attribute_t	*attr;		// media-col-ready attribute
-    pappl_media_col_t	media;		// Current media...
-
-    for (i = 0, count = 0; i < data->num_source; i ++)
-    {
-      if (data->media_ready[i].size_name[0])
-        count ++;
-    }
-
-    if (data->borderless && (data->bottom_top != 0 || data->left_right != 0))
-      count *= 2;			// Need to report ready media for borderless, too...
-
-    if (count > 0)
-    {
-      attr = ippAddCollections(client->response, IPP_TAG_PRINTER, "media-col-ready", count, NULL);
-
-      for (i = 0, j = 0; i < data->num_source && j < count; i ++)
-      {
-	if (data->media_ready[i].size_name[0])
-	{
-          if (data->borderless && (data->bottom_top != 0 || data->left_right != 0))
-	  {
-	    // Report both bordered and borderless media-col values...
-	    media = data->media_ready[i];
-
-	    media.bottom_margin = media.top_margin   = data->bottom_top;
-	    media.left_margin   = media.right_margin = data->left_right;
-	    col = _papplMediaColExport(&printer->driver_data, &media, 0);
-	    ippSetCollection(client->response, &attr, j ++, col);
-	    ippDelete(col);
-
-	    media.bottom_margin = media.top_margin   = 0;
-	    media.left_margin   = media.right_margin = 0;
-	    col = _papplMediaColExport(&printer->driver_data, &media, 0);
-	    ippSetCollection(client->response, &attr, j ++, col);
-	    ippDelete(col);
-	  }
-	  else
-	  {
-	    // Just report the single media-col value...
-	    col = _papplMediaColExport(&printer->driver_data, data->media_ready + i, 0);
-	    ippSetCollection(client->response, &attr, j ++, col);
-	    ippDelete(col);
-	  }
-	}
-      }
-    }
-  }
-
-  if ((!ra || cupsArrayFind(ra, "media-default")) && data->media_default.size_name[0])
-    ippAddString(client->response, IPP_TAG_PRINTER, IPP_TAG_KEYWORD, "media-default", NULL, data->media_default.size_name);
-
-  if (!ra || cupsArrayFind(ra, "media-ready"))
-  {
-    int			i, j,		// Looping vars
-			count;		// Number of values
-    ipp_attribute_t	*attr;		// media-col-ready attribute
-
-    for (i = 0, count = 0; i < data->num_source; i ++)
-    {
-      if (data->media_ready[i].size_name[0])
-        count ++;
-    }
-
-    if (count > 0)
-    {
-      attr = ippAddStrings(client->response, IPP_TAG_PRINTER, IPP_TAG_KEYWORD, "media-ready", count, NULL, NULL);
-
-      for (i = 0, j = 0; i < data->num_source && j < count; i ++)
-      {
-	if (data->media_ready[i].size_name[0])
-	  ippSetString(client->response, &attr, j ++, data->media_ready[i].size_name);
-      }
-    }
-  }
-
-  if (!ra || cupsArrayFind(ra, "multiple-document-handling-default"))
-    ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "multiple-document-handling-default", NULL, "separate-documents-collated-copies");
-
-  if (!ra || cupsArrayFind(ra, "orientation-requested-default"))
-    ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_ENUM, "orientation-requested-default", data->orient_default);
-
-  if (!ra || cupsArrayFind(ra, "output-bin-default"))
-  {
-    if (data->num_bin > 0)
-      ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "output-bin-default", NULL, data->bin[data->bin_default]);
-    else if (data->output_face_up)
-      ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "output-bin-default", NULL, "face-up");
-    else
-      ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "output-bin-default", NULL, "face-down");
-  }
-
-  if ((!ra || cupsArrayFind(ra, "print-color-mode-default")) && data->color_default)
-    ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "print-color-mode-default", NULL, _papplColorModeString(data->color_default));
-
-  if (!ra || cupsArrayFind(ra, "print-content-optimize-default"))
-  {
-    if (data->content_default)
-      ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "print-content-optimize-default", NULL, _papplContentString(data->content_default));
-    else
-      ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "print-content-optimize-default", NULL, "auto");
-  }
-
-  if (!ra || cupsArrayFind(ra, "print-quality-default"))
-  {
-    if (data->quality_default)
-      ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_ENUM, "print-quality-default", data->quality_default);
-    else
-      ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_ENUM, "print-quality-default", IPP_QUALITY_NORMAL);
-  }
-
-  if (!ra || cupsArrayFind(ra, "print-scaling-default"))
-  {
-    if (data->scaling_default)
-      ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "print-scaling-default", NULL, _papplScalingString(data->scaling_default));
-    else
-      ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "print-scaling-default", NULL, "auto");
-  }
-
-  if (!ra || cupsArrayFind(ra, "printer-config-change-date-time"))
-    ippAddDate(client->response, IPP_TAG_PRINTER, "printer-config-change-date-time", ippTimeToDate(printer->config_time));
-
-  if (!ra || cupsArrayFind(ra, "printer-config-change-time"))
-    ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "printer-config-change-time", (int)(printer->config_time - printer->start_time));
-
-  if (!ra || cupsArrayFind(ra, "printer-contact-col"))
-  {
-    ipp_t *col = _papplContactExport(&printer->contact);
-    ippAddCollection(client->response, IPP_TAG_PRINTER, "printer-contact-col", col);
-    ippDelete(col);
-  }
-
-  if (!ra || cupsArrayFind(ra, "printer-current-time"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_PRINTER_CURRENT_TIME))
     ippAddDate(client->response, IPP_TAG_PRINTER, "printer-current-time", ippTimeToDate(time(NULL)));
 
-  if ((!ra || cupsArrayFind(ra, "printer-darkness-configured")) && data->darkness_supported > 0)
-    ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "printer-darkness-configured", data->darkness_configured);
-
   _papplSystemExportVersions(client->system, client->response, IPP_TAG_PRINTER, ra);
 
-  if (!ra || cupsArrayFind(ra, "printer-dns-sd-name"))
-    ippAddString(client->response, IPP_TAG_PRINTER, IPP_TAG_NAME, "printer-dns-sd-name", NULL, printer->dns_sd_name ? printer->dns_sd_name : "");
-
-  if (!ra || cupsArrayFind(ra, "printer-geo-location"))
-  {
-    if (printer->geo_location)
-      ippAddString(client->response, IPP_TAG_PRINTER, IPP_TAG_URI, "printer-geo-location", NULL, printer->geo_location);
-    else
-      ippAddOutOfBand(client->response, IPP_TAG_PRINTER, IPP_TAG_UNKNOWN, "printer-geo-location");
-  }
-
-  if (!ra || cupsArrayFind(ra, "printer-icons"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_PRINTER_ICONS))
   {
     char	uris[3][1024];		// Buffers for URIs
     const char	*values[3];		// Values for attribute
@@ -814,47 +671,13 @@ copy_printer_attributes(
     ippAddStrings(client->response, IPP_TAG_PRINTER, IPP_TAG_URI, "printer-icons", 3, NULL, values);
   }
 
-  if (!ra || cupsArrayFind(ra, "printer-impressions-completed"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_PRINTER_IMPRESSIONS_COMPLETED))
     ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "printer-impressions-completed", printer->impcompleted);
 
-  if (!ra || cupsArrayFind(ra, "printer-input-tray"))
-  {
-    int			i;		// Looping var
-    ipp_attribute_t	*attr = NULL;	// "printer-input-tray" attribute
-    char		value[256];	// Value for current tray
-    pappl_media_col_t	*media;		// Media in the tray
-
-    for (i = 0, media = data->media_ready; i < data->num_source; i ++, media ++)
-    {
-      const char	*type;		// Tray type
-
-      if (!strcmp(data->source[i], "manual"))
-        type = "sheetFeedManual";
-      else if (!strcmp(data->source[i], "by-pass-tray"))
-        type = "sheetFeedAutoNonRemovableTray";
-      else
-        type = "sheetFeedAutoRemovableTray";
-
-      snprintf(value, sizeof(value), "type=%s;mediafeed=%d;mediaxfeed=%d;maxcapacity=%d;level=-2;status=0;name=%s;", type, media->size_length, media->size_width, !strcmp(media->source, "manual") ? 1 : -2, media->source);
-
-      if (attr)
-        ippSetOctetString(client->response, &attr, ippGetCount(attr), value, (int)strlen(value));
-      else
-        attr = ippAddOctetString(client->response, IPP_TAG_PRINTER, "printer-input-tray", value, (int)strlen(value));
-    }
-
-    // The "auto" tray is a dummy entry...
-    strlcpy(value, "type=other;mediafeed=0;mediaxfeed=0;maxcapacity=-2;level=-2;status=0;name=auto;", sizeof(value));
-    ippSetOctetString(client->response, &attr, ippGetCount(attr), value, (int)strlen(value));
-  }
-
-  if (!ra || cupsArrayFind(ra, "printer-is-accepting-jobs"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_PRINTER_IS_ACCEPTING_JOBS))
     ippAddBoolean(client->response, IPP_TAG_PRINTER, "printer-is-accepting-jobs", !printer->system->shutdown_time);
 
-  if (!ra || cupsArrayFind(ra, "printer-location"))
-    ippAddString(client->response, IPP_TAG_PRINTER, IPP_TAG_TEXT, "printer-location", NULL, printer->location ? printer->location : "");
-
-  if (!ra || cupsArrayFind(ra, "printer-more-info"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_PRINTER_MORE_INFO))
   {
     char	uri[1024];		// URI value
 
@@ -862,25 +685,13 @@ copy_printer_attributes(
     ippAddString(client->response, IPP_TAG_PRINTER, IPP_TAG_URI, "printer-more-info", NULL, uri);
   }
 
-  if (!ra || cupsArrayFind(ra, "printer-organization"))
-    ippAddString(client->response, IPP_TAG_PRINTER, IPP_TAG_TEXT, "printer-organization", NULL, printer->organization ? printer->organization : "");
-
-  if (!ra || cupsArrayFind(ra, "printer-organizational-unit"))
-    ippAddString(client->response, IPP_TAG_PRINTER, IPP_TAG_TEXT, "printer-organizational-unit", NULL, printer->org_unit ? printer->org_unit : "");
-
-  if (!ra || cupsArrayFind(ra, "printer-resolution-default"))
-    ippAddResolution(client->response, IPP_TAG_PRINTER, "printer-resolution-default", IPP_RES_PER_INCH, data->x_default, data->y_default);
-
-  if (!ra || cupsArrayFind(ra, "printer-speed-default"))
-    ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "printer-speed-default", data->speed_default);
-
-  if (!ra || cupsArrayFind(ra, "printer-state-change-date-time"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_PRINTER_STATE_CHANGE_DATE_TIME))
     ippAddDate(client->response, IPP_TAG_PRINTER, "printer-state-change-date-time", ippTimeToDate(printer->state_time));
 
-  if (!ra || cupsArrayFind(ra, "printer-state-change-time"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_PRINTER_STATE_CHANGE_TIME))
     ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "printer-state-change-time", (int)(printer->state_time - printer->start_time));
 
-  if (!ra || cupsArrayFind(ra, "printer-strings-uri"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_PRINTER_STRINGS_URI))
   {
     const char	*lang = ippGetString(ippFindAttribute(client->request, "attributes-natural-language", IPP_TAG_LANGUAGE), 0, NULL);
 					// Language
@@ -901,7 +712,7 @@ copy_printer_attributes(
     pappl_supply_t	 *supply = printer->supply;
 					// Supply values...
 
-    if (!ra || cupsArrayFind(ra, "printer-supply"))
+    if (_PAPPL_REQUESTED(ra, _PAPPL_RA_PRINTER_SUPPLY))
     {
       char		value[256];	// "printer-supply" value
       ipp_attribute_t	*attr = NULL;	// "printer-supply" attribute
@@ -917,7 +728,7 @@ copy_printer_attributes(
       }
     }
 
-    if (!ra || cupsArrayFind(ra, "printer-supply-description"))
+    if (_PAPPL_REQUESTED(ra, _PAPPL_RA_PRINTER_SUPPLY_DESCRIPTION))
     {
       for (i = 0; i < printer->num_supply; i ++)
         svalues[i] = supply[i].description;
@@ -926,7 +737,7 @@ copy_printer_attributes(
     }
   }
 
-  if (!ra || cupsArrayFind(ra, "printer-supply-info-uri"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_PRINTER_SUPPLY_INFO_URI))
   {
     char	uri[1024];		// URI value
 
@@ -934,10 +745,10 @@ copy_printer_attributes(
     ippAddString(client->response, IPP_TAG_PRINTER, IPP_TAG_URI, "printer-supply-info-uri", NULL, uri);
   }
 
-  if (!ra || cupsArrayFind(ra, "printer-up-time"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_PRINTER_UP_TIME))
     ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "printer-up-time", (int)(time(NULL) - printer->start_time));
 
-  if (!ra || cupsArrayFind(ra, "printer-uri-supported"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_PRINTER_URI_SUPPORTED))
   {
     char	uris[2][1024];		// Buffers for URIs
     int		num_values = 0;		// Number of values
@@ -957,21 +768,13 @@ copy_printer_attributes(
     ippAddStrings(client->response, IPP_TAG_PRINTER, IPP_TAG_URI, "printer-uri-supported", num_values, NULL, values);
   }
 
-  if (!ra || cupsArrayFind(ra, "printer-xri-supported"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_PRINTER_XRI_SUPPORTED))
     copy_printer_xri(client, client->response, printer);
 
-  if (!ra || cupsArrayFind(ra, "queued-job-count"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_QUEUED_JOB_COUNT))
     ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "queued-job-count", cupsArrayCount(printer->active_jobs));
 
-  if (!ra || cupsArrayFind(ra, "sides-default"))
-  {
-    if (data->sides_default)
-      ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "sides-default", NULL, _papplSidesString(data->sides_default));
-    else
-      ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "sides-default", NULL, "one-sided");
-  }
-
-  if (!ra || cupsArrayFind(ra, "uri-authentication-supported"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_URI_AUTHENTICATION_SUPPORTED))
   {
     // For each supported printer-uri value, report whether authentication is
     // supported.  Since we only support authentication over a secure (TLS)
@@ -1016,19 +819,19 @@ static void
 copy_printer_state(
     ipp_t            *ipp,		// I - IPP message
     pappl_printer_t *printer,		// I - Printer
-    cups_array_t     *ra)		// I - Requested attributes
+    _pappl_ra_t      *ra)		// I - Requested attributes
 {
-  if (!ra || cupsArrayFind(ra, "printer-state"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_PRINTER_STATE))
     ippAddInteger(ipp, IPP_TAG_PRINTER, IPP_TAG_ENUM, "printer-state", (int)printer->state);
 
-  if (!ra || cupsArrayFind(ra, "printer-state-message"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_PRINTER_STATE_MESSAGE))
   {
     static const char * const messages[] = { "Idle.", "Printing.", "Stopped." };
 
     ippAddString(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_TEXT), "printer-state-message", NULL, messages[printer->state - IPP_PSTATE_IDLE]);
   }
 
-  if (!ra || cupsArrayFind(ra, "printer-state-reasons"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_PRINTER_STATE_REASONS))
   {
     if (printer->state_reasons == PAPPL_PREASON_NONE)
     {
@@ -1123,25 +926,44 @@ finish_document_data(
   char			filename[1024],	// Filename buffer
 			buffer[4096];	// Copy buffer
   ssize_t		bytes;		// Bytes read
-  cups_array_t		*ra;		// Attributes to send in response
+  cups_array_t		*array;		// Attributes to send in response
+  _pappl_ra_t		*ra;		// Compiled attributes to send
+  bool			idle;		// Is the printer idle?
 
 
-  // If we have a PWG or Apple raster file, process it directly or return
+  // If we have a PWG or Apple raster file, process it directly when the
+  // printer is idle.  Otherwise spool it behind the current job or return
   // server-error-busy...
   if (!strcmp(job->format, "image/pwg-raster") || !strcmp(job->format, "image/urf"))
   {
-    if (job->printer->processing_job)
+    // Claim the printer while holding the lock so that no other job can be
+    // started before this one...
+    pthread_rwlock_wrlock(&job->printer->rwlock);
+
+    idle = !job->printer->processing_job;
+
+    if (idle)
+      job->printer->processing_job = job;
+
+    pthread_rwlock_unlock(&job->printer->rwlock);
+
+    if (idle)
+    {
+      job->state = IPP_JSTATE_PENDING;
+
+      _papplJobProcessRaster(job, client);
+
+      goto complete_job;
+    }
+    else if (!(client->system->options & PAPPL_SOPTIONS_RASTER_SPOOL))
     {
       papplClientRespondIPP(client, IPP_STATUS_ERROR_BUSY, "Currently printing another job.");
       flush_document_data(client);
       return;
     }
 
-    job->state = IPP_JSTATE_PENDING;
-
-    _papplJobProcessRaster(job, client);
-
-    goto complete_job;
+    // Raster data is already compressed, so spool it as-is...
+    papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Printer is busy, spooling raster data.");
   }
 
   // Create a file for the request data...
@@ -1207,15 +1029,16 @@ finish_document_data(
   // Return the job info...
   papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
 
-  ra = cupsArrayNew((cups_array_func_t)strcmp, NULL);
-  cupsArrayAdd(ra, "job-id");
-  cupsArrayAdd(ra, "job-state");
-  cupsArrayAdd(ra, "job-state-message");
-  cupsArrayAdd(ra, "job-state-reasons");
-  cupsArrayAdd(ra, "job-uri");
+  array = cupsArrayNew((cups_array_func_t)strcmp, NULL);
+  cupsArrayAdd(array, "job-id");
+  cupsArrayAdd(array, "job-state");
+  cupsArrayAdd(array, "job-state-message");
+  cupsArrayAdd(array, "job-state-reasons");
+  cupsArrayAdd(array, "job-uri");
+  ra = _papplRACreate(array);
 
   copy_job_attributes(client, job, ra);
-  cupsArrayDelete(ra);
+  _papplRADelete(ra);
   return;
 
   // If we get here we had to abort the job...
@@ -1228,7 +1051,8 @@ finish_document_data(
 
   pthread_rwlock_wrlock(&client->printer->rwlock);
 
-  cupsArrayRemove(client->printer->active_jobs, job);
+  if (cupsArrayRemove(client->printer->active_jobs, job))
+    client->printer->num_active_jobs --;
   cupsArrayAdd(client->printer->completed_jobs, job);
 
   if (!client->system->clean_time)
@@ -1236,14 +1060,15 @@ finish_document_data(
 
   pthread_rwlock_unlock(&client->printer->rwlock);
 
-  ra = cupsArrayNew((cups_array_func_t)strcmp, NULL);
-  cupsArrayAdd(ra, "job-id");
-  cupsArrayAdd(ra, "job-state");
-  cupsArrayAdd(ra, "job-state-reasons");
-  cupsArrayAdd(ra, "job-uri");
+  array = cupsArrayNew((cups_array_func_t)strcmp, NULL);
+  cupsArrayAdd(array, "job-id");
+  cupsArrayAdd(array, "job-state");
+  cupsArrayAdd(array, "job-state-reasons");
+  cupsArrayAdd(array, "job-uri");
+  ra = _papplRACreate(array);
 
   copy_job_attributes(client, job, ra);
-  cupsArrayDelete(ra);
+  _papplRADelete(ra);
 }
 
 
@@ -1265,6 +1090,45 @@ flush_document_data(
 }
 
 
+//
+// 'get_admit()' - Get the admission class for an operation.
+//
+
+static _pappl_admit_t			// O - Admission class
+get_admit(ipp_op_t op)			// I - Operation code
+{
+  switch (op)
+  {
+    case IPP_OP_PRINT_JOB :
+    case IPP_OP_PRINT_URI :
+    case IPP_OP_CREATE_JOB :
+    case IPP_OP_SEND_DOCUMENT :
+    case IPP_OP_SEND_URI :
+        return (_PAPPL_ADMIT_SUBMIT);
+
+    case IPP_OP_CANCEL_JOB :
+    case IPP_OP_CANCEL_CURRENT_JOB :
+    case IPP_OP_CANCEL_JOBS :
+    case IPP_OP_CANCEL_MY_JOBS :
+    case IPP_OP_CLOSE_JOB :
+    case IPP_OP_GET_JOB_ATTRIBUTES :
+    case IPP_OP_GET_JOBS :
+    case IPP_OP_GET_PRINTER_ATTRIBUTES :
+    case IPP_OP_SET_PRINTER_ATTRIBUTES :
+    case IPP_OP_PAUSE_PRINTER :
+    case IPP_OP_RESUME_PRINTER :
+    case IPP_OP_CREATE_PRINTER :
+    case IPP_OP_DELETE_PRINTER :
+    case IPP_OP_SET_SYSTEM_ATTRIBUTES :
+    case IPP_OP_SHUTDOWN_ALL_PRINTERS :
+        return (_PAPPL_ADMIT_PRIORITY);
+
+    default :
+        return (_PAPPL_ADMIT_POLL);
+  }
+}
+
+
 //
 // 'have_document_data()' - Determine whether we have more document data.
 //
@@ -1408,7 +1272,8 @@ static void
 ipp_create_job(pappl_client_t *client)	// I - Client
 {
   pappl_job_t		*job;		// New job
-  cups_array_t		*ra;		// Attributes to send in response
+  cups_array_t		*array;		// Attributes to send in response
+  _pappl_ra_t		*ra;		// Compiled attributes to send
 
 
   // Do we have a file to print?
@@ -1433,15 +1298,16 @@ ipp_create_job(pappl_client_t *client)	// I - Client
   // Return the job info...
   papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
 
-  ra = cupsArrayNew((cups_array_func_t)strcmp, NULL);
-  cupsArrayAdd(ra, "job-id");
-  cupsArrayAdd(ra, "job-state");
-  cupsArrayAdd(ra, "job-state-message");
-  cupsArrayAdd(ra, "job-state-reasons");
-  cupsArrayAdd(ra, "job-uri");
+  array = cupsArrayNew((cups_array_func_t)strcmp, NULL);
+  cupsArrayAdd(array, "job-id");
+  cupsArrayAdd(array, "job-state");
+  cupsArrayAdd(array, "job-state-message");
+  cupsArrayAdd(array, "job-state-reasons");
+  cupsArrayAdd(array, "job-uri");
+  ra = _papplRACreate(array);
 
   copy_job_attributes(client, job, ra);
-  cupsArrayDelete(ra);
+  _papplRADelete(ra);
 }
 
 
@@ -1460,7 +1326,8 @@ ipp_create_printer(
   ipp_attribute_t *attr;		// Current attribute
   char		resource[256];		// Resource path
   pappl_printer_t *printer;		// Printer
-  cups_array_t	*ra;			// Requested attributes
+  cups_array_t	*array;			// Requested attributes array
+  _pappl_ra_t	*ra;			// Requested attributes
   http_status_t	auth_status;		// Authorization status
 
 
@@ -1569,16 +1436,17 @@ ipp_create_printer(
   // Return the printer
   papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
 
-  ra = cupsArrayNew((cups_array_func_t)strcmp, NULL);
-  cupsArrayAdd(ra, "printer-id");
-  cupsArrayAdd(ra, "printer-is-accepting-jobs");
-  cupsArrayAdd(ra, "printer-state");
-  cupsArrayAdd(ra, "printer-state-reasons");
-  cupsArrayAdd(ra, "printer-uuid");
-  cupsArrayAdd(ra, "printer-xri-supported");
+  array = cupsArrayNew((cups_array_func_t)strcmp, NULL);
+  cupsArrayAdd(array, "printer-id");
+  cupsArrayAdd(array, "printer-is-accepting-jobs");
+  cupsArrayAdd(array, "printer-state");
+  cupsArrayAdd(array, "printer-state-reasons");
+  cupsArrayAdd(array, "printer-uuid");
+  cupsArrayAdd(array, "printer-xri-supported");
+  ra = _papplRACreate(array);
 
   copy_printer_attributes(client, printer, ra);
-  cupsArrayDelete(ra);
+  _papplRADelete(ra);
 }
 
 
@@ -1624,7 +1492,7 @@ ipp_get_job_attributes(
     pappl_client_t *client)		// I - Client
 {
   pappl_job_t	*job = client->job;	// Job information
-  cups_array_t	*ra;			// requested-attributes
+  _pappl_ra_t	*ra;			// requested-attributes
 
 
   if (!job)
@@ -1635,9 +1503,9 @@ ipp_get_job_attributes(
 
   papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
 
-  ra = ippCreateRequestedArray(client->request);
+  ra = _papplRACreate(ippCreateRequestedArray(client->request));
   copy_job_attributes(client, job, ra);
-  cupsArrayDelete(ra);
+  _papplRADelete(ra);
 }
 
 
@@ -1659,7 +1527,7 @@ ipp_get_jobs(pappl_client_t *client)	// I - Client
   const char		*username;	// Username
   cups_array_t		*list;		// Jobs list
   pappl_job_t		*job;		// Current job pointer
-  cups_array_t		*ra;		// Requested attributes array
+  _pappl_ra_t		*ra;		// Requested attributes
 
 
   // See if the "which-jobs" attribute have been specified...
@@ -1737,7 +1605,7 @@ ipp_get_jobs(pappl_client_t *client)	// I - Client
   }
 
   // OK, build a list of jobs for this printer...
-  ra = ippCreateRequestedArray(client->request);
+  ra = _papplRACreate(ippCreateRequestedArray(client->request));
 
   papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
 
@@ -1759,7 +1627,7 @@ ipp_get_jobs(pappl_client_t *client)	// I - Client
     copy_job_attributes(client, job, ra);
   }
 
-  cupsArrayDelete(ra);
+  _papplRADelete(ra);
 
   pthread_rwlock_unlock(&(client->printer->rwlock));
 }
@@ -1773,20 +1641,13 @@ static void
 ipp_get_printer_attributes(
     pappl_client_t *client)		// I - Client
 {
-  cups_array_t		*ra;		// Requested attributes array
+  _pappl_ra_t		*ra;		// Requested attributes
   pappl_printer_t	*printer = client->printer;
 					// Printer
 
 
-  if (!printer->device_in_use && !printer->processing_job && (time(NULL) - printer->status_time) > 1 && printer->driver_data.status)
-  {
-    // Update printer status...
-    (printer->driver_data.status)(printer);
-    printer->status_time = time(NULL);
-  }
-
-  // Send the attributes...
-  ra = ippCreateRequestedArray(client->request);
+  // Send the attributes (printer status is polled in the background)...
+  ra = _papplRACreate(ippCreateRequestedArray(client->request));
 
   papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
 
@@ -1796,7 +1657,7 @@ ipp_get_printer_attributes(
 
   pthread_rwlock_unlock(&(printer->rwlock));
 
-  cupsArrayDelete(ra);
+  _papplRADelete(ra);
 }
 
 
@@ -1810,21 +1671,22 @@ ipp_get_printers(
 {
   pappl_system_t	*system = client->system;
 					// System
-  cups_array_t		*ra;		// Requested attributes array
+  _pappl_ra_t		*ra;		// Requested attributes
   int			i,		// Looping var
 			limit;		// Maximum number to return
+  _pappl_plist_t	*plist;		// Printer list
   pappl_printer_t	*printer;	// Current printer
 
 
   // Get request attributes...
   limit = ippGetInteger(ippFindAttribute(client->request, "limit", IPP_TAG_INTEGER), 0);
-  ra    = ippCreateRequestedArray(client->request);
+  ra    = _papplRACreate(ippCreateRequestedArray(client->request));
 
   papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
 
-  pthread_rwlock_rdlock(&system->rwlock);
+  plist = _papplSystemGetPrinters(system);
 
-  for (i = 0, printer = (pappl_printer_t *)cupsArrayFirst(system->printers); printer; i ++, printer = (pappl_printer_t *)cupsArrayNext(system->printers))
+  for (i = 0; i < plist->num_printers; i ++)
   {
     if (limit && i >= limit)
       break;
@@ -1832,14 +1694,16 @@ ipp_get_printers(
     if (i)
       ippAddSeparator(client->response);
 
+    printer = plist->printers[i];
+
     pthread_rwlock_rdlock(&printer->rwlock);
     copy_printer_attributes(client, printer, ra);
     pthread_rwlock_unlock(&printer->rwlock);
   }
 
-  pthread_rwlock_unlock(&system->rwlock);
+  _papplSystemReleasePrinters(system, plist);
 
-  cupsArrayDelete(ra);
+  _papplRADelete(ra);
 }
 
 
@@ -1853,8 +1717,9 @@ ipp_get_system_attributes(
 {
   pappl_system_t	*system = client->system;
 					// System
-  cups_array_t		*ra;		// Requested attributes array
+  _pappl_ra_t		*ra;		// Requested attributes
   int			i;		// Looping var
+  _pappl_plist_t	*plist;		// Printer list
   pappl_printer_t	*printer;	// Current printer
   ipp_attribute_t	*attr;		// Current attribute
   ipp_t			*col;		// configured-printers value
@@ -1863,13 +1728,15 @@ ipp_get_system_attributes(
   time_t		state_time = 0;	// system-state-change-[date-]time value
 
 
-  ra = ippCreateRequestedArray(client->request);
+  ra = _papplRACreate(ippCreateRequestedArray(client->request));
 
   papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
 
-  pthread_rwlock_rdlock(&system->rwlock);
+  _papplSystemRDLock(system);
 
-  if (!ra || cupsArrayFind(ra, "printer-creation-attributes-supported"))
+  plist = _papplSystemGetPrinters(system);
+
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_PRINTER_CREATION_ATTRIBUTES_SUPPORTED))
   {
     static const char * const values[] =
     {					// Values
@@ -1896,10 +1763,10 @@ ipp_get_system_attributes(
     ippAddStrings(client->response, IPP_TAG_SYSTEM, IPP_CONST_TAG(IPP_TAG_KEYWORD), "printer-creation-attributes-supported", (int)(sizeof(values) / sizeof(values[0])), NULL, values);
   }
 
-  if (system->num_pdrivers > 0 && (!ra || cupsArrayFind(ra, "smi2699-device-command-supported")))
+  if (system->num_pdrivers > 0 && _PAPPL_REQUESTED(ra, _PAPPL_RA_SMI2699_DEVICE_COMMAND_SUPPORTED))
     ippAddStrings(client->response, IPP_TAG_SYSTEM, IPP_CONST_TAG(IPP_TAG_NAME), "smi2699-device-command-supported", system->num_pdrivers, NULL, system->pdrivers);
 
-  if (!ra || cupsArrayFind(ra, "smi2699-device-uri-schemes-supported"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_SMI2699_DEVICE_URI_SCHEMES_SUPPORTED))
   {
     static const char * const values[] =
     {					// Values
@@ -1911,27 +1778,31 @@ ipp_get_system_attributes(
     ippAddStrings(client->response, IPP_TAG_SYSTEM, IPP_CONST_TAG(IPP_TAG_URISCHEME), "smi2699-device-uri-schemes-supported", (int)(sizeof(values) / sizeof(values[0])), NULL, values);
   }
 
-  if (!ra || cupsArrayFind(ra, "system-config-change-date-time") || cupsArrayFind(ra, "system-config-change-time"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_SYSTEM_CONFIG_CHANGE_DATE_TIME) || _PAPPL_REQUESTED(ra, _PAPPL_RA_SYSTEM_CONFIG_CHANGE_TIME))
   {
-    for (printer = (pappl_printer_t *)cupsArrayFirst(system->printers); printer; printer = (pappl_printer_t *)cupsArrayNext(system->printers))
+    for (i = 0; i < plist->num_printers; i ++)
     {
+      printer = plist->printers[i];
+
       if (config_time < printer->config_time)
         config_time = printer->config_time;
     }
 
-    if (!ra || cupsArrayFind(ra, "system-config-change-date-time"))
+    if (_PAPPL_REQUESTED(ra, _PAPPL_RA_SYSTEM_CONFIG_CHANGE_DATE_TIME))
       ippAddDate(client->response, IPP_TAG_SYSTEM, "system-config-change-date-time", ippTimeToDate(config_time));
 
-    if (!ra || cupsArrayFind(ra, "system-config-change-time"))
+    if (_PAPPL_REQUESTED(ra, _PAPPL_RA_SYSTEM_CONFIG_CHANGE_TIME))
       ippAddInteger(client->response, IPP_TAG_SYSTEM, IPP_TAG_INTEGER, "system-config-change-time", (int)(config_time - system->start_time));
   }
 
-  if (!ra || cupsArrayFind(ra, "system-configured-printers"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_SYSTEM_CONFIGURED_PRINTERS))
   {
-    attr = ippAddCollections(client->response, IPP_TAG_SYSTEM, "system-configured-printers", cupsArrayCount(system->printers), NULL);
+    attr = ippAddCollections(client->response, IPP_TAG_SYSTEM, "system-configured-printers", plist->num_printers, NULL);
 
-    for (i = 0, printer = (pappl_printer_t *)cupsArrayFirst(system->printers); printer; i ++, printer = (pappl_printer_t *)cupsArrayNext(system->printers))
+    for (i = 0; i < plist->num_printers; i ++)
     {
+      printer = plist->printers[i];
+
       col = ippNew();
 
       pthread_rwlock_rdlock(&printer->rwlock);
@@ -1951,22 +1822,22 @@ ipp_get_system_attributes(
     }
   }
 
-  if (!ra || cupsArrayFind(ra, "system-contact-col"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_SYSTEM_CONTACT_COL))
   {
     ipp_t *col = _papplContactExport(&system->contact);
     ippAddCollection(client->response, IPP_TAG_SYSTEM, "system-contact-col", col);
     ippDelete(col);
   }
 
-  if (!ra || cupsArrayFind(ra, "system-current-time"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_SYSTEM_CURRENT_TIME))
     ippAddDate(client->response, IPP_TAG_SYSTEM, "system-current-time", ippTimeToDate(time(NULL)));
 
-  if (!ra || cupsArrayFind(ra, "system-default-printer-id"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_SYSTEM_DEFAULT_PRINTER_ID))
     ippAddInteger(client->response, IPP_TAG_SYSTEM, IPP_TAG_INTEGER, "system-default-printer-id", system->default_printer_id);
 
   _papplSystemExportVersions(system, client->response, IPP_TAG_SYSTEM, ra);
 
-  if (!ra || cupsArrayFind(ra, "system-geo-location"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_SYSTEM_GEO_LOCATION))
   {
     if (system->geo_location)
       ippAddString(client->response, IPP_TAG_SYSTEM, IPP_TAG_URI, "system-geo-location", NULL, system->geo_location);
@@ -1974,10 +1845,10 @@ ipp_get_system_attributes(
       ippAddOutOfBand(client->response, IPP_TAG_SYSTEM, IPP_TAG_UNKNOWN, "system-geo-location");
   }
 
-  if (!ra || cupsArrayFind(ra, "system-location"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_SYSTEM_LOCATION))
     ippAddString(client->response, IPP_TAG_SYSTEM, IPP_TAG_TEXT, "system-location", NULL, system->location ? system->location : "");
 
-  if (!ra || cupsArrayFind(ra, "system-mandatory-printer-attributes"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_SYSTEM_MANDATORY_PRINTER_ATTRIBUTES))
   {
     static const char * const values[] =
     {					// Values
@@ -1989,13 +1860,13 @@ ipp_get_system_attributes(
     ippAddStrings(client->response, IPP_TAG_SYSTEM, IPP_CONST_TAG(IPP_TAG_KEYWORD), "system-mandatory-printer-attributes", (int)(sizeof(values) / sizeof(values[0])), NULL, values);
   }
 
-  if (!ra || cupsArrayFind(ra, "system-organization"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_SYSTEM_ORGANIZATION))
     ippAddString(client->response, IPP_TAG_SYSTEM, IPP_TAG_TEXT, "system-organization", NULL, system->organization ? system->organization : "");
 
-  if (!ra || cupsArrayFind(ra, "system-organizational-unit"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_SYSTEM_ORGANIZATIONAL_UNIT))
     ippAddString(client->response, IPP_TAG_SYSTEM, IPP_TAG_TEXT, "system-organizational-unit", NULL, system->org_unit ? system->org_unit : "");
 
-  if (!ra || cupsArrayFind(ra, "system-settable-attributes-supported"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_SYSTEM_SETTABLE_ATTRIBUTES_SUPPORTED))
   {
     static const char * const values[] =
     {					// Values
@@ -2012,12 +1883,14 @@ ipp_get_system_attributes(
     ippAddStrings(client->response, IPP_TAG_SYSTEM, IPP_CONST_TAG(IPP_TAG_KEYWORD), "system-settable-attributes-supported", (int)(sizeof(values) / sizeof(values[0])), NULL, values);
   }
 
-  if (!ra || cupsArrayFind(ra, "system-state"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_SYSTEM_STATE))
   {
     int	state = IPP_PSTATE_IDLE;	// System state
 
-    for (printer = (pappl_printer_t *)cupsArrayFirst(system->printers); printer; printer = (pappl_printer_t *)cupsArrayNext(system->printers))
+    for (i = 0; i < plist->num_printers; i ++)
     {
+      printer = plist->printers[i];
+
       if (printer->state == IPP_PSTATE_PROCESSING)
       {
         state = IPP_PSTATE_PROCESSING;
@@ -2028,27 +1901,31 @@ ipp_get_system_attributes(
     ippAddInteger(client->response, IPP_TAG_SYSTEM, IPP_TAG_ENUM, "system-state", state);
   }
 
-  if (!ra || cupsArrayFind(ra, "system-state-change-date-time") || cupsArrayFind(ra, "system-state-change-time"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_SYSTEM_STATE_CHANGE_DATE_TIME) || _PAPPL_REQUESTED(ra, _PAPPL_RA_SYSTEM_STATE_CHANGE_TIME))
   {
-    for (printer = (pappl_printer_t *)cupsArrayFirst(system->printers); printer; printer = (pappl_printer_t *)cupsArrayNext(system->printers))
+    for (i = 0; i < plist->num_printers; i ++)
     {
+      printer = plist->printers[i];
+
       if (state_time < printer->state_time)
         state_time = printer->state_time;
     }
 
-    if (!ra || cupsArrayFind(ra, "system-state-change-date-time"))
+    if (_PAPPL_REQUESTED(ra, _PAPPL_RA_SYSTEM_STATE_CHANGE_DATE_TIME))
       ippAddDate(client->response, IPP_TAG_SYSTEM, "system-state-change-date-time", ippTimeToDate(state_time));
 
-    if (!ra || cupsArrayFind(ra, "system-state-change-time"))
+    if (_PAPPL_REQUESTED(ra, _PAPPL_RA_SYSTEM_STATE_CHANGE_TIME))
       ippAddInteger(client->response, IPP_TAG_SYSTEM, IPP_TAG_INTEGER, "system-state-change-time", (int)(state_time - system->start_time));
   }
 
-  if (!ra || cupsArrayFind(ra, "system-state-reasons"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_SYSTEM_STATE_REASONS))
   {
     pappl_preason_t	state_reasons = PAPPL_PREASON_NONE;
 
-    for (printer = (pappl_printer_t *)cupsArrayFirst(system->printers); printer; printer = (pappl_printer_t *)cupsArrayNext(system->printers))
+    for (i = 0; i < plist->num_printers; i ++)
     {
+      printer = plist->printers[i];
+
       state_reasons |= printer->state_reasons;
     }
 
@@ -2074,12 +1951,14 @@ ipp_get_system_attributes(
     }
   }
 
-  if (!ra || cupsArrayFind(ra, "system-up-time"))
+  if (_PAPPL_REQUESTED(ra, _PAPPL_RA_SYSTEM_UP_TIME))
     ippAddInteger(client->response, IPP_TAG_SYSTEM, IPP_TAG_INTEGER, "system-up-time", (int)(time(NULL) - system->start_time));
 
+  _papplSystemReleasePrinters(system, plist);
+
   pthread_rwlock_unlock(&system->rwlock);
 
-  cupsArrayDelete(ra);
+  _papplRADelete(ra);
 }
 
 
@@ -2395,7 +2274,7 @@ ipp_set_system_attributes(
     return;
 
   // Now apply changes...
-  pthread_rwlock_wrlock(&system->rwlock);
+  _papplSystemWRLock(system);
 
   for (rattr = ippFirstAttribute(client->request); rattr; rattr = ippNextAttribute(client->request))
   {
@@ -2480,6 +2359,269 @@ ipp_validate_job(
 }
 
 
+//
+// 'make_printer_attrs()' - Make the configuration attributes for a printer.
+//
+// The returned attributes include the "xxx-configured", "xxx-default", and
+// "xxx-ready" values and other attributes that only change with the printer
+// configuration, but none of the state, supply, counter, or client-specific
+// (URI) attributes.
+//
+
+static ipp_t *				// O - Printer attributes
+make_printer_attrs(
+    pappl_printer_t *printer)		// I - Printer
+{
+  ipp_t			*attrs;		// Printer attributes
+  int			i, j,		// Looping vars
+			count,		// Number of values
+			num_values;	// Number of values
+  unsigned		bit;		// Current bit value
+  const char		*svalues[100];	// String values
+  ipp_t			*col;		// Collection value
+  ipp_attribute_t	*attr;		// Current attribute
+  pappl_media_col_t	media,		// Current media...
+			*ready;		// Media in the tray
+  char			value[256];	// "printer-input-tray" value
+  pappl_pdriver_data_t	*data = &printer->driver_data;
+					// Driver data
+
+
+  // Create an empty IPP message for the attributes...
+  attrs = ippNew();
+
+
+  // identify-actions-default
+  for (num_values = 0, bit = PAPPL_IDENTIFY_ACTIONS_DISPLAY; bit <= PAPPL_IDENTIFY_ACTIONS_SPEAK; bit *= 2)
+  {
+    if (data->identify_default & bit)
+      svalues[num_values ++] = _papplIdentifyActionsString(bit);
+  }
+
+  if (num_values > 0)
+    ippAddStrings(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "identify-actions-default", num_values, NULL, svalues);
+  else
+    ippAddString(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "identify-actions-default", NULL, "none");
+
+
+  // label-mode-configured
+  if (data->mode_configured)
+    ippAddString(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "label-mode-configured", NULL, _papplLabelModeString(data->mode_configured));
+
+
+  // label-tear-offset-configured
+  if (data->tear_offset_supported[1] > 0)
+    ippAddInteger(attrs, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "label-tear-offset-configured", data->tear_offset_configured);
+
+
+  // media-col-default
+  if (data->media_default.size_name[0])
+  {
+    col = _papplMediaColExport(&printer->driver_data, &data->media_default, 0);
+    ippAddCollection(attrs, IPP_TAG_PRINTER, "media-col-default", col);
+    ippDelete(col);
+  }
+
+
+  // media-col-ready
+  for (i = 0, count = 0; i < data->num_source; i ++)
+  {
+    if (data->media_ready[i].size_name[0])
+      count ++;
+  }
+
+  if (data->borderless && (data->bottom_top != 0 || data->left_right != 0))
+    count *= 2;				// Need to report ready media for borderless, too...
+
+  if (count > 0)
+  {
+    attr = ippAddCollections(attrs, IPP_TAG_PRINTER, "media-col-ready", count, NULL);
+
+    for (i = 0, j = 0; i < data->num_source && j < count; i ++)
+    {
+      if (data->media_ready[i].size_name[0])
+      {
+	if (data->borderless && (data->bottom_top != 0 || data->left_right != 0))
+	{
+	  // Report both bordered and borderless media-col values...
+	  media = data->media_ready[i];
+
+	  media.bottom_margin = media.top_margin   = data->bottom_top;
+	  media.left_margin   = media.right_margin = data->left_right;
+	  col = _papplMediaColExport(&printer->driver_data, &media, 0);
+	  ippSetCollection(attrs, &attr, j ++, col);
+	  ippDelete(col);
+
+	  media.bottom_margin = media.top_margin   = 0;
+	  media.left_margin   = media.right_margin = 0;
+	  col = _papplMediaColExport(&printer->driver_data, &media, 0);
+	  ippSetCollection(attrs, &attr, j ++, col);
+	  ippDelete(col);
+	}
+	else
+	{
+	  // Just report the single media-col value...
+	  col = _papplMediaColExport(&printer->driver_data, data->media_ready + i, 0);
+	  ippSetCollection(attrs, &attr, j ++, col);
+	  ippDelete(col);
+	}
+      }
+    }
+  }
+
+
+  // media-default
+  if (data->media_default.size_name[0])
+    ippAddString(attrs, IPP_TAG_PRINTER, IPP_TAG_KEYWORD, "media-default", NULL, data->media_default.size_name);
+
+
+  // media-ready
+  for (i = 0, count = 0; i < data->num_source; i ++)
+  {
+    if (data->media_ready[i].size_name[0])
+      count ++;
+  }
+
+  if (count > 0)
+  {
+    attr = ippAddStrings(attrs, IPP_TAG_PRINTER, IPP_TAG_KEYWORD, "media-ready", count, NULL, NULL);
+
+    for (i = 0, j = 0; i < data->num_source && j < count; i ++)
+    {
+      if (data->media_ready[i].size_name[0])
+	ippSetString(attrs, &attr, j ++, data->media_ready[i].size_name);
+    }
+  }
+
+
+  // multiple-document-handling-default
+  ippAddString(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "multiple-document-handling-default", NULL, "separate-documents-collated-copies");
+
+
+  // orientation-requested-default
+  ippAddInteger(attrs, IPP_TAG_PRINTER, IPP_TAG_ENUM, "orientation-requested-default", data->orient_default);
+
+
+  // output-bin-default
+  if (data->num_bin > 0)
+    ippAddString(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "output-bin-default", NULL, data->bin[data->bin_default]);
+  else if (data->output_face_up)
+    ippAddString(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "output-bin-default", NULL, "face-up");
+  else
+    ippAddString(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "output-bin-default", NULL, "face-down");
+
+
+  // print-color-mode-default
+  if (data->color_default)
+    ippAddString(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "print-color-mode-default", NULL, _papplColorModeString(data->color_default));
+
+
+  // print-content-optimize-default
+  if (data->content_default)
+    ippAddString(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "print-content-optimize-default", NULL, _papplContentString(data->content_default));
+  else
+    ippAddString(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "print-content-optimize-default", NULL, "auto");
+
+
+  // print-quality-default
+  if (data->quality_default)
+    ippAddInteger(attrs, IPP_TAG_PRINTER, IPP_TAG_ENUM, "print-quality-default", data->quality_default);
+  else
+    ippAddInteger(attrs, IPP_TAG_PRINTER, IPP_TAG_ENUM, "print-quality-default", IPP_QUALITY_NORMAL);
+
+
+  // print-scaling-default
+  if (data->scaling_default)
+    ippAddString(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "print-scaling-default", NULL, _papplScalingString(data->scaling_default));
+  else
+    ippAddString(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "print-scaling-default", NULL, "auto");
+
+
+  // printer-config-change-date-time
+  ippAddDate(attrs, IPP_TAG_PRINTER, "printer-config-change-date-time", ippTimeToDate(printer->config_time));
+
+
+  // printer-config-change-time
+  ippAddInteger(attrs, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "printer-config-change-time", (int)(printer->config_time - printer->start_time));
+
+
+  // printer-contact-col
+  col = _papplContactExport(&printer->contact);
+  ippAddCollection(attrs, IPP_TAG_PRINTER, "printer-contact-col", col);
+  ippDelete(col);
+
+
+  // printer-darkness-configured
+  if (data->darkness_supported > 0)
+    ippAddInteger(attrs, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "printer-darkness-configured", data->darkness_configured);
+
+
+  // printer-dns-sd-name
+  ippAddString(attrs, IPP_TAG_PRINTER, IPP_TAG_NAME, "printer-dns-sd-name", NULL, printer->dns_sd_name ? printer->dns_sd_name : "");
+
+
+  // printer-geo-location
+  if (printer->geo_location)
+    ippAddString(attrs, IPP_TAG_PRINTER, IPP_TAG_URI, "printer-geo-location", NULL, printer->geo_location);
+  else
+    ippAddOutOfBand(attrs, IPP_TAG_PRINTER, IPP_TAG_UNKNOWN, "printer-geo-location");
+
+
+  // printer-input-tray
+  for (i = 0, attr = NULL, ready = data->media_ready; i < data->num_source; i ++, ready ++)
+  {
+    const char	*type;			// Tray type
+
+    if (!strcmp(data->source[i], "manual"))
+      type = "sheetFeedManual";
+    else if (!strcmp(data->source[i], "by-pass-tray"))
+      type = "sheetFeedAutoNonRemovableTray";
+    else
+      type = "sheetFeedAutoRemovableTray";
+
+    snprintf(value, sizeof(value), "type=%s;mediafeed=%d;mediaxfeed=%d;maxcapacity=%d;level=-2;status=0;name=%s;", type, ready->size_length, ready->size_width, !strcmp(ready->source, "manual") ? 1 : -2, ready->source);
+
+    if (attr)
+      ippSetOctetString(attrs, &attr, ippGetCount(attr), value, (int)strlen(value));
+    else
+      attr = ippAddOctetString(attrs, IPP_TAG_PRINTER, "printer-input-tray", value, (int)strlen(value));
+  }
+
+  // The "auto" tray is a dummy entry...
+  strlcpy(value, "type=other;mediafeed=0;mediaxfeed=0;maxcapacity=-2;level=-2;status=0;name=auto;", sizeof(value));
+  ippSetOctetString(attrs, &attr, ippGetCount(attr), value, (int)strlen(value));
+
+
+  // printer-location
+  ippAddString(attrs, IPP_TAG_PRINTER, IPP_TAG_TEXT, "printer-location", NULL, printer->location ? printer->location : "");
+
+
+  // printer-organization
+  ippAddString(attrs, IPP_TAG_PRINTER, IPP_TAG_TEXT, "printer-organization", NULL, printer->organization ? printer->organization : "");
+
+
+  // printer-organizational-unit
+  ippAddString(attrs, IPP_TAG_PRINTER, IPP_TAG_TEXT, "printer-organizational-unit", NULL, printer->org_unit ? printer->org_unit : "");
+
+
+  // printer-resolution-default
+  ippAddResolution(attrs, IPP_TAG_PRINTER, "printer-resolution-default", IPP_RES_PER_INCH, data->x_default, data->y_default);
+
+
+  // printer-speed-default
+  ippAddInteger(attrs, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "printer-speed-default", data->speed_default);
+
+
+  // sides-default
+  if (data->sides_default)
+    ippAddString(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "sides-default", NULL, _papplSidesString(data->sides_default));
+  else
+    ippAddString(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "sides-default", NULL, "one-sided");
+
+  return (attrs);
+}
+
+
 //
 // 'respond_unsupported()' - Respond with an unsupported attribute.
 //
@@ -2711,7 +2853,7 @@ set_printer_attributes(
 
   pthread_rwlock_unlock(&printer->rwlock);
 
-  _papplSystemConfigChanged(client->system);
+  _papplPrinterConfigChanged(printer);
 
   return (1);
 }
@@ -117,7 +117,7 @@ papplJobGetID(pappl_job_t *job)		// I - Job
 int					// O - Number of impressions in job
 papplJobGetImpressions(pappl_job_t *job)// I - Job
 {
-  return (job ? job->impressions : 0);
+  return (job ? atomic_load_explicit(&job->impressions, memory_order_relaxed) : 0);
 }
 
 
@@ -129,7 +129,7 @@ int					// O - Number of completed impressions in job
 papplJobGetImpressionsCompleted(
     pappl_job_t *job)			// I - Job
 {
-  return (job ? job->impcompleted : 0);
+  return (job ? atomic_load_explicit(&job->impcompleted, memory_order_relaxed) : 0);
 }
 
 
@@ -184,7 +184,7 @@ papplJobGetReasons(pappl_job_t *job)	// I - Job
 ipp_jstate_t				// O - IPP "job-state" value
 papplJobGetState(pappl_job_t *job)	// I - Job
 {
-  return (job ? job->state : IPP_JSTATE_ABORTED);
+  return (job ? atomic_load_explicit(&job->state, memory_order_relaxed) : IPP_JSTATE_ABORTED);
 }
 
 
@@ -241,8 +241,15 @@ papplJobGetUsername(pappl_job_t *job)	// I - Job
 bool					// O - `true` if the job is canceled, `false` otherwise
 papplJobIsCanceled(pappl_job_t *job)	// I - Job
 {
+  ipp_jstate_t	state;			// Current job state
+
+
   if (job)
-    return (job->is_canceled || job->state == IPP_JSTATE_CANCELED || job->state == IPP_JSTATE_ABORTED);
+  {
+    state = atomic_load_explicit(&job->state, memory_order_relaxed);
+
+    return (atomic_load_explicit(&job->is_canceled, memory_order_relaxed) || state == IPP_JSTATE_CANCELED || state == IPP_JSTATE_ABORTED);
+  }
   else
     return (false);
 }
@@ -286,7 +293,7 @@ papplJobSetImpressions(
     int         impressions)		// I - Number of impressions/sides
 {
   if (job)
-    job->impressions = impressions;
+    atomic_store_explicit(&job->impressions, impressions, memory_order_relaxed);
 }
 
 
@@ -300,11 +307,7 @@ papplJobSetImpressionsCompleted(
     int         add)			// I - Number of impressions/sides to add
 {
   if (job)
-  {
-    pthread_rwlock_wrlock(&job->rwlock);
-    job->impcompleted += add;
-    pthread_rwlock_unlock(&job->rwlock);
-  }
+    atomic_fetch_add_explicit(&job->impcompleted, add, memory_order_relaxed);
 }
 
 
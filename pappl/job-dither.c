@@ -0,0 +1,413 @@
+//
+// Dithering functions for the Printer Application Framework
+//
+// Copyright © 2020 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+//
+// Include necessary headers...
+//
+
+#include "pappl-private.h"
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define _PAPPL_DITHER_X86 1
+#  include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#  define _PAPPL_DITHER_NEON 1
+#  include <arm_neon.h>
+#endif // __GNUC__ && (__x86_64__ || __i386__)
+
+
+//
+// Local types...
+//
+
+typedef void (*_pappl_dither_cb_t)(unsigned char *line, const unsigned char *pixels, unsigned x, unsigned count, const unsigned char *dither, bool black);
+
+
+//
+// Local functions...
+//
+
+static void	dither_init(void);
+static void	dither_scalar(unsigned char *line, const unsigned char *pixels, unsigned x, unsigned count, const unsigned char *dither, bool black);
+#ifdef _PAPPL_DITHER_X86
+static void	dither_avx2(unsigned char *line, const unsigned char *pixels, unsigned x, unsigned count, const unsigned char *dither, bool black) __attribute__((target("avx2")));
+static void	dither_sse2(unsigned char *line, const unsigned char *pixels, unsigned x, unsigned count, const unsigned char *dither, bool black) __attribute__((target("sse2")));
+#endif // _PAPPL_DITHER_X86
+#ifdef _PAPPL_DITHER_NEON
+static void	dither_neon(unsigned char *line, const unsigned char *pixels, unsigned x, unsigned count, const unsigned char *dither, bool black);
+#endif // _PAPPL_DITHER_NEON
+
+
+//
+// Local globals...
+//
+
+static pthread_once_t		dither_once = PTHREAD_ONCE_INIT;
+					// One-time initialization control
+static _pappl_dither_cb_t	dither_cb = dither_scalar;
+					// Dither function
+static const char		*dither_name = "scalar";
+					// Name of dither function
+#ifdef _PAPPL_DITHER_X86
+static const unsigned char	dither_reverse[256] =
+{					// Bit-reversed byte values
+  0x00, 0x80, 0x40, 0xc0, 0x20, 0xa0, 0x60, 0xe0, 0x10, 0x90, 0x50, 0xd0, 0x30, 0xb0, 0x70, 0xf0,
+  0x08, 0x88, 0x48, 0xc8, 0x28, 0xa8, 0x68, 0xe8, 0x18, 0x98, 0x58, 0xd8, 0x38, 0xb8, 0x78, 0xf8,
+  0x04, 0x84, 0x44, 0xc4, 0x24, 0xa4, 0x64, 0xe4, 0x14, 0x94, 0x54, 0xd4, 0x34, 0xb4, 0x74, 0xf4,
+  0x0c, 0x8c, 0x4c, 0xcc, 0x2c, 0xac, 0x6c, 0xec, 0x1c, 0x9c, 0x5c, 0xdc, 0x3c, 0xbc, 0x7c, 0xfc,
+  0x02, 0x82, 0x42, 0xc2, 0x22, 0xa2, 0x62, 0xe2, 0x12, 0x92, 0x52, 0xd2, 0x32, 0xb2, 0x72, 0xf2,
+  0x0a, 0x8a, 0x4a, 0xca, 0x2a, 0xaa, 0x6a, 0xea, 0x1a, 0x9a, 0x5a, 0xda, 0x3a, 0xba, 0x7a, 0xfa,
+  0x06, 0x86, 0x46, 0xc6, 0x26, 0xa6, 0x66, 0xe6, 0x16, 0x96, 0x56, 0xd6, 0x36, 0xb6, 0x76, 0xf6,
+  0x0e, 0x8e, 0x4e, 0xce, 0x2e, 0xae, 0x6e, 0xee, 0x1e, 0x9e, 0x5e, 0xde, 0x3e, 0xbe, 0x7e, 0xfe,
+  0x01, 0x81, 0x41, 0xc1, 0x21, 0xa1, 0x61, 0xe1, 0x11, 0x91, 0x51, 0xd1, 0x31, 0xb1, 0x71, 0xf1,
+  0x09, 0x89, 0x49, 0xc9, 0x29, 0xa9, 0x69, 0xe9, 0x19, 0x99, 0x59, 0xd9, 0x39, 0xb9, 0x79, 0xf9,
+  0x05, 0x85, 0x45, 0xc5, 0x25, 0xa5, 0x65, 0xe5, 0x15, 0x95, 0x55, 0xd5, 0x35, 0xb5, 0x75, 0xf5,
+  0x0d, 0x8d, 0x4d, 0xcd, 0x2d, 0xad, 0x6d, 0xed, 0x1d, 0x9d, 0x5d, 0xdd, 0x3d, 0xbd, 0x7d, 0xfd,
+  0x03, 0x83, 0x43, 0xc3, 0x23, 0xa3, 0x63, 0xe3, 0x13, 0x93, 0x53, 0xd3, 0x33, 0xb3, 0x73, 0xf3,
+  0x0b, 0x8b, 0x4b, 0xcb, 0x2b, 0xab, 0x6b, 0xeb, 0x1b, 0x9b, 0x5b, 0xdb, 0x3b, 0xbb, 0x7b, 0xfb,
+  0x07, 0x87, 0x47, 0xc7, 0x27, 0xa7, 0x67, 0xe7, 0x17, 0x97, 0x57, 0xd7, 0x37, 0xb7, 0x77, 0xf7,
+  0x0f, 0x8f, 0x4f, 0xcf, 0x2f, 0xaf, 0x6f, 0xef, 0x1f, 0x9f, 0x5f, 0xdf, 0x3f, 0xbf, 0x7f, 0xff
+};
+#endif // _PAPPL_DITHER_X86
+
+
+//
+// '_papplJobDitherLine()' - Dither 8-bit pixels to a 1-bit line.
+//
+// This function thresholds "count" 8-bit pixels against a row of a 16x16
+// dither matrix and packs the results into the 1-bit output "line", starting
+// at column "x".  The "pixels" argument points to the pixel for column "x".
+//
+// When "black" is `true` the pixels are black values and a pixel is set when
+// it is greater than the threshold.  Otherwise the pixels are luminance values
+// and a pixel is set when it is less than or equal to the threshold.
+//
+// The bytes of "line" that contain the specified columns are replaced, with
+// the bits for columns outside of the range cleared.
+//
+
+void
+_papplJobDitherLine(
+    unsigned char       *line,		// I - Output line
+    const unsigned char *pixels,	// I - Pixels starting at column "x"
+    unsigned            x,		// I - First column
+    unsigned            count,		// I - Number of columns
+    const unsigned char *dither,	// I - Dither matrix row (16 thresholds)
+    bool                black)		// I - `true` for black pixels, `false` for luminance
+{
+  pthread_once(&dither_once, dither_init);
+
+  (dither_cb)(line, pixels, x, count, dither, black);
+}
+
+
+//
+// '_papplJobDitherName()' - Get the name of the dither implementation in use.
+//
+
+const char *				// O - "avx2", "sse2", "neon", or "scalar"
+_papplJobDitherName(void)
+{
+  pthread_once(&dither_once, dither_init);
+
+  return (dither_name);
+}
+
+
+//
+// '_papplJobDitherSelect()' - Select a dither implementation.
+//
+// This function is used by the unit tests to compare each SIMD implementation
+// with the scalar implementation.
+//
+
+bool					// O - `true` on success, `false` if not supported by this CPU
+_papplJobDitherSelect(const char *name)	// I - "avx2", "sse2", "neon", or "scalar"
+{
+  pthread_once(&dither_once, dither_init);
+
+  if (!strcmp(name, "scalar"))
+  {
+    dither_cb   = dither_scalar;
+    dither_name = "scalar";
+  }
+#ifdef _PAPPL_DITHER_X86
+  else if (!strcmp(name, "avx2") && __builtin_cpu_supports("avx2"))
+  {
+    dither_cb   = dither_avx2;
+    dither_name = "avx2";
+  }
+  else if (!strcmp(name, "sse2") && __builtin_cpu_supports("sse2"))
+  {
+    dither_cb   = dither_sse2;
+    dither_name = "sse2";
+  }
+#elif defined(_PAPPL_DITHER_NEON)
+  else if (!strcmp(name, "neon"))
+  {
+    dither_cb   = dither_neon;
+    dither_name = "neon";
+  }
+#endif // _PAPPL_DITHER_X86
+  else
+    return (false);
+
+  return (true);
+}
+
+
+#ifdef _PAPPL_DITHER_X86
+//
+// 'dither_avx2()' - Dither a line using AVX2 instructions.
+//
+
+static void
+dither_avx2(
+    unsigned char       *line,		// I - Output line
+    const unsigned char *pixels,	// I - Pixels starting at column "x"
+    unsigned            x,		// I - First column
+    unsigned            count,		// I - Number of columns
+    const unsigned char *dither,	// I - Dither matrix row
+    bool                black)		// I - `true` for black pixels, `false` for luminance
+{
+  unsigned	head;			// Columns before 16-column boundary
+  unsigned char	*lineptr;		// Pointer into line
+  __m256i	thresh,			// Thresholds
+		pix,			// Pixels
+		mask;			// Comparison mask
+  unsigned	bits;			// Packed bits
+  unsigned	invert = black ? 0xffffffff : 0;
+					// Bits to invert for black pixels
+
+
+  // Use the scalar code up to the first 16-column boundary...
+  if ((head = (16 - (x & 15)) & 15) > count)
+    head = count;
+
+  if (head > 0)
+  {
+    dither_scalar(line, pixels, x, head, dither, black);
+
+    pixels += head;
+    x      += head;
+    count  -= head;
+  }
+
+  // Then do 32 columns at a time...
+  thresh  = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)dither));
+  lineptr = line + x / 8;
+
+  for (; count >= 32; count -= 32, pixels += 32, x += 32, lineptr += 4)
+  {
+    // (pixel <= threshold) is the same as (max(pixel, threshold) == threshold)
+    pix  = _mm256_loadu_si256((const __m256i *)pixels);
+    mask = _mm256_cmpeq_epi8(_mm256_max_epu8(pix, thresh), thresh);
+    bits = (unsigned)_mm256_movemask_epi8(mask) ^ invert;
+
+    lineptr[0] = dither_reverse[bits & 255];
+    lineptr[1] = dither_reverse[(bits >> 8) & 255];
+    lineptr[2] = dither_reverse[(bits >> 16) & 255];
+    lineptr[3] = dither_reverse[bits >> 24];
+  }
+
+  // and finish with the SSE2 code...
+  if (count > 0)
+    dither_sse2(line, pixels, x, count, dither, black);
+}
+#endif // _PAPPL_DITHER_X86
+
+
+//
+// 'dither_init()' - Choose the dither implementation for this CPU.
+//
+
+static void
+dither_init(void)
+{
+#ifdef _PAPPL_DITHER_X86
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx2"))
+  {
+    dither_cb   = dither_avx2;
+    dither_name = "avx2";
+  }
+  else if (__builtin_cpu_supports("sse2"))
+  {
+    dither_cb   = dither_sse2;
+    dither_name = "sse2";
+  }
+
+#elif defined(_PAPPL_DITHER_NEON)
+  // NEON is always available on 64-bit ARM...
+  dither_cb   = dither_neon;
+  dither_name = "neon";
+#endif // _PAPPL_DITHER_X86
+}
+
+
+#ifdef _PAPPL_DITHER_NEON
+//
+// 'dither_neon()' - Dither a line using NEON instructions.
+//
+
+static void
+dither_neon(
+    unsigned char       *line,		// I - Output line
+    const unsigned char *pixels,	// I - Pixels starting at column "x"
+    unsigned            x,		// I - First column
+    unsigned            count,		// I - Number of columns
+    const unsigned char *dither,	// I - Dither matrix row
+    bool                black)		// I - `true` for black pixels, `false` for luminance
+{
+  unsigned	head;			// Columns before 16-column boundary
+  unsigned char	*lineptr;		// Pointer into line
+  uint8x16_t	thresh,			// Thresholds
+		mask;			// Comparison mask
+  static const uint8_t weights[16] =	// Bit values for each column
+  {
+    128, 64, 32, 16, 8, 4, 2, 1, 128, 64, 32, 16, 8, 4, 2, 1
+  };
+  uint8x16_t	weight = vld1q_u8(weights);
+					// Bit values vector
+
+
+  // Use the scalar code up to the first 16-column boundary...
+  if ((head = (16 - (x & 15)) & 15) > count)
+    head = count;
+
+  if (head > 0)
+  {
+    dither_scalar(line, pixels, x, head, dither, black);
+
+    pixels += head;
+    x      += head;
+    count  -= head;
+  }
+
+  // Then do 16 columns at a time...
+  thresh  = vld1q_u8(dither);
+  lineptr = line + x / 8;
+
+  for (; count >= 16; count -= 16, pixels += 16, x += 16, lineptr += 2)
+  {
+    if (black)
+      mask = vcgtq_u8(vld1q_u8(pixels), thresh);
+    else
+      mask = vcleq_u8(vld1q_u8(pixels), thresh);
+
+    mask = vandq_u8(mask, weight);
+
+    lineptr[0] = vaddv_u8(vget_low_u8(mask));
+    lineptr[1] = vaddv_u8(vget_high_u8(mask));
+  }
+
+  // and finish with the scalar code...
+  if (count > 0)
+    dither_scalar(line, pixels, x, count, dither, black);
+}
+#endif // _PAPPL_DITHER_NEON
+
+
+//
+// 'dither_scalar()' - Dither a line one pixel at a time.
+//
+
+static void
+dither_scalar(
+    unsigned char       *line,		// I - Output line
+    const unsigned char *pixels,	// I - Pixels starting at column "x"
+    unsigned            x,		// I - First column
+    unsigned            count,		// I - Number of columns
+    const unsigned char *dither,	// I - Dither matrix row
+    bool                black)		// I - `true` for black pixels, `false` for luminance
+{
+  unsigned		xend = x + count;
+					// End column
+  unsigned char		*lineptr,	// Pointer into line
+			byte,		// Byte in line
+			bit;		// Current bit
+
+
+  for (lineptr = line + x / 8, bit = 128 >> (x & 7), byte = 0; x < xend; x ++, pixels ++)
+  {
+    if (black ? *pixels > dither[x & 15] : *pixels <= dither[x & 15])
+      byte |= bit;
+
+    if (bit == 1)
+    {
+      *lineptr++ = byte;
+      byte       = 0;
+      bit        = 128;
+    }
+    else
+      bit /= 2;
+  }
+
+  if (bit < 128)
+    *lineptr = byte;
+}
+
+
+#ifdef _PAPPL_DITHER_X86
+//
+// 'dither_sse2()' - Dither a line using SSE2 instructions.
+//
+
+static void
+dither_sse2(
+    unsigned char       *line,		// I - Output line
+    const unsigned char *pixels,	// I - Pixels starting at column "x"
+    unsigned            x,		// I - First column
+    unsigned            count,		// I - Number of columns
+    const unsigned char *dither,	// I - Dither matrix row
+    bool                black)		// I - `true` for black pixels, `false` for luminance
+{
+  unsigned	head;			// Columns before 16-column boundary
+  unsigned char	*lineptr;		// Pointer into line
+  __m128i	thresh,			// Thresholds
+		pix,			// Pixels
+		mask;			// Comparison mask
+  unsigned	bits;			// Packed bits
+  unsigned	invert = black ? 0xffff : 0;
+					// Bits to invert for black pixels
+
+
+  // Use the scalar code up to the first 16-column boundary...
+  if ((head = (16 - (x & 15)) & 15) > count)
+    head = count;
+
+  if (head > 0)
+  {
+    dither_scalar(line, pixels, x, head, dither, black);
+
+    pixels += head;
+    x      += head;
+    count  -= head;
+  }
+
+  // Then do 16 columns at a time...
+  thresh  = _mm_loadu_si128((const __m128i *)dither);
+  lineptr = line + x / 8;
+
+  for (; count >= 16; count -= 16, pixels += 16, x += 16, lineptr += 2)
+  {
+    // (pixel <= threshold) is the same as (max(pixel, threshold) == threshold)
+    pix  = _mm_loadu_si128((const __m128i *)pixels);
+    mask = _mm_cmpeq_epi8(_mm_max_epu8(pix, thresh), thresh);
+    bits = (unsigned)_mm_movemask_epi8(mask) ^ invert;
+
+    lineptr[0] = dither_reverse[bits & 255];
+    lineptr[1] = dither_reverse[bits >> 8];
+  }
+
+  // and finish with the scalar code...
+  if (count > 0)
+    dither_scalar(line, pixels, x, count, dither, black);
+}
+#endif // _PAPPL_DITHER_X86
@@ -11,8 +11,7 @@
 // Include necessary headers...
 //
 
-#include "pappl.h"
-#include "job-private.h"
+#include "pappl-private.h"
 #ifdef HAVE_LIBJPEG
 #  include <setjmp.h>
 #  include <jpeglib.h>
@@ -26,6 +25,66 @@
 // Local types...
 //
 
+#define _PAPPL_IMAGE_STRIP	32	// Number of lines in a rotated strip
+#define _PAPPL_PCACHE_BUFFER	65536	// Size of page cache file buffer
+#define _PAPPL_PCACHE_MAX	(16 * 1024 * 1024)
+					// Maximum size of page cache in memory
+
+typedef struct _pappl_image_s _pappl_image_t;
+					// Image row source
+typedef const unsigned char *(*_pappl_image_row_cb_t)(_pappl_image_t *image, unsigned y);
+					// Get a row of pixels
+typedef bool (*_pappl_image_rewind_cb_t)(_pappl_image_t *image);
+					// Start reading the image over
+
+struct _pappl_image_s			// Image row source
+{
+  pappl_job_t		*job;			// Job
+  unsigned		width,			// Width in columns, after rotation
+			height,			// Height in lines, after rotation
+			depth;			// Bytes per pixel
+  _pappl_image_row_cb_t	row_cb;			// Get a row (in increasing order)
+  _pappl_image_rewind_cb_t rewind_cb;		// Start over for another copy, if needed
+  const unsigned char	*pixels;		// In-memory image, if any
+  int			fd;			// Spooled image, if any
+  unsigned		pwidth,			// Width of in-memory/spooled image
+			pheight;		// Height of in-memory/spooled image
+  ipp_orient_t		orient;			// Orientation of in-memory/spooled image
+  unsigned char		*row;			// Row buffer
+  unsigned		strip_y,		// First line in rotated strip
+			strip_lines;		// Number of lines in rotated strip
+  void			*data;			// Decoder data, if any
+};
+
+typedef struct _pappl_ilayout_s		// Image layout on the page
+{
+  unsigned		ileft,			// Imageable left margin
+			itop,			// Imageable top margin
+			iwidth,			// Imageable width
+			iheight,		// Imageable length/height
+			xsize,			// Scaled width
+			xstart,			// X start position
+			xend,			// X end position
+			ysize,			// Scaled height
+			ystart,			// Y start position
+			yend;			// Y end position
+} _pappl_ilayout_t;
+
+typedef struct _pappl_pcache_s		// Rendered page cache
+{
+  pappl_job_t		*job;			// Job
+  unsigned		bytes;			// Bytes per line
+  unsigned char		*packed;		// PackBits buffer for one line
+  unsigned char		*data;			// Cached lines or file buffer
+  size_t		datalen,		// Bytes in data
+			datasize,		// Size of data buffer
+			datapos,		// Current position in data
+			total;			// Total bytes cached
+  int			fd,			// Spool file for writing or -1
+			rfd;			// Spool file for reading or -1
+  bool			reading;		// Replaying the cached page?
+} _pappl_pcache_t;
+
 #ifdef HAVE_LIBJPEG
 typedef struct _pappl_jpeg_err_s	// JPEG error manager extension
 {
@@ -33,16 +92,77 @@ typedef struct _pappl_jpeg_err_s	// JPEG error manager extension
   jmp_buf	retbuf;				// setjmp() return buffer
   char		message[JMSG_LENGTH_MAX];	// Last error message
 } _pappl_jpeg_err_t;
+
+typedef struct _pappl_jpeg_s		// JPEG decoder data
+{
+  struct jpeg_decompress_struct	dinfo;		// Decompressor info
+  _pappl_jpeg_err_t	jerr;			// Error handler info
+  FILE			*fp;			// JPEG file
+  J_COLOR_SPACE		out_color_space;	// Output color space
+  unsigned		scale_denom;		// DCT scaling denominator
+  int			fd,			// Spool file for writing or -1
+			rfd;			// Spool file for reading or -1
+} _pappl_jpeg_t;
 #endif // HAVE_LIBJPEG
 
+#ifdef HAVE_LIBPNG
+typedef struct _pappl_png_s		// PNG decoder data
+{
+  pappl_job_t		*job;			// Job
+  FILE			*fp;			// PNG file
+  png_structp		pp;			// PNG read data
+  png_infop		info;			// PNG image info
+  bool			gray;			// Convert color images to grayscale?
+  unsigned		width,			// Width in columns
+			height,			// Height in lines
+			depth,			// Bytes per pixel after conversion
+			passes,			// Number of interlace passes
+			y;			// Next line to decode
+  int			fd,			// Spool file for writing or -1
+			rfd;			// Spool file for reading or -1
+  char			message[256];		// Last error message
+} _pappl_png_t;
+#endif // HAVE_LIBPNG
+
 
 //
 // Local functions...
 //
 
+static bool	filter_image(pappl_job_t *job, pappl_device_t *device, pappl_poptions_t *options, _pappl_image_t *image, bool smoothing);
+static const unsigned char *image_buffer_row(_pappl_image_t *image, unsigned y);
+static int	image_create_spool(pappl_job_t *job, const char *ext, int *rfd);
+static bool	image_init_buffer(_pappl_image_t *image, pappl_job_t *job, const unsigned char *pixels, int fd, unsigned width, unsigned height, unsigned depth, ipp_orient_t orient);
+static bool	image_layout(pappl_job_t *job, pappl_poptions_t *options, unsigned width, unsigned height, _pappl_ilayout_t *layout);
+static bool	image_rotate_strip(_pappl_image_t *image, unsigned y);
 #ifdef HAVE_LIBJPEG
 static void	jpeg_error_handler(j_common_ptr p);
+static bool	jpeg_rewind(_pappl_image_t *image);
+static const unsigned char *jpeg_row(_pappl_image_t *image, unsigned y);
+static void	jpeg_setup(_pappl_jpeg_t *jpeg);
 #endif // HAVE_LIBJPEG
+static bool	pcache_add(_pappl_pcache_t *pc, const unsigned char *line);
+static _pappl_pcache_t *pcache_create(pappl_job_t *job, unsigned bytes);
+static void	pcache_delete(_pappl_pcache_t *pc);
+static bool	pcache_flush(_pappl_pcache_t *pc);
+static size_t	pcache_pack(unsigned char *dst, const unsigned char *src, size_t bytes);
+static bool	pcache_replay(_pappl_pcache_t *pc, pappl_poptions_t *options, pappl_device_t *device, pappl_pdriver_data_t *driver_data, unsigned char *line);
+static void	pcache_unpack(unsigned char *dst, size_t bytes, const unsigned char *src, size_t srclen);
+#ifdef HAVE_LIBPNG
+static bool	png_begin(_pappl_png_t *png);
+static void	png_error_handler(png_structp pp, png_const_charp message);
+static bool	png_read_line(_pappl_png_t *png, unsigned char *line);
+static bool	png_read_pixels(_pappl_png_t *png, unsigned char *pixels);
+static bool	png_rewind(_pappl_image_t *image);
+static const unsigned char *png_row(_pappl_image_t *image, unsigned y);
+static bool	png_setup(_pappl_png_t *png);
+static void	png_warning_handler(png_structp pp, png_const_charp message);
+#endif // HAVE_LIBPNG
+static bool	prerip_rendjob(pappl_job_t *job, pappl_poptions_t *options, pappl_device_t *device);
+static bool	prerip_rendpage(pappl_job_t *job, pappl_poptions_t *options, pappl_device_t *device, unsigned page);
+static bool	prerip_rstartjob(pappl_job_t *job, pappl_poptions_t *options, pappl_device_t *device);
+static bool	prerip_rstartpage(pappl_job_t *job, pappl_poptions_t *options, pappl_device_t *device, unsigned page);
+static bool	prerip_rwrite(pappl_job_t *job, pappl_poptions_t *options, pappl_device_t *device, unsigned y, const unsigned char *line);
 
 
 //
@@ -67,335 +187,38 @@ papplJobFilterImage(
     unsigned            depth,		// I - Bytes per pixel (`1` for grayscale or `3` for RGB)
     bool		smoothing)	// I - `true` to smooth/interpolate the image, `false` for nearest-neighbor sampling
 {
-  int			i;		// Looping var
-  pappl_pdriver_data_t	driver_data;	// Printer driver data
-  const unsigned char	*dither;	// Dither line
-  unsigned		ileft,		// Imageable left margin
-			itop,		// Imageable top margin
-			iwidth,		// Imageable width
-			iheight;	// Imageable length/height
-  unsigned char		white,		// White color
-			*line = NULL,	// Output line
-			*lineptr,	// Pointer in line
-			byte,		// Byte in line
-			bit;		// Current bit
-  const unsigned char	*pixbase,	// Pointer to first pixel
-			*pixptr;	// Pointer into image
-  unsigned		img_width,	// Rotated image width
-			img_height,	// Rotated image height
-			x,		// X position
-			xsize,		// Scaled width
-			xstep,		// X step
-			xstart,		// X start position
-			xend,		// X end position
-			y,		// Y position
-			ysize,		// Scaled height
-			ystart,		// Y start position
-			yend;		// Y end position
-  int			xdir,
-			xerr,		// X error accumulator
-			xmod,		// X modulus
-			ydir;
-
-
-  // TODO: Implement bilinear interpolation
-  (void)smoothing;
-
-  // Images contain a single page/impression...
-  papplJobSetImpressions(job, 1);
-
-  if (options->print_scaling == PAPPL_SCALING_FILL)
-  {
-    // Scale to fill the entire media area...
-    ileft   = 0;
-    itop    = 0;
-    iwidth  = options->header.cupsWidth;
-    iheight = options->header.cupsHeight;
-  }
-  else
-  {
-    // Scale/center within the margins...
-    ileft   = options->media.left_margin * options->printer_resolution[0] / 2540;
-    itop    = options->media.top_margin * options->printer_resolution[1] / 2540;
-    iwidth  = options->header.cupsWidth - (options->media.left_margin + options->media.right_margin) * options->printer_resolution[0] / 2540;
-    iheight = options->header.cupsHeight - (options->media.bottom_margin + options->media.top_margin) * options->printer_resolution[1] / 2540;
-  }
+  _pappl_image_t	image;		// Image row source
+  _pappl_ilayout_t	layout;		// Image layout
+  bool			ret;		// Return value
 
-  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "ileft=%u, itop=%u, iwidth=%u, iheight=%u", ileft, itop, iwidth, iheight);
 
-  if (iwidth == 0 || iheight == 0)
-  {
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Invalid media size");
+  // Figure out the orientation of the image...
+  if (!image_layout(job, options, width, height, &layout))
     return (false);
-  }
-
-  // Figure out the scaling and rotation of the image...
-  if (options->orientation_requested == IPP_ORIENT_NONE)
-  {
-    if (width > height && options->header.cupsWidth < options->header.cupsHeight)
-    {
-      options->orientation_requested = IPP_ORIENT_LANDSCAPE;
-      papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Auto-orientation: landscape");
-    }
-    else
-    {
-      options->orientation_requested = IPP_ORIENT_PORTRAIT;
-      papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Auto-orientation: portrait");
-    }
-  }
-
-  switch (options->orientation_requested)
-  {
-    default :
-    case IPP_ORIENT_PORTRAIT :
-        pixbase    = pixels;
-        img_width  = width;
-        img_height = height;
-        xdir       = depth;
-        ydir       = depth * width;
-
-	xsize = iwidth;
-	ysize = xsize * height / width;
-	if (ysize > iheight)
-	{
-	  ysize = iheight;
-	  xsize = ysize * width / height;
-	}
-	break;
 
-    case IPP_ORIENT_REVERSE_PORTRAIT :
-        pixbase    = pixels + depth * width * height - depth;
-        img_width  = width;
-        img_height = height;
-        xdir       = -depth;
-        ydir       = -depth * width;
-
-	xsize = iwidth;
-	ysize = xsize * height / width;
-	if (ysize > iheight)
-	{
-	  ysize = iheight;
-	  xsize = ysize * width / height;
-	}
-	break;
-
-    case IPP_ORIENT_LANDSCAPE : // 90 counter-clockwise
-        pixbase    = pixels + width - depth;
-        img_width  = height;
-        img_height = width;
-        xdir       = depth * width;
-        ydir       = -depth;
-
-	xsize = iwidth;
-	ysize = xsize * width / height;
-	if (ysize > iheight)
-	{
-	  ysize = iheight;
-	  xsize = ysize * height / width;
-	}
-	break;
-
-    case IPP_ORIENT_REVERSE_LANDSCAPE : // 90 clockwise
-        pixbase    = pixels + depth * (height - 1) * width;
-        img_width  = height;
-        img_height = width;
-        xdir       = -depth * width;
-        ydir       = depth;
-
-	xsize = iwidth;
-	ysize = xsize * width / height;
-	if (ysize > iheight)
-	{
-	  ysize = iheight;
-	  xsize = ysize * height / width;
-	}
-        break;
-  }
+  if (!image_init_buffer(&image, job, pixels, -1, width, height, depth, options->orientation_requested))
+    return (false);
 
   options->orientation_requested = IPP_ORIENT_PORTRAIT; // Don't rotate in the driver
 
-  xstart = ileft + (iwidth - xsize) / 2;
-  xend   = xstart + xsize;
-  ystart = itop + (iheight - ysize) / 2;
-  yend   = ystart + ysize;
-
-  xmod   = img_width % xsize;
-  xstep  = (img_width / xsize) * xdir;
-
-  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "xsize=%u, xstart=%u, xend=%u, xdir=%d, xmod=%d, xstep=%d", xsize, xstart, xend, xdir, xmod, xstep);
-  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "ysize=%u, ystart=%u, yend=%u, ydir=%d", ysize, ystart, yend, ydir);
-
-  papplPrinterGetPrintDriverData(papplJobGetPrinter(job), &driver_data);
-
-  // Start the job...
-  if (!(driver_data.rstartjob)(job, options, device))
-  {
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to start raster job.");
-    goto abort_job;
-  }
-
-  if (options->header.cupsColorSpace == CUPS_CSPACE_K || options->header.cupsColorSpace == CUPS_CSPACE_CMYK)
-    white = 0x00;
-  else
-    white = 0xff;
-
-  line = malloc(options->header.cupsBytesPerLine);
-
-  // Print every copy...
-  for (i = 0; i < options->copies; i ++)
-  {
-    if (!(driver_data.rstartpage)(job, options, device, 1))
-    {
-      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to start raster page.");
-      goto abort_job;
-    }
-
-    // Leading blank space...
-    memset(line, white, options->header.cupsBytesPerLine);
-    for (y = 0; y < ystart; y ++)
-    {
-      if (!(driver_data.rwrite)(job, options, device, y, line))
-      {
-	papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write raster line %u.", y);
-	goto abort_job;
-      }
-    }
-
-    // Now RIP the image...
-    for (; y < yend && !job->is_canceled; y ++)
-    {
-      pixptr = pixbase + ydir * (int)((y - ystart) * (img_height - 1) / (ysize - 1));
-
-      if (options->header.cupsBitsPerPixel == 1)
-      {
-        // Need to dither the image to 1-bit black...
-	dither = options->dither[y & 15];
-
-	for (x = xstart, lineptr = line + x / 8, bit = 128 >> (x & 7), byte = 0, xerr = xmod / 2; x < xend; x ++)
-	{
-	  // Dither the current pixel...
-	  if (*pixptr <= dither[x & 15])
-	    byte |= bit;
-
-	  // Advance to the next pixel...
-	  pixptr += xstep;
-	  xerr += xmod;
-	  if (xerr >= xsize)
-	  {
-	    // Accumulated error has overflowed, advance another pixel...
-	    xerr -= xsize;
-	    pixptr += xdir;
-	  }
-
-	  // and the next bit
-	  if (bit == 1)
-	  {
-	    // Current byte is "full", save it...
-	    *lineptr++ = byte;
-	    byte = 0;
-	    bit  = 128;
-	  }
-	  else
-	    bit /= 2;
-	}
-
-	if (bit < 128)
-	  *lineptr = byte;
-      }
-      else if (options->header.cupsColorSpace == CUPS_CSPACE_K)
-      {
-        // Need to invert the image...
-	for (x = xstart, lineptr = line + x, xerr = xmod / 2; x < xend; x ++)
-	{
-	  // Copy an inverted grayscale pixel...
-	  *lineptr++ = ~*pixptr;
-
-	  // Advance to the next pixel...
-	  pixptr += xstep;
-	  xerr += xmod;
-	  if (xerr >= xsize)
-	  {
-	    // Accumulated error has overflowed, advance another pixel...
-	    xerr -= xsize;
-	    pixptr += xdir;
-	  }
-	}
-      }
-      else
-      {
-        // Need to copy the image...
-        unsigned bpp = options->header.cupsBitsPerPixel / 8;
-
-	for (x = xstart, lineptr = line + x * bpp, xerr = -xmod / 2; x < xend; x ++)
-	{
-	  // Copy a grayscale or RGB pixel...
-	  memcpy(lineptr, pixptr, bpp);
-	  lineptr += bpp;
-
-	  // Advance to the next pixel...
-	  pixptr += xstep;
-	  xerr += xmod;
-	  if (xerr >= xsize)
-	  {
-	    // Accumulated error has overflowed, advance another pixel...
-	    xerr -= xsize;
-	    pixptr += xdir;
-	  }
-	}
-      }
-
-      if (!(driver_data.rwrite)(job, options, device, y, line))
-      {
-	papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write raster line %u.", y);
-	goto abort_job;
-      }
-    }
-
-    // Trailing blank space...
-    memset(line, white, options->header.cupsBytesPerLine);
-    for (; y < options->header.cupsHeight; y ++)
-    {
-      if (!(driver_data.rwrite)(job, options, device, y, line))
-      {
-	papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write raster line %u.", y);
-	goto abort_job;
-      }
-    }
-
-    // End the page...
-    if (!(driver_data.rendpage)(job, options, device, 1))
-    {
-      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to end raster page.");
-      goto abort_job;
-    }
-
-    papplJobSetImpressionsCompleted(job, 1);
-  }
-
-  // End the job...
-  if (!(driver_data.rendjob)(job, options, device))
-  {
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to end raster job.");
-    goto abort_job;
-  }
-
-  // Free memory and return...
-  free(line);
-
-  return (true);
-
-  // Abort the job...
-  abort_job:
+  // Print the image...
+  ret = filter_image(job, device, options, &image, smoothing);
 
-  free(line);
+  free(image.row);
 
-  return (false);
+  return (ret);
 }
 
 
 //
 // '_papplJobFilterJPEG()' - Filter a JPEG image file.
 //
+// Portrait images are decoded a line at a time as they are printed, so only
+// a single line of the image is kept in memory.  Reverse portrait images are
+// decoded to a spool file and read back a line at a time from the bottom.
+// Landscape images need the whole image in memory, which is decoded at a
+// reduced size when the image is much larger than the printable area.
+//
 
 #ifdef HAVE_LIBJPEG
 bool
@@ -405,88 +228,177 @@ _papplJobFilterJPEG(
     void           *data)		// I - Filter data (unused)
 {
   const char		*filename;	// JPEG filename
-  FILE			*fp;		// JPEG file
   pappl_poptions_t	options;	// Job options
-  struct jpeg_decompress_struct	dinfo;	// Decompressor info
-  _pappl_jpeg_err_t	jerr;		// Error handler info
+  _pappl_jpeg_t		jpeg;		// JPEG decoder data
+  _pappl_image_t	image;		// Image row source
+  _pappl_ilayout_t	layout;		// Image layout
+  unsigned		need_width,	// Needed width of image
+			need_height;	// Needed height of image
   unsigned char		*pixels = NULL;	// Image pixels
+  size_t		bytes;		// Bytes of image data in memory
   JSAMPROW		row;		// Sample row pointer
   bool			ret = false;	// Return value
 
 
   (void)data;
 
+  memset(&jpeg, 0, sizeof(jpeg));
+  memset(&image, 0, sizeof(image));
+
+  jpeg.fd  = -1;
+  jpeg.rfd = -1;
+
   // Open the JPEG file...
   filename = papplJobGetFilename(job);
-  if ((fp = fopen(filename, "rb")) == NULL)
+  if ((jpeg.fp = fopen(filename, "rb")) == NULL)
   {
     papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open JPEG file '%s': %s", filename, strerror(errno));
     return (false);
   }
 
   // Read the image header...
-  jpeg_std_error(&jerr.jerr);
-  jerr.jerr.error_exit = jpeg_error_handler;
+  jpeg_std_error(&jpeg.jerr.jerr);
+  jpeg.jerr.jerr.error_exit = jpeg_error_handler;
 
-  if (setjmp(jerr.retbuf))
+  if (setjmp(jpeg.jerr.retbuf))
   {
     // JPEG library errors are directed to this point...
     papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_FORMAT_ERROR, PAPPL_JREASON_NONE);
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open JPEG file '%s': %s", filename, jerr.message);
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open JPEG file '%s': %s", filename, jpeg.jerr.message);
     ret = false;
     goto finish_jpeg;
   }
 
-  dinfo.err = (struct jpeg_error_mgr *)&jerr;
-  jpeg_create_decompress(&dinfo);
-  jpeg_stdio_src(&dinfo, fp);
-  jpeg_read_header(&dinfo, TRUE);
+  jpeg.dinfo.err = (struct jpeg_error_mgr *)&jpeg.jerr;
+  jpeg_create_decompress(&jpeg.dinfo);
+  jpeg_stdio_src(&jpeg.dinfo, jpeg.fp);
+  jpeg_read_header(&jpeg.dinfo, TRUE);
 
   // Get job options and request the image data in the format we need...
-  papplJobGetPrintOptions(job, &options, 1, dinfo.num_components > 1);
+  papplJobGetPrintOptions(job, &options, 1, jpeg.dinfo.num_components > 1);
+
+  jpeg.out_color_space = options.header.cupsNumColors == 1 ? JCS_GRAYSCALE : JCS_RGB;
+  jpeg.scale_denom     = 1;
 
-  dinfo.quantize_colors = FALSE;
+  // Figure out how big the image will be on the page, and then decode at a
+  // reduced size that is still at least that big...
+  if (!image_layout(job, &options, jpeg.dinfo.image_width, jpeg.dinfo.image_height, &layout))
+    goto finish_jpeg;
 
-  if (options.header.cupsNumColors == 1)
+  if (options.orientation_requested == IPP_ORIENT_LANDSCAPE || options.orientation_requested == IPP_ORIENT_REVERSE_LANDSCAPE)
   {
-    dinfo.out_color_space      = JCS_GRAYSCALE;
-    dinfo.out_color_components = 1;
-    dinfo.output_components    = 1;
+    need_width  = layout.ysize;
+    need_height = layout.xsize;
   }
   else
   {
-    dinfo.out_color_space      = JCS_RGB;
-    dinfo.out_color_components = 3;
-    dinfo.output_components    = 3;
+    need_width  = layout.xsize;
+    need_height = layout.ysize;
   }
 
-  jpeg_calc_output_dimensions(&dinfo);
+  while (jpeg.scale_denom < 8 && jpeg.dinfo.image_width >= 2 * jpeg.scale_denom * need_width && jpeg.dinfo.image_height >= 2 * jpeg.scale_denom * need_height)
+    jpeg.scale_denom *= 2;
+
+  jpeg_setup(&jpeg);
 
-  papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Loading %dx%dx%d JPEG image.", dinfo.output_width, dinfo.output_height, dinfo.output_components);
+  papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Loading %dx%dx%d JPEG image (1/%u scale).", jpeg.dinfo.output_width, jpeg.dinfo.output_height, jpeg.dinfo.output_components, jpeg.scale_denom);
 
-  if ((pixels = (unsigned char *)malloc((size_t)(dinfo.output_width * dinfo.output_height * dinfo.output_components))) == NULL)
+  jpeg_start_decompress(&jpeg.dinfo);
+
+  if (options.orientation_requested == IPP_ORIENT_PORTRAIT)
   {
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for %dx%dx%d JPEG image.", dinfo.output_width, dinfo.output_height, dinfo.output_components);
-    papplJobSetReasons(job, PAPPL_JREASON_ERRORS_DETECTED, PAPPL_JREASON_NONE);
-    goto finish_jpeg;
+    // Decode lines as they are needed...
+    bytes = (size_t)jpeg.dinfo.output_width * (size_t)jpeg.dinfo.output_components;
+
+    image.job       = job;
+    image.width     = jpeg.dinfo.output_width;
+    image.height    = jpeg.dinfo.output_height;
+    image.depth     = (unsigned)jpeg.dinfo.output_components;
+    image.row_cb    = jpeg_row;
+    image.rewind_cb = jpeg_rewind;
+    image.data      = &jpeg;
+
+    if ((image.row = malloc(bytes)) == NULL)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for JPEG image.");
+      papplJobSetReasons(job, PAPPL_JREASON_ERRORS_DETECTED, PAPPL_JREASON_NONE);
+      goto finish_jpeg;
+    }
   }
+  else if (options.orientation_requested == IPP_ORIENT_REVERSE_PORTRAIT)
+  {
+    // Decode lines to a spool file and read them back in reverse order...
+    bytes = (size_t)jpeg.dinfo.output_width * (size_t)jpeg.dinfo.output_components;
+
+    if ((pixels = (unsigned char *)malloc(bytes)) == NULL)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for JPEG image.");
+      papplJobSetReasons(job, PAPPL_JREASON_ERRORS_DETECTED, PAPPL_JREASON_NONE);
+      goto finish_jpeg;
+    }
+
+    if ((jpeg.fd = image_create_spool(job, "jpeg", &jpeg.rfd)) < 0)
+    {
+      papplJobSetReasons(job, PAPPL_JREASON_ERRORS_DETECTED, PAPPL_JREASON_NONE);
+      goto finish_jpeg;
+    }
 
-  jpeg_start_decompress(&dinfo);
+    row = (JSAMPROW)pixels;
+
+    while (jpeg.dinfo.output_scanline < jpeg.dinfo.output_height)
+    {
+      jpeg_read_scanlines(&jpeg.dinfo, &row, 1);
+
+      if (write(jpeg.fd, pixels, bytes) < (ssize_t)bytes)
+      {
+        papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write JPEG spool file: %s", strerror(errno));
+        papplJobSetReasons(job, PAPPL_JREASON_ERRORS_DETECTED, PAPPL_JREASON_NONE);
+        goto finish_jpeg;
+      }
+    }
 
-  while (dinfo.output_scanline < dinfo.output_height)
+    if (!image_init_buffer(&image, job, NULL, jpeg.rfd, jpeg.dinfo.output_width, jpeg.dinfo.output_height, (unsigned)jpeg.dinfo.output_components, options.orientation_requested))
+      goto finish_jpeg;
+  }
+  else
   {
-    row = (JSAMPROW)(pixels + (size_t)dinfo.output_scanline * (size_t)dinfo.output_width * (size_t)dinfo.output_components);
-    jpeg_read_scanlines(&dinfo, &row, 1);
+    // Decode the whole image...
+    bytes = (size_t)jpeg.dinfo.output_width * (size_t)jpeg.dinfo.output_height * (size_t)jpeg.dinfo.output_components;
+
+    if ((pixels = (unsigned char *)malloc(bytes)) == NULL)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for %dx%dx%d JPEG image.", jpeg.dinfo.output_width, jpeg.dinfo.output_height, jpeg.dinfo.output_components);
+      papplJobSetReasons(job, PAPPL_JREASON_ERRORS_DETECTED, PAPPL_JREASON_NONE);
+      goto finish_jpeg;
+    }
+
+    while (jpeg.dinfo.output_scanline < jpeg.dinfo.output_height)
+    {
+      row = (JSAMPROW)(pixels + (size_t)jpeg.dinfo.output_scanline * (size_t)jpeg.dinfo.output_width * (size_t)jpeg.dinfo.output_components);
+      jpeg_read_scanlines(&jpeg.dinfo, &row, 1);
+    }
+
+    if (!image_init_buffer(&image, job, pixels, -1, jpeg.dinfo.output_width, jpeg.dinfo.output_height, (unsigned)jpeg.dinfo.output_components, options.orientation_requested))
+      goto finish_jpeg;
   }
 
-  ret = papplJobFilterImage(job, device, &options, pixels, dinfo.output_width, dinfo.output_height, dinfo.output_components, true);
+  papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Using %lu bytes for JPEG image data.", (unsigned long)bytes);
+
+  options.orientation_requested = IPP_ORIENT_PORTRAIT; // Don't rotate in the driver
+
+  ret = filter_image(job, device, &options, &image, true);
 
   finish_jpeg:
 
   free(pixels);
-  jpeg_finish_decompress(&dinfo);
-  jpeg_destroy_decompress(&dinfo);
-  fclose(fp);
+  free(image.row);
+  jpeg_destroy_decompress(&jpeg.dinfo);
+  fclose(jpeg.fp);
+
+  if (jpeg.fd >= 0)
+    close(jpeg.fd);
+  if (jpeg.rfd >= 0)
+    close(jpeg.rfd);
 
   return (ret);
 }
@@ -494,7 +406,12 @@ _papplJobFilterJPEG(
 
 
 //
-// 'process_png()' - Process a PNG image file.
+// '_papplJobFilterPNG()' - Filter a PNG image file.
+//
+// Non-interlaced portrait images are decoded a line at a time as they are
+// printed.  Non-interlaced images in other orientations are decoded to a
+// spool file and read back a line or strip of lines at a time.  Only
+// interlaced images are decoded to a buffer holding the whole image.
 //
 
 #ifdef HAVE_LIBPNG
@@ -504,89 +421,1665 @@ _papplJobFilterPNG(
     pappl_device_t *device,		// I - Device
     void           *data)		// I - Filter data (unused)
 {
+  const char		*filename;	// PNG filename
   pappl_poptions_t	options;	// Job options
-  png_image		png;		// PNG image data
-  png_color		bg;		// Background color
-  int			png_bpp;	// Bytes per pixel
+  _pappl_png_t		png;		// PNG decoder data
+  _pappl_image_t	image;		// Image row source
+  _pappl_ilayout_t	layout;		// Image layout
   unsigned char		*pixels = NULL;	// Image pixels
+  size_t		bytes;		// Bytes of image data in memory
   bool			ret = false;	// Return value
 
 
-  // Load the PNG...
   (void)data;
 
   memset(&png, 0, sizeof(png));
-  png.version = PNG_IMAGE_VERSION;
+  memset(&image, 0, sizeof(image));
 
-  bg.red = bg.green = bg.blue = 255;
+  png.fd  = -1;
+  png.rfd = -1;
 
-  png_image_begin_read_from_file(&png, job->filename);
+  // Open the PNG file...
+  png.job  = job;
+  filename = papplJobGetFilename(job);
 
-  if (png.warning_or_error & PNG_IMAGE_ERROR)
+  if ((png.fp = fopen(filename, "rb")) == NULL)
   {
-    papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_FORMAT_ERROR, PAPPL_JREASON_NONE);
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open PNG file '%s': %s", job->filename, png.message);
-    goto finish_job;
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open PNG file '%s': %s", filename, strerror(errno));
+    return (false);
   }
 
-  papplLogJob(job, PAPPL_LOGLEVEL_INFO, "PNG image is %ux%u", png.width, png.height);
-
-  // Prepare options...
-  papplJobGetPrintOptions(job, &options, 1, (png.format & PNG_FORMAT_FLAG_COLOR) != 0);
-
-  if (png.format & PNG_FORMAT_FLAG_COLOR)
-  {
-    png.format = PNG_FORMAT_RGB;
-    png_bpp    = 3;
-  }
-  else
+  // Read the image header...
+  if (!png_begin(&png))
   {
-    png.format = PNG_FORMAT_GRAY;
-    png_bpp    = 1;
+    papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_FORMAT_ERROR, PAPPL_JREASON_NONE);
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open PNG file '%s': %s", filename, png.message);
+    goto finish_png;
   }
 
-  pixels = malloc(PNG_IMAGE_SIZE(png));
+  // Get job options and request the image data in the format we need...
+  papplJobGetPrintOptions(job, &options, 1, (png_get_color_type(png.pp, png.info) & PNG_COLOR_MASK_COLOR) != 0);
 
-  png_image_finish_read(&png, &bg, pixels, 0, NULL);
+  png.gray = options.header.cupsNumColors == 1;
 
-  if (png.warning_or_error & PNG_IMAGE_ERROR)
+  if (!png_setup(&png))
   {
     papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_FORMAT_ERROR, PAPPL_JREASON_NONE);
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open PNG file '%s': %s", job->filename, png.message);
-    goto finish_job;
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open PNG file '%s': %s", filename, png.message);
+    goto finish_png;
   }
 
-  // Print the image...
-  ret = papplJobFilterImage(job, device, &options, pixels, png.width, png.height, png_bpp, false);
-
+  papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Loading %ux%ux%u%s PNG image.", png.width, png.height, png.depth, png.passes > 1 ? " interlaced" : "");
 
-  finish_job:
+  if (!image_layout(job, &options, png.width, png.height, &layout))
+    goto finish_png;
 
-  // Free the image data when we're done...
-  png_image_free(&png);
-  free(pixels);
+  bytes = (size_t)png.width * (size_t)png.depth;
 
-  return (ret);
-}
-#endif // HAVE_LIBPNG
+  if (options.orientation_requested == IPP_ORIENT_PORTRAIT && png.passes == 1)
+  {
+    // Decode lines as they are needed...
+    image.job       = job;
+    image.width     = png.width;
+    image.height    = png.height;
+    image.depth     = png.depth;
+    image.row_cb    = png_row;
+    image.rewind_cb = png_rewind;
+    image.data      = &png;
+
+    if ((image.row = malloc(bytes)) == NULL)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for PNG image.");
+      papplJobSetReasons(job, PAPPL_JREASON_ERRORS_DETECTED, PAPPL_JREASON_NONE);
+      goto finish_png;
+    }
+  }
+  else if (png.passes == 1)
+  {
+    // Decode lines to a spool file and read them back in the order they are
+    // printed...
+    if ((pixels = (unsigned char *)malloc(bytes)) == NULL)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for PNG image.");
+      papplJobSetReasons(job, PAPPL_JREASON_ERRORS_DETECTED, PAPPL_JREASON_NONE);
+      goto finish_png;
+    }
+
+    if ((png.fd = image_create_spool(job, "png", &png.rfd)) < 0)
+    {
+      papplJobSetReasons(job, PAPPL_JREASON_ERRORS_DETECTED, PAPPL_JREASON_NONE);
+      goto finish_png;
+    }
+
+    while (png.y < png.height)
+    {
+      if (!png_read_line(&png, pixels))
+      {
+        papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_FORMAT_ERROR, PAPPL_JREASON_NONE);
+        papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read PNG image: %s", png.message);
+        goto finish_png;
+      }
+
+      if (write(png.fd, pixels, bytes) < (ssize_t)bytes)
+      {
+        papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write PNG spool file: %s", strerror(errno));
+        papplJobSetReasons(job, PAPPL_JREASON_ERRORS_DETECTED, PAPPL_JREASON_NONE);
+        goto finish_png;
+      }
+    }
+
+    if (!image_init_buffer(&image, job, NULL, png.rfd, png.width, png.height, png.depth, options.orientation_requested))
+      goto finish_png;
+  }
+  else
+  {
+    // Decode the whole interlaced image...
+    bytes *= png.height;
+
+    if ((pixels = (unsigned char *)malloc(bytes)) == NULL)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for %ux%ux%u PNG image.", png.width, png.height, png.depth);
+      papplJobSetReasons(job, PAPPL_JREASON_ERRORS_DETECTED, PAPPL_JREASON_NONE);
+      goto finish_png;
+    }
+
+    if (!png_read_pixels(&png, pixels))
+    {
+      papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_FORMAT_ERROR, PAPPL_JREASON_NONE);
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read PNG image: %s", png.message);
+      goto finish_png;
+    }
+
+    if (!image_init_buffer(&image, job, pixels, -1, png.width, png.height, png.depth, options.orientation_requested))
+      goto finish_png;
+  }
+
+  papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Using %lu bytes for PNG image data.", (unsigned long)bytes);
+
+  options.orientation_requested = IPP_ORIENT_PORTRAIT; // Don't rotate in the driver
+
+  ret = filter_image(job, device, &options, &image, false);
+
+  finish_png:
+
+  free(pixels);
+  free(image.row);
+  if (png.pp)
+    png_destroy_read_struct(&png.pp, &png.info, NULL);
+  fclose(png.fp);
+
+  if (png.fd >= 0)
+    close(png.fd);
+  if (png.rfd >= 0)
+    close(png.rfd);
+
+  return (ret);
+}
+#endif // HAVE_LIBPNG
+
+
+//
+// 'filter_image()' - Print an image from a row source.
+//
+// The image must already be rotated for the page, with the
+// "orientation_requested" option set to portrait.
+//
+
+static bool				// O - `true` on success, `false` otherwise
+filter_image(
+    pappl_job_t         *job,		// I - Job
+    pappl_device_t      *device,	// I - Device
+    pappl_poptions_t    *options,	// I - Print options
+    _pappl_image_t      *image,		// I - Image row source
+    bool		smoothing)	// I - `true` to smooth/interpolate the image, `false` for nearest-neighbor sampling
+{
+  int			i,		// Looping var
+			copies;		// Number of copies to render
+  pappl_pdriver_data_t	driver_data;	// Printer driver data
+  _pappl_ilayout_t	layout;		// Image layout
+  unsigned char		white,		// White color
+			*line = NULL,	// Output line
+			*lineptr,	// Pointer in line
+			*sample = NULL,	// Sampled pixels for dithering
+			*sampleptr;	// Pointer in samples
+  const unsigned char	*pixptr;	// Pointer into image
+  unsigned		depth = image->depth,
+					// Bytes per pixel
+			bpp,		// Bytes per output pixel
+			x,		// X position
+			xstep,		// X step
+			y;		// Y position
+  int			xerr,		// X error accumulator
+			xmod;		// X modulus
+  _pappl_scale_t	*scale = NULL;	// Bilinear scaler, if any
+  _pappl_pcache_t	*pcache = NULL;	// Rendered page cache, if any
+
+
+  // Images contain a single page/impression...
+  papplJobSetImpressions(job, 1);
+
+  if (!image_layout(job, options, image->width, image->height, &layout))
+    return (false);
+
+  if (smoothing)
+  {
+    // Scaled lines have one pixel per column...
+    if ((scale = _papplJobScaleCreate(image->width, image->height, depth, layout.xsize, layout.ysize)) == NULL)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for image scaling.");
+      return (false);
+    }
+
+    xmod  = 0;
+    xstep = depth;
+  }
+  else
+  {
+    xmod  = (int)(image->width % layout.xsize);
+    xstep = (image->width / layout.xsize) * depth;
+  }
+
+  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "ileft=%u, itop=%u, iwidth=%u, iheight=%u", layout.ileft, layout.itop, layout.iwidth, layout.iheight);
+  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "xsize=%u, xstart=%u, xend=%u, xmod=%d, xstep=%u", layout.xsize, layout.xstart, layout.xend, xmod, xstep);
+  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "ysize=%u, ystart=%u, yend=%u", layout.ysize, layout.ystart, layout.yend);
+
+  papplPrinterGetPrintDriverData(papplJobGetPrinter(job), &driver_data);
+
+  if (job->prerip_ras)
+  {
+    // Capture the raster data in the pre-RIP file instead of printing it...
+    driver_data.rendjob    = prerip_rendjob;
+    driver_data.rendpage   = prerip_rendpage;
+    driver_data.rstartjob  = prerip_rstartjob;
+    driver_data.rstartpage = prerip_rstartpage;
+    driver_data.rwrite     = prerip_rwrite;
+
+    // Only one copy is pre-RIPped, the rest are sent from the pre-RIP file...
+    copies = 1;
+  }
+  else
+    copies = options->copies;
+
+  // Start the job...
+  if (!(driver_data.rstartjob)(job, options, device))
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to start raster job.");
+    goto abort_job;
+  }
+
+  if (options->header.cupsColorSpace == CUPS_CSPACE_K || options->header.cupsColorSpace == CUPS_CSPACE_CMYK)
+    white = 0x00;
+  else
+    white = 0xff;
+
+  bpp = options->header.cupsBitsPerPixel / 8;
+
+  if ((line = malloc(options->header.cupsBytesPerLine)) == NULL || (options->header.cupsBitsPerPixel == 1 && (sample = malloc(layout.xsize)) == NULL))
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for raster line.");
+    papplJobSetReasons(job, PAPPL_JREASON_ERRORS_DETECTED, PAPPL_JREASON_NONE);
+    goto abort_job;
+  }
+
+  // Keep the first copy for the rest...
+  if (copies > 1)
+    pcache = pcache_create(job, options->header.cupsBytesPerLine);
+
+  // Print every copy...
+  for (i = 0; i < copies; i ++)
+  {
+    if (i > 0 && pcache)
+    {
+      // Send the cached page...
+      if (!pcache_replay(pcache, options, device, &driver_data, line))
+        goto abort_job;
+
+      if (!job->prerip_ras)
+        papplJobSetImpressionsCompleted(job, 1);
+      continue;
+    }
+
+    if (i > 0 && image->rewind_cb && !(image->rewind_cb)(image))
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read image for copy %d.", i + 1);
+      goto abort_job;
+    }
+
+    if (!(driver_data.rstartpage)(job, options, device, 1))
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to start raster page.");
+      goto abort_job;
+    }
+
+    // Leading blank space...
+    memset(line, white, options->header.cupsBytesPerLine);
+    for (y = 0; y < layout.ystart; y ++)
+    {
+      if (!(driver_data.rwrite)(job, options, device, y, line))
+      {
+	papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write raster line %u.", y);
+	goto abort_job;
+      }
+
+      if (pcache && !pcache_add(pcache, line))
+      {
+        pcache_delete(pcache);
+        pcache = NULL;
+      }
+    }
+
+    // Now RIP the image...
+    for (; y < layout.yend && !job->is_canceled; y ++)
+    {
+      if (scale)
+        pixptr = _papplJobScaleGetLine(scale, y - layout.ystart, (_pappl_scale_cb_t)image->row_cb, image);
+      else
+        pixptr = (image->row_cb)(image, layout.ysize > 1 ? (y - layout.ystart) * (image->height - 1) / (layout.ysize - 1) : 0);
+
+      if (!pixptr)
+      {
+	papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read image line %u.", y - layout.ystart);
+	goto abort_job;
+      }
+
+      if (options->header.cupsBitsPerPixel == 1 && xstep == 1 && xmod == 0)
+      {
+        // Dither the image pixels directly...
+        _papplJobDitherLine(line, pixptr, layout.xstart, layout.xsize, options->dither[y & 15], false);
+      }
+      else if (options->header.cupsBitsPerPixel == 1)
+      {
+        // Need to dither the image to 1-bit black...
+	for (x = layout.xstart, sampleptr = sample, xerr = xmod / 2; x < layout.xend; x ++)
+	{
+	  // Copy the current pixel...
+	  *sampleptr++ = *pixptr;
+
+	  // Advance to the next pixel...
+	  pixptr += xstep;
+	  xerr += xmod;
+	  if (xerr >= (int)layout.xsize)
+	  {
+	    // Accumulated error has overflowed, advance another pixel...
+	    xerr -= (int)layout.xsize;
+	    pixptr += depth;
+	  }
+	}
+
+	_papplJobDitherLine(line, sample, layout.xstart, layout.xsize, options->dither[y & 15], false);
+      }
+      else if (options->header.cupsColorSpace == CUPS_CSPACE_K)
+      {
+        // Need to invert the image...
+	for (x = layout.xstart, lineptr = line + x, xerr = xmod / 2; x < layout.xend; x ++)
+	{
+	  // Copy an inverted grayscale pixel...
+	  *lineptr++ = ~*pixptr;
+
+	  // Advance to the next pixel...
+	  pixptr += xstep;
+	  xerr += xmod;
+	  if (xerr >= (int)layout.xsize)
+	  {
+	    // Accumulated error has overflowed, advance another pixel...
+	    xerr -= (int)layout.xsize;
+	    pixptr += depth;
+	  }
+	}
+      }
+      else if (bpp == depth && xstep == depth && xmod == 0)
+      {
+        // Copy the image pixels directly...
+        memcpy(line + layout.xstart * bpp, pixptr, layout.xsize * bpp);
+      }
+      else
+      {
+        // Need to copy the image...
+	for (x = layout.xstart, lineptr = line + x * bpp, xerr = -xmod / 2; x < layout.xend; x ++)
+	{
+	  // Copy a grayscale or RGB pixel...
+	  if (bpp == depth)
+	    memcpy(lineptr, pixptr, bpp);
+	  else if (bpp > depth)
+	    memset(lineptr, *pixptr, bpp);
+	  else
+	    *lineptr = *pixptr;
+
+	  lineptr += bpp;
+
+	  // Advance to the next pixel...
+	  pixptr += xstep;
+	  xerr += xmod;
+	  if (xerr >= (int)layout.xsize)
+	  {
+	    // Accumulated error has overflowed, advance another pixel...
+	    xerr -= (int)layout.xsize;
+	    pixptr += depth;
+	  }
+	}
+      }
+
+      if (!(driver_data.rwrite)(job, options, device, y, line))
+      {
+	papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write raster line %u.", y);
+	goto abort_job;
+      }
+
+      if (pcache && !pcache_add(pcache, line))
+      {
+        pcache_delete(pcache);
+        pcache = NULL;
+      }
+    }
+
+    // Trailing blank space...
+    memset(line, white, options->header.cupsBytesPerLine);
+    for (; y < options->header.cupsHeight; y ++)
+    {
+      if (!(driver_data.rwrite)(job, options, device, y, line))
+      {
+	papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write raster line %u.", y);
+	goto abort_job;
+      }
+
+      if (pcache && !pcache_add(pcache, line))
+      {
+        pcache_delete(pcache);
+        pcache = NULL;
+      }
+    }
+
+    // End the page...
+    if (!(driver_data.rendpage)(job, options, device, 1))
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to end raster page.");
+      goto abort_job;
+    }
+
+    if (!job->prerip_ras)
+      papplJobSetImpressionsCompleted(job, 1);
+  }
+
+  // End the job...
+  if (!(driver_data.rendjob)(job, options, device))
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to end raster job.");
+    goto abort_job;
+  }
+
+  // Free memory and return...
+  free(line);
+  free(sample);
+  _papplJobScaleDelete(scale);
+  pcache_delete(pcache);
+
+  return (true);
+
+  // Abort the job...
+  abort_job:
+
+  free(line);
+  free(sample);
+  _papplJobScaleDelete(scale);
+  pcache_delete(pcache);
+
+  return (false);
+}
+
+
+//
+// 'image_buffer_row()' - Get a row from an in-memory or spooled image.
+//
+// Rows of rotated images are copied to the row buffer.  Landscape images are
+// rotated a strip of lines at a time so that the image is read sequentially
+// rather than a column at a time.  Lines of spooled images are read into the
+// row buffer - reverse portrait lines are read into the second half of the
+// buffer and then copied in reverse order to the first half.
+//
+
+static const unsigned char *		// O - Row pixels or `NULL` on error
+image_buffer_row(
+    _pappl_image_t *image,		// I - Image row source
+    unsigned       y)			// I - Row number
+{
+  const unsigned char	*src;		// Source pixel
+  unsigned char		*dst;		// Destination pixel
+  unsigned		x,		// Column number
+			depth = image->depth;
+					// Bytes per pixel
+  size_t		stride = (size_t)image->pwidth * depth;
+					// Bytes per line in image
+  ssize_t		rbytes = 0;	// Bytes read
+
+
+  switch (image->orient)
+  {
+    default :
+    case IPP_ORIENT_PORTRAIT :
+        if (image->pixels)
+          return (image->pixels + y * stride);
+
+        if ((rbytes = pread(image->fd, image->row, stride, (off_t)(y * stride))) < (ssize_t)stride)
+          break;
+
+        return (image->row);
+
+    case IPP_ORIENT_REVERSE_PORTRAIT :
+        // Line from the bottom of the image, right to left...
+        if (image->pixels)
+        {
+          src = image->pixels + (image->pheight - 1 - y) * stride + stride - depth;
+        }
+        else if ((rbytes = pread(image->fd, image->row + stride, stride, (off_t)((image->pheight - 1 - y) * stride))) < (ssize_t)stride)
+        {
+          break;
+        }
+        else
+        {
+          src = image->row + 2 * stride - depth;
+        }
+
+        for (x = 0, dst = image->row; x < image->width; x ++, src -= depth, dst += depth)
+          memcpy(dst, src, depth);
+
+        return (image->row);
+
+    case IPP_ORIENT_LANDSCAPE :
+    case IPP_ORIENT_REVERSE_LANDSCAPE :
+        if ((y < image->strip_y || y >= (image->strip_y + image->strip_lines)) && !image_rotate_strip(image, y))
+          return (NULL);
+
+        return (image->row + (size_t)(y - image->strip_y) * image->width * depth);
+  }
+
+  papplLogJob(image->job, PAPPL_LOGLEVEL_ERROR, "Unable to read image spool file: %s", rbytes < 0 ? strerror(errno) : "Short read");
+
+  return (NULL);
+}
+
+
+//
+// 'image_create_spool()' - Create a spool file for decoded image lines.
+//
+// The spool file is unlinked right away since it is only used while printing
+// the current job.
+//
+
+static int				// O - Spool file for writing or `-1` on error
+image_create_spool(pappl_job_t *job,	// I - Job
+                   const char  *ext,	// I - Filename extension
+                   int         *rfd)	// O - Spool file for reading
+{
+  int	fd;				// Spool file for writing
+  char	spoolname[1024];		// Spool filename
+
+
+  if ((fd = papplJobCreateFile(job, spoolname, sizeof(spoolname), job->system->directory, ext)) < 0)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to create image spool file: %s", strerror(errno));
+    return (-1);
+  }
+
+  if ((*rfd = open(spoolname, O_RDONLY | O_CLOEXEC)) < 0)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open image spool file: %s", strerror(errno));
+    close(fd);
+    fd = -1;
+  }
+
+  unlink(spoolname);
+
+  return (fd);
+}
+
+
+//
+// 'image_init_buffer()' - Initialize an image row source for an in-memory or spooled image.
+//
+// Spooled images are read from a file holding the lines of the image, top to
+// bottom, with no padding.
+//
+
+static bool				// O - `true` on success, `false` on failure
+image_init_buffer(
+    _pappl_image_t      *image,		// I - Image row source
+    pappl_job_t         *job,		// I - Job
+    const unsigned char *pixels,	// I - Pointer to the top-left corner of the image data or `NULL`
+    int                 fd,		// I - Spool file if `pixels` is `NULL`
+    unsigned            width,		// I - Width in columns
+    unsigned            height,		// I - Height in lines
+    unsigned            depth,		// I - Bytes per pixel
+    ipp_orient_t        orient)		// I - Orientation of image on the page
+{
+  size_t	bytes = 0;		// Size of row buffer
+
+
+  memset(image, 0, sizeof(_pappl_image_t));
+
+  image->job     = job;
+  image->depth   = depth;
+  image->row_cb  = image_buffer_row;
+  image->pixels  = pixels;
+  image->fd      = fd;
+  image->pwidth  = width;
+  image->pheight = height;
+  image->orient  = orient;
+
+  if (orient == IPP_ORIENT_LANDSCAPE || orient == IPP_ORIENT_REVERSE_LANDSCAPE)
+  {
+    image->width  = height;
+    image->height = width;
+  }
+  else
+  {
+    image->width  = width;
+    image->height = height;
+  }
+
+  // Landscape images need a strip of lines, plus a run of pixels from the
+  // spool file, and reverse portrait images need a line, plus the line from
+  // the spool file...
+  if (orient == IPP_ORIENT_LANDSCAPE || orient == IPP_ORIENT_REVERSE_LANDSCAPE)
+    bytes = (size_t)(image->width + (pixels ? 0 : 1)) * depth * _PAPPL_IMAGE_STRIP;
+  else if (orient == IPP_ORIENT_REVERSE_PORTRAIT)
+    bytes = (size_t)image->width * depth * (pixels ? 1 : 2);
+  else if (!pixels)
+    bytes = (size_t)image->width * depth;
+
+  if (bytes > 0 && (image->row = malloc(bytes)) == NULL)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for image lines.");
+    return (false);
+  }
+
+  return (true);
+}
+
+
+//
+// 'image_layout()' - Compute the scaled size and position of an image.
+//
+// If the "orientation_requested" option is `IPP_ORIENT_NONE`, it is set to
+// portrait or landscape to best fit the image on the page.
+//
+
+static bool				// O - `true` on success, `false` on error
+image_layout(
+    pappl_job_t      *job,		// I - Job
+    pappl_poptions_t *options,		// I - Print options
+    unsigned         width,		// I - Image width in columns
+    unsigned         height,		// I - Image height in lines
+    _pappl_ilayout_t *layout)		// O - Image layout
+{
+  unsigned	img_width,		// Rotated image width
+		img_height;		// Rotated image height
+
+
+  if (options->print_scaling == PAPPL_SCALING_FILL)
+  {
+    // Scale to fill the entire media area...
+    layout->ileft   = 0;
+    layout->itop    = 0;
+    layout->iwidth  = options->header.cupsWidth;
+    layout->iheight = options->header.cupsHeight;
+  }
+  else
+  {
+    // Scale/center within the margins...
+    layout->ileft   = options->media.left_margin * options->printer_resolution[0] / 2540;
+    layout->itop    = options->media.top_margin * options->printer_resolution[1] / 2540;
+    layout->iwidth  = options->header.cupsWidth - (options->media.left_margin + options->media.right_margin) * options->printer_resolution[0] / 2540;
+    layout->iheight = options->header.cupsHeight - (options->media.bottom_margin + options->media.top_margin) * options->printer_resolution[1] / 2540;
+  }
+
+  if (layout->iwidth == 0 || layout->iheight == 0 || width == 0 || height == 0)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Invalid media size");
+    return (false);
+  }
+
+  // Figure out the scaling and rotation of the image...
+  if (options->orientation_requested == IPP_ORIENT_NONE)
+  {
+    if (width > height && options->header.cupsWidth < options->header.cupsHeight)
+    {
+      options->orientation_requested = IPP_ORIENT_LANDSCAPE;
+      papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Auto-orientation: landscape");
+    }
+    else
+    {
+      options->orientation_requested = IPP_ORIENT_PORTRAIT;
+      papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Auto-orientation: portrait");
+    }
+  }
+
+  if (options->orientation_requested == IPP_ORIENT_LANDSCAPE || options->orientation_requested == IPP_ORIENT_REVERSE_LANDSCAPE)
+  {
+    img_width  = height;
+    img_height = width;
+  }
+  else
+  {
+    img_width  = width;
+    img_height = height;
+  }
+
+  layout->xsize = layout->iwidth;
+  layout->ysize = layout->xsize * img_height / img_width;
+  if (layout->ysize > layout->iheight)
+  {
+    layout->ysize = layout->iheight;
+    layout->xsize = layout->ysize * img_width / img_height;
+  }
+
+  if (layout->xsize == 0)
+    layout->xsize = 1;
+  if (layout->ysize == 0)
+    layout->ysize = 1;
+
+  layout->xstart = layout->ileft + (layout->iwidth - layout->xsize) / 2;
+  layout->xend   = layout->xstart + layout->xsize;
+  layout->ystart = layout->itop + (layout->iheight - layout->ysize) / 2;
+  layout->yend   = layout->ystart + layout->ysize;
+
+  return (true);
+}
+
+
+//
+// 'image_rotate_strip()' - Rotate a strip of lines from an in-memory or spooled image.
+//
+// Each line of the rotated image is a column of the source image, so the
+// strip is filled by walking down the source image once and copying a short
+// run of pixels from each line to the same column in every line of the
+// strip.  This keeps both the reads and writes within a few cache lines at a
+// time, and for spooled images means one small read per line of the source
+// image for each strip.
+//
+
+static bool				// O - `true` on success, `false` on error
+image_rotate_strip(
+    _pappl_image_t *image,		// I - Image row source
+    unsigned       y)			// I - First line in strip
+{
+  const unsigned char	*src;		// Source pixel
+  unsigned char		*dst,		// Destination pixel
+			*run;		// Run of pixels read from spool file
+  unsigned		x,		// Column in strip
+			i,		// Line in strip
+			lines,		// Number of lines in strip
+			line,		// Line in source image
+			col,		// First column of run in source image
+			depth = image->depth;
+					// Bytes per pixel
+  int			dir;		// Direction to next line in strip
+  size_t		stride = (size_t)image->pwidth * depth,
+					// Bytes per line in image
+			rowbytes = (size_t)image->width * depth,
+					// Bytes per line in strip
+			runbytes;	// Bytes in run
+  ssize_t		rbytes;		// Bytes read
+
+
+  if ((lines = image->height - y) > _PAPPL_IMAGE_STRIP)
+    lines = _PAPPL_IMAGE_STRIP;
+
+  image->strip_y     = y;
+  image->strip_lines = lines;
+
+  run      = image->row + rowbytes * _PAPPL_IMAGE_STRIP;
+  runbytes = (size_t)lines * depth;
+
+  for (x = 0; x < image->width; x ++)
+  {
+    if (image->orient == IPP_ORIENT_LANDSCAPE)
+    {
+      // 90 counter-clockwise: lines are columns from the right of the image,
+      // top to bottom...
+      line = x;
+      col  = image->pwidth - y - lines;
+      dir  = -(int)depth;
+    }
+    else
+    {
+      // 90 clockwise: lines are columns from the left of the image, bottom
+      // to top...
+      line = image->pheight - 1 - x;
+      col  = y;
+      dir  = (int)depth;
+    }
+
+    if (image->pixels)
+    {
+      src = image->pixels + line * stride + col * depth;
+    }
+    else if ((rbytes = pread(image->fd, run, runbytes, (off_t)(line * stride + col * depth))) < (ssize_t)runbytes)
+    {
+      papplLogJob(image->job, PAPPL_LOGLEVEL_ERROR, "Unable to read image spool file: %s", rbytes < 0 ? strerror(errno) : "Short read");
+      return (false);
+    }
+    else
+    {
+      src = run;
+    }
+
+    if (dir < 0)
+      src += runbytes - depth;
+
+    dst = image->row + x * depth;
+
+#ifdef __GNUC__
+    // The next lines of the image are not sequential in memory, so prefetch
+    // them before they are needed...
+    if (image->pixels && x + 8 < image->width)
+    {
+      const unsigned char *next = image->orient == IPP_ORIENT_LANDSCAPE ? src + 8 * stride : src - 8 * stride;
+					// Pixels in line x + 8
+
+      __builtin_prefetch(next);
+      __builtin_prefetch(next + dir * (int)(lines - 1));
+    }
+#endif // __GNUC__
+
+    if (depth == 1)
+    {
+      for (i = lines; i > 0; i --, src += dir, dst += rowbytes)
+        *dst = *src;
+    }
+    else if (depth == 3)
+    {
+      for (i = lines; i > 0; i --, src += dir, dst += rowbytes)
+      {
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
+      }
+    }
+    else
+    {
+      for (i = lines; i > 0; i --, src += dir, dst += rowbytes)
+        memcpy(dst, src, depth);
+    }
+  }
+
+  return (true);
+}
+
+
+#ifdef HAVE_LIBJPEG
+//
+// 'jpeg_error_handler()' - Handle JPEG errors by not exiting.
+//
+
+static void
+jpeg_error_handler(j_common_ptr p)	// I - JPEG data
+{
+  _pappl_jpeg_err_t	*jerr = (_pappl_jpeg_err_t *)p->err;
+					// JPEG error handler
+
+
+  // Save the error message in the string buffer...
+  (jerr->jerr.format_message)(p, jerr->message);
+
+  // Return to the point we called setjmp()...
+  longjmp(jerr->retbuf, 1);
+}
+#endif // HAVE_LIBJPEG
+
+
+#ifdef HAVE_LIBJPEG
+//
+// 'jpeg_rewind()' - Start decoding a JPEG image over.
+//
+
+static bool				// O - `true` on success, `false` on failure
+jpeg_rewind(_pappl_image_t *image)	// I - Image row source
+{
+  _pappl_jpeg_t	*jpeg = (_pappl_jpeg_t *)image->data;
+					// JPEG decoder data
+
+
+  if (setjmp(jpeg->jerr.retbuf))
+  {
+    // JPEG library errors are directed to this point...
+    papplLogJob(image->job, PAPPL_LOGLEVEL_ERROR, "Unable to read JPEG image: %s", jpeg->jerr.message);
+    return (false);
+  }
+
+  jpeg_abort_decompress(&jpeg->dinfo);
+  rewind(jpeg->fp);
+  jpeg_stdio_src(&jpeg->dinfo, jpeg->fp);
+  jpeg_read_header(&jpeg->dinfo, TRUE);
+  jpeg_setup(jpeg);
+  jpeg_start_decompress(&jpeg->dinfo);
+
+  return (true);
+}
+
+
+//
+// 'jpeg_row()' - Decode JPEG image lines up to the requested line.
+//
+
+static const unsigned char *		// O - Row pixels or `NULL` on error
+jpeg_row(_pappl_image_t *image,		// I - Image row source
+         unsigned       y)		// I - Row number
+{
+  _pappl_jpeg_t	*jpeg = (_pappl_jpeg_t *)image->data;
+					// JPEG decoder data
+  JSAMPROW	row = (JSAMPROW)image->row;
+					// Sample row pointer
+
+
+  if (setjmp(jpeg->jerr.retbuf))
+  {
+    // JPEG library errors are directed to this point...
+    papplJobSetReasons(image->job, PAPPL_JREASON_DOCUMENT_FORMAT_ERROR, PAPPL_JREASON_NONE);
+    papplLogJob(image->job, PAPPL_LOGLEVEL_ERROR, "Unable to read JPEG image: %s", jpeg->jerr.message);
+    return (NULL);
+  }
+
+  while (jpeg->dinfo.output_scanline <= y)
+    jpeg_read_scanlines(&jpeg->dinfo, &row, 1);
+
+  return (image->row);
+}
+
+
+//
+// 'jpeg_setup()' - Set the JPEG decompression parameters.
+//
+
+static void
+jpeg_setup(_pappl_jpeg_t *jpeg)		// I - JPEG decoder data
+{
+  jpeg->dinfo.quantize_colors = FALSE;
+  jpeg->dinfo.scale_num       = 1;
+  jpeg->dinfo.scale_denom     = jpeg->scale_denom;
+
+  if (jpeg->out_color_space == JCS_GRAYSCALE)
+  {
+    jpeg->dinfo.out_color_space      = JCS_GRAYSCALE;
+    jpeg->dinfo.out_color_components = 1;
+    jpeg->dinfo.output_components    = 1;
+  }
+  else
+  {
+    jpeg->dinfo.out_color_space      = JCS_RGB;
+    jpeg->dinfo.out_color_components = 3;
+    jpeg->dinfo.output_components    = 3;
+  }
+
+  jpeg_calc_output_dimensions(&jpeg->dinfo);
+}
+#endif // HAVE_LIBJPEG
+
+
+//
+// 'pcache_add()' - Add a line to the rendered page cache.
+//
+// Lines are compressed using PackBits and kept in memory until the cache
+// reaches `_PAPPL_PCACHE_MAX` bytes, after which they are written to a spool
+// file.
+//
+
+static bool				// O - `true` on success, `false` on error
+pcache_add(_pappl_pcache_t     *pc,	// I - Page cache
+           const unsigned char *line)	// I - Line
+{
+  size_t	len;			// Length of compressed line
+  unsigned	reclen;			// Record length
+  char		filename[1024];		// Spool filename
+
+
+  len    = pcache_pack(pc->packed + sizeof(reclen), line, pc->bytes);
+  reclen = (unsigned)len;
+
+  memcpy(pc->packed, &reclen, sizeof(reclen));
+  len += sizeof(reclen);
+
+  if (pc->fd < 0 && (pc->datalen + len) > _PAPPL_PCACHE_MAX)
+  {
+    // Move the cache to a spool file...
+    if ((pc->fd = papplJobCreateFile(pc->job, filename, sizeof(filename), pc->job->system->directory, "pcache")) < 0 || (pc->rfd = open(filename, O_RDONLY | O_CLOEXEC)) < 0)
+    {
+      papplLogJob(pc->job, PAPPL_LOGLEVEL_WARN, "Unable to create page cache file: %s", strerror(errno));
+      if (pc->fd >= 0)
+        unlink(filename);
+      return (false);
+    }
+
+    // The file is only used while printing this job...
+    unlink(filename);
+
+    papplLogJob(pc->job, PAPPL_LOGLEVEL_DEBUG, "Page cache is larger than %d bytes, using a spool file.", _PAPPL_PCACHE_MAX);
+  }
+
+  if ((pc->datalen + len) > pc->datasize)
+  {
+    if (pc->fd >= 0)
+    {
+      // Write the buffered lines to the spool file...
+      if (!pcache_flush(pc))
+        return (false);
+    }
+    else
+    {
+      // Grow the memory cache...
+      size_t		datasize = 2 * pc->datasize;
+					// New size of data buffer
+      unsigned char	*data;		// New data buffer
+
+      if (datasize > _PAPPL_PCACHE_MAX)
+        datasize = _PAPPL_PCACHE_MAX;
+
+      if ((data = realloc(pc->data, datasize)) == NULL)
+      {
+        papplLogJob(pc->job, PAPPL_LOGLEVEL_WARN, "Unable to allocate memory for page cache.");
+        return (false);
+      }
+
+      pc->data     = data;
+      pc->datasize = datasize;
+    }
+  }
+
+  memcpy(pc->data + pc->datalen, pc->packed, len);
+  pc->datalen += len;
+  pc->total   += len;
+
+  return (true);
+}
+
+
+//
+// 'pcache_create()' - Create a rendered page cache.
+//
+
+static _pappl_pcache_t *		// O - Page cache or `NULL` on error
+pcache_create(pappl_job_t *job,		// I - Job
+              unsigned    bytes)	// I - Bytes per line
+{
+  _pappl_pcache_t	*pc;		// Page cache
+  size_t		maxrec = sizeof(unsigned) + bytes + (bytes + 127) / 128;
+					// Maximum size of a line record
+
+
+  if ((pc = calloc(1, sizeof(_pappl_pcache_t))) == NULL)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_WARN, "Unable to allocate memory for page cache.");
+    return (NULL);
+  }
+
+  pc->job      = job;
+  pc->bytes    = bytes;
+  pc->datasize = 2 * maxrec > _PAPPL_PCACHE_BUFFER ? 2 * maxrec : _PAPPL_PCACHE_BUFFER;
+  pc->fd       = -1;
+  pc->rfd      = -1;
+
+  if ((pc->packed = malloc(maxrec)) == NULL || (pc->data = malloc(pc->datasize)) == NULL)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_WARN, "Unable to allocate memory for page cache.");
+    pcache_delete(pc);
+    return (NULL);
+  }
+
+  return (pc);
+}
+
+
+//
+// 'pcache_delete()' - Delete a rendered page cache.
+//
+
+static void
+pcache_delete(_pappl_pcache_t *pc)	// I - Page cache
+{
+  if (pc)
+  {
+    if (pc->fd >= 0)
+      close(pc->fd);
+    if (pc->rfd >= 0)
+      close(pc->rfd);
+
+    free(pc->packed);
+    free(pc->data);
+    free(pc);
+  }
+}
+
+
+//
+// 'pcache_flush()' - Write buffered lines to the page cache spool file.
+//
+
+static bool				// O - `true` on success, `false` on error
+pcache_flush(_pappl_pcache_t *pc)	// I - Page cache
+{
+  const unsigned char	*ptr;		// Pointer into data
+  ssize_t		bytes;		// Bytes written
+
+
+  for (ptr = pc->data; pc->datalen > 0; ptr += bytes, pc->datalen -= (size_t)bytes)
+  {
+    if ((bytes = write(pc->fd, ptr, pc->datalen)) < 0)
+    {
+      if (errno == EINTR || errno == EAGAIN)
+      {
+        bytes = 0;
+        continue;
+      }
+
+      papplLogJob(pc->job, PAPPL_LOGLEVEL_WARN, "Unable to write page cache file: %s", strerror(errno));
+      return (false);
+    }
+  }
+
+  return (true);
+}
+
+
+//
+// 'pcache_pack()' - Compress a line using PackBits.
+//
+// The output buffer must hold at least "bytes + (bytes + 127) / 128" bytes.
+//
+
+static size_t				// O - Number of compressed bytes
+pcache_pack(unsigned char       *dst,	// I - Output buffer
+            const unsigned char *src,	// I - Line
+            size_t              bytes)	// I - Bytes in line
+{
+  unsigned char		*dstptr = dst;	// Pointer into output buffer
+  const unsigned char	*start,		// Start of run or literal
+			*end = src + bytes;
+					// End of line
+  size_t		count;		// Bytes in run or literal
+
+
+  while (src < end)
+  {
+    if ((src + 2) < end && src[0] == src[1] && src[1] == src[2])
+    {
+      // Run of 3 to 128 identical bytes...
+      for (start = src, src += 3; src < end && *src == *start && (src - start) < 128; src ++);
+
+      count     = (size_t)(src - start);
+      *dstptr++ = (unsigned char)(257 - count);
+      *dstptr++ = *start;
+    }
+    else
+    {
+      // Literal of 1 to 128 bytes, up to the next run...
+      for (start = src, src ++; src < end && (src - start) < 128 && !((src + 2) < end && src[0] == src[1] && src[1] == src[2]); src ++);
+
+      count     = (size_t)(src - start);
+      *dstptr++ = (unsigned char)(count - 1);
+      memcpy(dstptr, start, count);
+      dstptr += count;
+    }
+  }
+
+  return ((size_t)(dstptr - dst));
+}
 
 
-#ifdef HAVE_LIBJPEG
 //
-// 'jpeg_error_handler()' - Handle JPEG errors by not exiting.
+// 'pcache_replay()' - Send a cached page to the driver.
+//
+
+static bool				// O - `true` on success, `false` on error
+pcache_replay(
+    _pappl_pcache_t      *pc,		// I - Page cache
+    pappl_poptions_t     *options,	// I - Print options
+    pappl_device_t       *device,	// I - Device
+    pappl_pdriver_data_t *driver_data,	// I - Driver callbacks
+    unsigned char        *line)		// I - Line buffer
+{
+  pappl_job_t	*job = pc->job;		// Job
+  unsigned	y,			// Current line
+		reclen;			// Record length
+  ssize_t	bytes;			// Bytes read
+
+
+  if (!pc->reading)
+  {
+    // Finish writing the first copy...
+    if (pc->fd >= 0 && !pcache_flush(pc))
+      return (false);
+
+    papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Cached page uses %lu bytes%s.", (unsigned long)pc->total, pc->fd >= 0 ? " in a spool file" : "");
+    pc->reading = true;
+  }
+
+  // Start at the beginning of the cache...
+  pc->datapos = 0;
+
+  if (pc->rfd >= 0)
+  {
+    lseek(pc->rfd, 0, SEEK_SET);
+    pc->datalen = 0;
+  }
+
+  if (!(driver_data->rstartpage)(job, options, device, 1))
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to start raster page.");
+    return (false);
+  }
+
+  for (y = 0; y < options->header.cupsHeight && !job->is_canceled; y ++)
+  {
+    if (pc->rfd >= 0 && (pc->datalen - pc->datapos) < (sizeof(reclen) + pc->bytes + (pc->bytes + 127) / 128))
+    {
+      // Read more from the spool file...
+      memmove(pc->data, pc->data + pc->datapos, pc->datalen - pc->datapos);
+      pc->datalen -= pc->datapos;
+      pc->datapos = 0;
+
+      while (pc->datalen < pc->datasize)
+      {
+        if ((bytes = read(pc->rfd, pc->data + pc->datalen, pc->datasize - pc->datalen)) < 0)
+        {
+          if (errno == EINTR || errno == EAGAIN)
+            continue;
+
+	  papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read page cache file: %s", strerror(errno));
+	  return (false);
+	}
+	else if (bytes == 0)
+	  break;
+
+        pc->datalen += (size_t)bytes;
+      }
+    }
+
+    if ((pc->datalen - pc->datapos) < sizeof(reclen))
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Page cache is truncated.");
+      return (false);
+    }
+
+    memcpy(&reclen, pc->data + pc->datapos, sizeof(reclen));
+    pc->datapos += sizeof(reclen);
+
+    if (reclen > (pc->datalen - pc->datapos))
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Page cache is truncated.");
+      return (false);
+    }
+
+    pcache_unpack(line, pc->bytes, pc->data + pc->datapos, reclen);
+    pc->datapos += reclen;
+
+    if (!(driver_data->rwrite)(job, options, device, y, line))
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write raster line %u.", y);
+      return (false);
+    }
+  }
+
+  if (!(driver_data->rendpage)(job, options, device, 1))
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to end raster page.");
+    return (false);
+  }
+
+  return (true);
+}
+
+
+//
+// 'pcache_unpack()' - Decompress a PackBits line.
 //
 
 static void
-jpeg_error_handler(j_common_ptr p)	// I - JPEG data
+pcache_unpack(
+    unsigned char       *dst,		// I - Line buffer
+    size_t              bytes,		// I - Bytes in line
+    const unsigned char *src,		// I - Compressed line
+    size_t              srclen)		// I - Bytes in compressed line
 {
-  _pappl_jpeg_err_t	*jerr = (_pappl_jpeg_err_t *)p->err;
-					// JPEG error handler
+  const unsigned char	*end = src + srclen;
+					// End of compressed line
+  size_t		count;		// Bytes in run or literal
 
 
-  // Save the error message in the string buffer...
-  (jerr->jerr.format_message)(p, jerr->message);
+  while (src < end && bytes > 0)
+  {
+    if (*src & 0x80)
+    {
+      // Run of identical bytes...
+      count = (size_t)(257 - *src++);
+      if (count > bytes)
+        count = bytes;
+
+      if (src >= end)
+        break;
+
+      memset(dst, *src++, count);
+    }
+    else
+    {
+      // Literal bytes...
+      count = (size_t)*src++ + 1;
+      if (count > bytes)
+        count = bytes;
+      if (count > (size_t)(end - src))
+        count = (size_t)(end - src);
+
+      memcpy(dst, src, count);
+      src += count;
+    }
+
+    dst   += count;
+    bytes -= count;
+  }
+
+  if (bytes > 0)
+    memset(dst, 0, bytes);
+}
+
+
+#ifdef HAVE_LIBPNG
+//
+// 'png_begin()' - Start reading a PNG image from the beginning of the file.
+//
+
+static bool				// O - `true` on success, `false` on failure
+png_begin(_pappl_png_t *png)		// I - PNG decoder data
+{
+  if (png->pp)
+    png_destroy_read_struct(&png->pp, &png->info, NULL);
+
+  if ((png->pp = png_create_read_struct(PNG_LIBPNG_VER_STRING, png, png_error_handler, png_warning_handler)) == NULL || (png->info = png_create_info_struct(png->pp)) == NULL)
+  {
+    strlcpy(png->message, "Unable to allocate memory.", sizeof(png->message));
+    return (false);
+  }
+
+  if (setjmp(png_jmpbuf(png->pp)))
+  {
+    // PNG library errors are directed to this point...
+    return (false);
+  }
+
+  rewind(png->fp);
+  png_init_io(png->pp, png->fp);
+  png_read_info(png->pp, png->info);
+
+  return (true);
+}
+
+
+//
+// 'png_error_handler()' - Handle PNG errors by not exiting.
+//
+
+static void
+png_error_handler(
+    png_structp     pp,			// I - PNG read data
+    png_const_charp message)		// I - Error message
+{
+  _pappl_png_t	*png = (_pappl_png_t *)png_get_error_ptr(pp);
+					// PNG decoder data
+
+
+  // Save the error message...
+  strlcpy(png->message, message, sizeof(png->message));
 
   // Return to the point we called setjmp()...
-  longjmp(jerr->retbuf, 1);
+  png_longjmp(pp, 1);
+}
+
+
+//
+// 'png_read_line()' - Decode the next line of a non-interlaced PNG image.
+//
+
+static bool				// O - `true` on success, `false` on failure
+png_read_line(
+    _pappl_png_t  *png,			// I - PNG decoder data
+    unsigned char *line)		// I - Line buffer
+{
+  if (setjmp(png_jmpbuf(png->pp)))
+  {
+    // PNG library errors are directed to this point...
+    return (false);
+  }
+
+  png_read_row(png->pp, line, NULL);
+  png->y ++;
+
+  return (true);
+}
+
+
+//
+// 'png_read_pixels()' - Decode a whole PNG image.
+//
+// Interlaced images are decoded by making one pass over the buffer for each
+// interlace pass.
+//
+
+static bool				// O - `true` on success, `false` on failure
+png_read_pixels(
+    _pappl_png_t  *png,			// I - PNG decoder data
+    unsigned char *pixels)		// I - Pixel buffer
+{
+  unsigned	pass,			// Current pass
+		y;			// Current line
+  size_t	stride = (size_t)png->width * (size_t)png->depth;
+					// Bytes per line
+
+
+  if (setjmp(png_jmpbuf(png->pp)))
+  {
+    // PNG library errors are directed to this point...
+    return (false);
+  }
+
+  for (pass = 0; pass < png->passes; pass ++)
+  {
+    for (y = 0; y < png->height; y ++)
+      png_read_row(png->pp, pixels + y * stride, NULL);
+  }
+
+  png->y = png->height;
+
+  return (true);
+}
+
+
+//
+// 'png_rewind()' - Start decoding a PNG image over.
+//
+
+static bool				// O - `true` on success, `false` on failure
+png_rewind(_pappl_image_t *image)	// I - Image row source
+{
+  _pappl_png_t	*png = (_pappl_png_t *)image->data;
+					// PNG decoder data
+
+
+  if (!png_begin(png) || !png_setup(png))
+  {
+    papplLogJob(image->job, PAPPL_LOGLEVEL_ERROR, "Unable to read PNG image: %s", png->message);
+    return (false);
+  }
+
+  return (true);
+}
+
+
+//
+// 'png_row()' - Decode PNG image lines up to the requested line.
+//
+
+static const unsigned char *		// O - Row pixels or `NULL` on error
+png_row(_pappl_image_t *image,		// I - Image row source
+        unsigned       y)		// I - Row number
+{
+  _pappl_png_t	*png = (_pappl_png_t *)image->data;
+					// PNG decoder data
+
+
+  if (setjmp(png_jmpbuf(png->pp)))
+  {
+    // PNG library errors are directed to this point...
+    papplJobSetReasons(image->job, PAPPL_JREASON_DOCUMENT_FORMAT_ERROR, PAPPL_JREASON_NONE);
+    papplLogJob(image->job, PAPPL_LOGLEVEL_ERROR, "Unable to read PNG image: %s", png->message);
+    return (NULL);
+  }
+
+  for (; png->y <= y; png->y ++)
+    png_read_row(png->pp, image->row, NULL);
+
+  return (image->row);
+}
+
+
+//
+// 'png_setup()' - Set the PNG decoding transforms.
+//
+// Images are always decoded to 8-bit grayscale or RGB pixels, with any
+// transparency composited over a white background.
+//
+
+static bool				// O - `true` on success, `false` on failure
+png_setup(_pappl_png_t *png)		// I - PNG decoder data
+{
+  int		color_type;		// PNG color type
+  png_color_16	bg;			// Background color
+
+
+  if (setjmp(png_jmpbuf(png->pp)))
+  {
+    // PNG library errors are directed to this point...
+    return (false);
+  }
+
+  color_type = png_get_color_type(png->pp, png->info);
+
+  png_set_expand(png->pp);
+  png_set_strip_16(png->pp);
+
+  if (png->gray && (color_type & PNG_COLOR_MASK_COLOR))
+    png_set_rgb_to_gray_fixed(png->pp, PNG_ERROR_ACTION_NONE, -1, -1);
+
+  if ((color_type & PNG_COLOR_MASK_ALPHA) || png_get_valid(png->pp, png->info, PNG_INFO_tRNS))
+  {
+    memset(&bg, 0, sizeof(bg));
+    bg.red = bg.green = bg.blue = bg.gray = 255;
+
+    png_set_background_fixed(png->pp, &bg, PNG_BACKGROUND_GAMMA_SCREEN, 0, PNG_FP_1);
+  }
+
+  png->passes = (unsigned)png_set_interlace_handling(png->pp);
+  png->y      = 0;
+
+  png_read_update_info(png->pp, png->info);
+
+  png->width  = png_get_image_width(png->pp, png->info);
+  png->height = png_get_image_height(png->pp, png->info);
+  png->depth  = png_get_channels(png->pp, png->info);
+
+  if (png->depth != 1 && png->depth != 3)
+  {
+    snprintf(png->message, sizeof(png->message), "Unsupported number of channels (%u).", png->depth);
+    return (false);
+  }
+
+  return (true);
+}
+
+
+//
+// 'png_warning_handler()' - Log PNG warnings.
+//
+
+static void
+png_warning_handler(
+    png_structp     pp,			// I - PNG read data
+    png_const_charp message)		// I - Warning message
+{
+  _pappl_png_t	*png = (_pappl_png_t *)png_get_error_ptr(pp);
+					// PNG decoder data
+
+
+  papplLogJob(png->job, PAPPL_LOGLEVEL_DEBUG, "PNG warning: %s", message);
+}
+#endif // HAVE_LIBPNG
+
+
+//
+// 'prerip_rendjob()' - End a pre-RIP job.
+//
+
+static bool				// O - `true` on success, `false` on failure
+prerip_rendjob(
+    pappl_job_t      *job,		// I - Job
+    pappl_poptions_t *options,		// I - Job options
+    pappl_device_t   *device)		// I - Device (unused)
+{
+  (void)job;
+  (void)options;
+  (void)device;
+
+  return (true);
+}
+
+
+//
+// 'prerip_rendpage()' - End a pre-RIP page.
+//
+
+static bool				// O - `true` on success, `false` on failure
+prerip_rendpage(
+    pappl_job_t      *job,		// I - Job
+    pappl_poptions_t *options,		// I - Job options
+    pappl_device_t   *device,		// I - Device (unused)
+    unsigned         page)		// I - Page number
+{
+  (void)job;
+  (void)options;
+  (void)device;
+  (void)page;
+
+  return (true);
+}
+
+
+//
+// 'prerip_rstartjob()' - Start a pre-RIP job.
+//
+
+static bool				// O - `true` on success, `false` on failure
+prerip_rstartjob(
+    pappl_job_t      *job,		// I - Job
+    pappl_poptions_t *options,		// I - Job options
+    pappl_device_t   *device)		// I - Device (unused)
+{
+  (void)job;
+  (void)options;
+  (void)device;
+
+  return (true);
+}
+
+
+//
+// 'prerip_rstartpage()' - Start a pre-RIP page.
+//
+
+static bool				// O - `true` on success, `false` on failure
+prerip_rstartpage(
+    pappl_job_t      *job,		// I - Job
+    pappl_poptions_t *options,		// I - Job options
+    pappl_device_t   *device,		// I - Device (unused)
+    unsigned         page)		// I - Page number
+{
+  (void)device;
+  (void)page;
+
+  if (!cupsRasterWriteHeader2(job->prerip_ras, &options->header))
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write pre-RIP page header: %s", cupsLastErrorString());
+    return (false);
+  }
+
+  return (true);
+}
+
+
+//
+// 'prerip_rwrite()' - Write a line of pre-RIP raster data.
+//
+
+static bool				// O - `true` on success, `false` on failure
+prerip_rwrite(
+    pappl_job_t         *job,		// I - Job
+    pappl_poptions_t    *options,	// I - Job options
+    pappl_device_t      *device,	// I - Device (unused)
+    unsigned            y,		// I - Line number
+    const unsigned char *line)		// I - Line
+{
+  (void)device;
+  (void)y;
+
+  // Stop as soon as the (uncompressed) raster data is over the size limit...
+  job->prerip_size += options->header.cupsBytesPerLine;
+
+  if (job->prerip_size > job->prerip_max)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Pre-RIP raster data is larger than %lu bytes.", (unsigned long)job->prerip_max);
+    return (false);
+  }
+
+  if (!cupsRasterWritePixels(job->prerip_ras, (unsigned char *)line, options->header.cupsBytesPerLine))
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write pre-RIP raster data: %s", cupsLastErrorString());
+    return (false);
+  }
+
+  return (true);
 }
-#endif // HAVE_LIBJPEG
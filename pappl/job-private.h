@@ -18,6 +18,7 @@
 #  include "base-private.h"
 #  include "job.h"
 #  include "log.h"
+#  include <stdatomic.h>
 #  include <sys/wait.h>
 
 extern char **environ;
@@ -27,6 +28,23 @@ extern char **environ;
 // Types and structures...
 //
 
+typedef enum _pappl_prerip_e		// Pre-RIP states
+{
+  _PAPPL_PRERIP_NONE,			// Not pre-RIPped
+  _PAPPL_PRERIP_RUNNING,		// Pre-RIP in progress
+  _PAPPL_PRERIP_DONE,			// Pre-RIP completed
+  _PAPPL_PRERIP_FAILED			// Pre-RIP failed or not supported
+} _pappl_prerip_t;
+
+typedef struct _pappl_scale_s _pappl_scale_t;
+					// Bilinear image scaler
+typedef const unsigned char *(*_pappl_scale_cb_t)(void *data, unsigned y);
+					// Get a source line for the scaler
+
+// The atomic job fields are updated while holding the job or printer lock or
+// with an atomic read-modify-write, and may be read at any time without
+// locking.  Unlocked readers use relaxed loads since the values are only
+// reported and never used to guard access to other job data.
 struct _pappl_job_s			// Job data
 {
   pthread_rwlock_t	rwlock;			// Reader/writer lock
@@ -36,20 +54,25 @@ struct _pappl_job_s			// Job data
   const char		*name,			// "job-name" value
 			*username,		// "job-originating-user-name" value
 			*format;		// "document-format" value
-  ipp_jstate_t		state;			// "job-state" value
+  _Atomic ipp_jstate_t	state;			// "job-state" value
   pappl_jreason_t	state_reasons;		// "job-state-reasons" values
-  bool			is_canceled;		// Has this job been canceled?
+  atomic_bool		is_canceled;		// Has this job been canceled?
   char			*message;		// "job-state-message" value
   pappl_loglevel_t	msglevel;		// "job-state-message" log level
   time_t		created,		// "[date-]time-at-creation" value
 			processing,		// "[date-]time-at-processing" value
 			completed;		// "[date-]time-at-completed" value
-  int			impressions,		// "job-impressions" value
+  atomic_int		impressions,		// "job-impressions" value
 			impcompleted;		// "job-impressions-completed" value
   ipp_t			*attrs;			// Static attributes
   char			*filename;		// Print file name
   int			fd;			// Print file descriptor
   bool			streaming;		// Streaming job?
+  _pappl_prerip_t	prerip;			// Pre-RIP state
+  char			*prerip_filename;	// Pre-RIP raster file name
+  size_t		prerip_size,		// Size of pre-RIP raster file
+			prerip_max;		// Maximum size of pre-RIP raster file
+  cups_raster_t		*prerip_ras;		// Pre-RIP raster stream, if any
   void			*data;			// Per-job driver data
 };
 
@@ -63,16 +86,24 @@ extern int		_papplJobCompareAll(pappl_job_t *a, pappl_job_t *b) _PAPPL_PRIVATE;
 extern int		_papplJobCompareCompleted(pappl_job_t *a, pappl_job_t *b) _PAPPL_PRIVATE;
 extern pappl_job_t	*_papplJobCreate(pappl_printer_t *printer, const char *username, const char *format, const char *job_name, ipp_t *attrs) _PAPPL_PRIVATE;
 extern void		_papplJobDelete(pappl_job_t *job) _PAPPL_PRIVATE;
+extern void		_papplJobDitherLine(unsigned char *line, const unsigned char *pixels, unsigned x, unsigned count, const unsigned char *dither, bool black) _PAPPL_PRIVATE;
+extern const char	*_papplJobDitherName(void) _PAPPL_PRIVATE;
+extern bool		_papplJobDitherSelect(const char *name) _PAPPL_PRIVATE;
 #  ifdef HAVE_LIBJPEG
 extern bool		_papplJobFilterJPEG(pappl_job_t *job, pappl_device_t *device, void *data);
 #  endif // HAVE_LIBJPEG
 #  ifdef HAVE_LIBPNG
 extern bool		_papplJobFilterPNG(pappl_job_t *job, pappl_device_t *device, void *data);
 #  endif // HAVE_LIBPNG
+extern void		*_papplJobPreRIP(pappl_job_t *job) _PAPPL_PRIVATE;
 extern void		*_papplJobProcess(pappl_job_t *job) _PAPPL_PRIVATE;
 extern void		_papplJobProcessRaster(pappl_job_t *job, pappl_client_t *client) _PAPPL_PRIVATE;
 extern const char	*_papplJobReasonString(pappl_jreason_t reason) _PAPPL_PRIVATE;
 extern void		_papplJobRemoveFile(pappl_job_t *job) _PAPPL_PRIVATE;
+extern void		_papplJobRemovePreRIPFile(pappl_job_t *job) _PAPPL_PRIVATE;
+extern _pappl_scale_t	*_papplJobScaleCreate(unsigned width, unsigned height, unsigned depth, unsigned xsize, unsigned ysize) _PAPPL_PRIVATE;
+extern void		_papplJobScaleDelete(_pappl_scale_t *scale) _PAPPL_PRIVATE;
+extern const unsigned char *_papplJobScaleGetLine(_pappl_scale_t *scale, unsigned y, _pappl_scale_cb_t cb, void *cbdata) _PAPPL_PRIVATE;
 extern void		_papplJobSetState(pappl_job_t *job, ipp_jstate_t state) _PAPPL_PRIVATE;
 extern void		_papplJobSubmitFile(pappl_job_t *job, const char *filename) _PAPPL_PRIVATE;
 
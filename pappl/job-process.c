@@ -14,13 +14,88 @@
 #include "pappl-private.h"
 
 
+//
+// Local types...
+//
+
+#define _PAPPL_PIPELINE_BANDS	4	// Number of bands in the raster pipeline
+#define _PAPPL_PIPELINE_LINES	32	// Number of lines in each band
+
+typedef enum _pappl_bstate_e		// Raster band states
+{
+  _PAPPL_BAND_FREE,			// Band is available for reading
+  _PAPPL_BAND_READ,			// Band has been read
+  _PAPPL_BAND_CONVERTED			// Band has been converted
+} _pappl_bstate_t;
+
+typedef enum _pappl_stage_e		// Raster pipeline stages
+{
+  _PAPPL_STAGE_READ,			// Read from raster stream
+  _PAPPL_STAGE_CONVERT,			// Convert/dither
+  _PAPPL_STAGE_WRITE,			// Write to driver
+  _PAPPL_STAGE_MAX			// Number of stages
+} _pappl_stage_t;
+
+typedef struct _pappl_band_s		// Band of raster lines
+{
+  _pappl_bstate_t	state;			// Band state
+  unsigned		y,			// First line in band
+			count,			// Number of lines in band
+			valid;			// Number of lines read
+  unsigned char		*pixels,		// Incoming pixels
+			*line;			// Dithered output lines, if any
+} _pappl_band_t;
+
+typedef struct _pappl_joptions_s	// Compiled job options for raster pages
+{
+  bool			valid,			// Have the options been compiled?
+			page_header;		// Is "options.header" from the page?
+  cups_page_header2_t	header;			// Compiled page header
+  pappl_poptions_t	options;		// Compiled job options
+} _pappl_joptions_t;
+
+typedef struct _pappl_pipeline_s	// Raster pipeline
+{
+  pthread_mutex_t	mutex;			// Mutex for band states
+  pthread_cond_t	cond;			// Condition for band state changes
+  bool			abort;			// Stop the pipeline threads?
+  pappl_job_t		*job;			// Job
+  pappl_poptions_t	*options;		// Job options for current page
+  cups_page_header2_t	*header;		// Current page header
+  bool			dither;			// Dither to 1-bit output?
+  pthread_t		convert_tid,		// Conversion thread
+			write_tid;		// Writer thread
+  _pappl_band_t		bands[_PAPPL_PIPELINE_BANDS];
+					// Ring buffer of bands
+  unsigned		next_band;		// Next band to read into
+  size_t		pixels_size,		// Allocated size of band pixels
+			line_size;		// Allocated size of band lines
+  size_t		busy_usecs[_PAPPL_STAGE_MAX];
+					// Time each stage spent working
+} _pappl_pipeline_t;
+
+
 //
 // Local functions...
 //
 
 static const char *cups_cspace_string(cups_cspace_t cspace);
+static bool	filter_raster(pappl_job_t *job, const char *filename, bool preripped);
 static bool	filter_raw(pappl_job_t *job, pappl_device_t *device);
 static void	finish_job(pappl_job_t *job);
+static cups_raster_t *next_copy(pappl_job_t *job, cups_raster_t **copy_ras, int fd);
+static void	*pipeline_convert(_pappl_pipeline_t *pipeline);
+static void	pipeline_done(_pappl_pipeline_t *pipeline, _pappl_band_t *band, _pappl_bstate_t state, _pappl_stage_t stage, size_t start);
+static void	pipeline_finish(_pappl_pipeline_t *pipeline);
+static bool	pipeline_page(_pappl_pipeline_t *pipeline);
+static unsigned	pipeline_read(_pappl_pipeline_t *pipeline, cups_raster_t *ras);
+static bool	pipeline_start(_pappl_pipeline_t *pipeline);
+static size_t	pipeline_usecs(void);
+static bool	pipeline_wait(_pappl_pipeline_t *pipeline, _pappl_band_t *band, _pappl_bstate_t state);
+static void	*pipeline_write(_pappl_pipeline_t *pipeline);
+static bool	prerip_supported(_pappl_mime_filter_t *filter);
+static void	process_raster(pappl_job_t *job, cups_raster_t *ras, int fd, bool preripped);
+static _pappl_joptions_t *raster_options(pappl_job_t *job, _pappl_joptions_t *joptions, cups_page_header2_t *header, bool preripped);
 static void	start_job(pappl_job_t *job);
 
 
@@ -351,262 +426,212 @@ papplJobGetPrintOptions(
 
 
 //
-// 'lprintProcessJob()' - Process a print job.
+// '_papplJobPreRIP()' - Convert a pending job to raster data.
+//
+// This function runs on a worker thread while the printer is busy with
+// another job.  The output of the built-in image filters is captured in a PWG
+// raster file in the spool directory which @code _papplJobProcess@ later sends
+// to the driver without filtering the job again.  Only the first copy is
+// captured and the pre-RIP stops as soon as the raster data no longer fits in
+// the printer's "max_prerip_size" limit.
 //
 
 void *					// O - Thread exit status
-_papplJobProcess(pappl_job_t *job)	// I - Job
+_papplJobPreRIP(pappl_job_t *job)	// I - Job
 {
-  _pappl_mime_filter_t	*filter;	// Filter for printing
+  pappl_printer_t	*printer = job->printer;
+					// Printer for job
+  _pappl_mime_filter_t	*filter = NULL;	// Filter for printing
+  char			filename[1024];	// Pre-RIP raster file
+  int			fd = -1;	// Pre-RIP raster file descriptor
+  bool			ret = false;	// Did the pre-RIP succeed?
+  struct stat		fileinfo;	// Pre-RIP raster file information
+  bool			delete_printer;	// Delete the printer now?
+  struct timeval	starttime,	// Start time
+			endtime;	// End time
 
 
-  // Start processing the job...
-  start_job(job);
+  gettimeofday(&starttime, NULL);
 
-  // Do file-specific conversions...
-  if ((filter = _papplSystemFindMIMEFilter(job->system, job->format, job->printer->driver_data.format)) == NULL)
-    filter =_papplSystemFindMIMEFilter(job->system, job->format, "image/pwg-raster");
+  // Only pre-RIP jobs that use one of the built-in image filters...
+  if (!_papplSystemFindMIMEFilter(job->system, job->format, printer->driver_data.format))
+    filter = _papplSystemFindMIMEFilter(job->system, job->format, "image/pwg-raster");
 
-  if (filter)
+  if (job->is_canceled || printer->is_deleted)
   {
-    if (!(filter->cb)(job, job->printer->device, filter->cbdata))
-      job->state = IPP_JSTATE_ABORTED;
+    papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Not pre-RIPping canceled job.");
   }
-  else if (!strcmp(job->format, job->printer->driver_data.format))
+  else if (!filter || !prerip_supported(filter))
   {
-    if (!filter_raw(job, job->printer->device))
-      job->state = IPP_JSTATE_ABORTED;
+    papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Not pre-RIPping job with format '%s'.", job->format);
   }
-  else
+  else if ((fd = papplJobCreateFile(job, filename, sizeof(filename), job->system->directory, "ras")) < 0)
   {
-    // Abort a job we can't process...
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to process job with format '%s'.", job->format);
-    job->state = IPP_JSTATE_ABORTED;
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to create pre-RIP file: %s", strerror(errno));
+  }
+  else if ((job->prerip_ras = cupsRasterOpen(fd, CUPS_RASTER_WRITE_PWG)) == NULL)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open pre-RIP file '%s': %s", filename, cupsLastErrorString());
   }
+  else
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Pre-RIPping job to '%s'.", filename);
 
-  // Move the job to a completed state...
-  finish_job(job);
+    // Limit the raster data to the space left for pre-RIP files...
+    pthread_rwlock_rdlock(&printer->rwlock);
+    job->prerip_max = printer->prerip_size < printer->max_prerip_size ? printer->max_prerip_size - printer->prerip_size : 0;
+    pthread_rwlock_unlock(&printer->rwlock);
 
-  return (NULL);
-}
+    job->prerip_size = 0;
 
+    ret = (filter->cb)(job, NULL, filter->cbdata);
 
-//
-// '_papplJobProcessRaster()' - Process an Apple/PWG Raster file.
-//
+    cupsRasterClose(job->prerip_ras);
+    job->prerip_ras = NULL;
+  }
 
-void
-_papplJobProcessRaster(
-    pappl_job_t    *job,		// I - Job
-    pappl_client_t *client)		// I - Client
-{
-  pappl_printer_t	*printer = job->printer;
-					// Printer for job
-  pappl_poptions_t	options;	// Job options
-  cups_raster_t		*ras = NULL;	// Raster stream
-  cups_page_header2_t	header;		// Page header
-  unsigned		header_pages;	// Number of pages from page header
-  const unsigned char	*dither;	// Dither line
-  unsigned char		*pixels,	// Incoming pixel line
-			*pixptr,	// Pixel pointer in line
-			*line,		// Output (bitmap) line
-			*lineptr,	// Pointer in line
-			byte,		// Byte in line
-			bit;		// Current bit
-  unsigned		page = 0,	// Current page
-			x,		// Current column
-			y;		// Current line
+  if (fd >= 0)
+    close(fd);
 
+  // Save the pre-RIP file if the job is still waiting to be printed...
+  pthread_rwlock_wrlock(&job->rwlock);
+  pthread_rwlock_wrlock(&printer->rwlock);
 
-  // Start processing the job...
-  job->streaming = true;
+  if (ret && job->state == IPP_JSTATE_PENDING && !job->is_canceled && !stat(filename, &fileinfo) && (printer->prerip_size + (size_t)fileinfo.st_size) <= printer->max_prerip_size && (job->prerip_filename = strdup(filename)) != NULL)
+  {
+    job->prerip          = _PAPPL_PRERIP_DONE;
+    job->prerip_size     = (size_t)fileinfo.st_size;
+    printer->prerip_size += job->prerip_size;
 
-  start_job(job);
+    gettimeofday(&endtime, NULL);
 
-  // Open the raster stream...
-  if ((ras = cupsRasterOpenIO((cups_raster_iocb_t)httpRead2, client->http, CUPS_RASTER_READ)) == NULL)
+    papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Pre-RIPped job to %lu bytes of raster data in %d msecs.", (unsigned long)job->prerip_size, (int)(1000 * (endtime.tv_sec - starttime.tv_sec) + (endtime.tv_usec - starttime.tv_usec) / 1000));
+  }
+  else
   {
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open raster stream from client - %s", cupsLastErrorString());
-    job->state = IPP_JSTATE_ABORTED;
-    goto complete_job;
+    if (fd >= 0)
+      unlink(filename);
+
+    job->prerip      = _PAPPL_PRERIP_FAILED;
+    job->prerip_size = 0;
   }
 
-  // Prepare options...
-  if (!cupsRasterReadHeader2(ras, &header))
+  if (job->is_canceled && job->state == IPP_JSTATE_PENDING)
   {
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read raster stream from client - %s", cupsLastErrorString());
-    job->state = IPP_JSTATE_ABORTED;
-    goto complete_job;
-  }
+    // Finish canceling the job now that the pre-RIP no longer uses it...
+    job->state     = IPP_JSTATE_CANCELED;
+    job->completed = time(NULL);
 
-  if ((header_pages = header.cupsInteger[CUPS_RASTER_PWG_TotalPageCount]) > 0)
-    papplJobSetImpressions(job, (int)header.cupsInteger[CUPS_RASTER_PWG_TotalPageCount]);
+    _papplJobRemoveFile(job);
 
-  papplJobGetPrintOptions(job, &options, job->impressions, header.cupsBitsPerPixel > 8);
+    if (cupsArrayRemove(printer->active_jobs, job))
+      printer->num_active_jobs --;
+    cupsArrayAdd(printer->completed_jobs, job);
 
-  if (!(printer->driver_data.rstartjob)(job, &options, job->printer->device))
-  {
-    job->state = IPP_JSTATE_ABORTED;
-    goto complete_job;
+    if (!job->system->clean_time)
+      job->system->clean_time = time(NULL) + 60;
   }
 
-  // Print pages...
-  do
-  {
-    if (job->is_canceled)
-      break;
+  // Delete the printer once the last pre-RIP is done if requested...
+  printer->num_prerips --;
 
-    page ++;
-    papplJobSetImpressionsCompleted(job, 1);
+  delete_printer = printer->is_deleted && printer->num_prerips == 0 && !printer->processing_job;
 
-    papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Page %u raster data is %ux%ux%u (%s)", page, header.cupsWidth, header.cupsHeight, header.cupsBitsPerPixel, cups_cspace_string(header.cupsColorSpace));
+  pthread_rwlock_unlock(&printer->rwlock);
+  pthread_rwlock_unlock(&job->rwlock);
 
-    // Set options for this page...
-    papplJobGetPrintOptions(job, &options, job->impressions, header.cupsBitsPerPixel > 8);
+  if (delete_printer)
+    papplPrinterDelete(printer);
+  else
+    _papplPrinterCheckJobs(printer);	// Start the job if the printer is waiting for it
 
-    if (header.cupsWidth == 0 || header.cupsHeight == 0 || (header.cupsBitsPerColor != 1 && header.cupsBitsPerColor != 8) || header.cupsColorOrder != CUPS_ORDER_CHUNKED || (header.cupsBytesPerLine != ((header.cupsWidth * header.cupsBitsPerPixel + 7) / 8)))
-    {
-      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Bad raster data seen.");
-      papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_FORMAT_ERROR, PAPPL_JREASON_NONE);
-      job->state = IPP_JSTATE_ABORTED;
-      break;
-    }
+  return (NULL);
+}
 
-    if (header.cupsWidth > options.header.cupsWidth || header.cupsHeight > options.header.cupsHeight || (header.cupsBitsPerPixel > 8 && !(printer->driver_data.color_supported & PAPPL_COLOR_MODE_COLOR)))
-    {
-      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unsupported raster data seen.");
-      papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_UNPRINTABLE_ERROR, PAPPL_JREASON_NONE);
-      job->state = IPP_JSTATE_ABORTED;
-      break;
-    }
 
-    if (options.header.cupsBitsPerPixel >= 8 && header.cupsBitsPerPixel >= 8)
-      options.header = header;		// Use page header from client
+//
+// '_papplJobProcess()' - Process a print job.
+//
 
-    if (!(printer->driver_data.rstartpage)(job, &options, job->printer->device, page))
-    {
-      job->state = IPP_JSTATE_ABORTED;
-      break;
-    }
+void *					// O - Thread exit status
+_papplJobProcess(pappl_job_t *job)	// I - Job
+{
+  _pappl_mime_filter_t	*filter;	// Filter for printing
+
+
+  // Start processing the job...
+  start_job(job);
 
-    pixels = malloc(header.cupsBytesPerLine);
-    line   = malloc(options.header.cupsBytesPerLine);
+  if (job->prerip_filename)
+  {
+    // Send the pre-RIPped raster data...
+    if (!filter_raster(job, job->prerip_filename, true))
+      job->state = IPP_JSTATE_ABORTED;
+  }
+  else
+  {
+    // Do file-specific conversions...
+    if ((filter = _papplSystemFindMIMEFilter(job->system, job->format, job->printer->driver_data.format)) == NULL)
+      filter =_papplSystemFindMIMEFilter(job->system, job->format, "image/pwg-raster");
 
-    for (y = 0; !job->is_canceled && y < header.cupsHeight; y ++)
+    if (filter)
     {
-      if (cupsRasterReadPixels(ras, pixels, header.cupsBytesPerLine))
-      {
-        if (header.cupsBitsPerPixel == 8 && options.header.cupsBitsPerPixel == 1)
-        {
-          // Dither the line...
-	  dither = options.dither[y & 15];
-	  memset(line, 0, options.header.cupsBytesPerLine);
-
-          if (header.cupsColorSpace == CUPS_CSPACE_K)
-          {
-            // Black...
-	    for (x = 0, lineptr = line, pixptr = pixels, bit = 128, byte = 0; x < header.cupsWidth; x ++, pixptr ++)
-	    {
-	      if (*pixptr > dither[x & 15])
-	        byte |= bit;
-
-	      if (bit == 1)
-	      {
-	        *lineptr++ = byte;
-	        byte       = 0;
-	        bit        = 128;
-	      }
-	      else
-	        bit /= 2;
-	    }
-
-	    if (bit < 128)
-	      *lineptr = byte;
-	  }
-	  else
-	  {
-	    // Grayscale to black...
-	    for (x = 0, lineptr = line, pixptr = pixels, bit = 128, byte = 0; x < header.cupsWidth; x ++, pixptr ++)
-	    {
-	      if (*pixptr <= dither[x & 15])
-	        byte |= bit;
-
-	      if (bit == 1)
-	      {
-	        *lineptr++ = byte;
-	        byte       = 0;
-	        bit        = 128;
-	      }
-	      else
-	        bit /= 2;
-	    }
-
-	    if (bit < 128)
-	      *lineptr = byte;
-	  }
-
-          (printer->driver_data.rwrite)(job, &options, job->printer->device, y, line);
-        }
-        else
-          (printer->driver_data.rwrite)(job, &options, job->printer->device, y, pixels);
-      }
-      else
-        break;
+      if (!(filter->cb)(job, job->printer->device, filter->cbdata))
+	job->state = IPP_JSTATE_ABORTED;
     }
-
-    if (y < header.cupsHeight)
+    else if (!strcmp(job->format, "image/pwg-raster") || !strcmp(job->format, "image/urf"))
     {
-      if (header.cupsBitsPerPixel == 8 && options.header.cupsBitsPerPixel == 1)
-      {
-        memset(line, 0, options.header.cupsBytesPerLine);
-
-        while (y < header.cupsHeight)
-        {
-	  (printer->driver_data.rwrite)(job, &options, job->printer->device, y, line);
-          y ++;
-        }
-      }
-      else
-      {
-        if (header.cupsColorSpace == CUPS_CSPACE_K || header.cupsColorSpace == CUPS_CSPACE_CMYK)
-          memset(pixels, 0x00, header.cupsBytesPerLine);
-	else
-          memset(pixels, 0xff, header.cupsBytesPerLine);
-
-        while (y < header.cupsHeight)
-        {
-	  (printer->driver_data.rwrite)(job, &options, job->printer->device, y, pixels);
-          y ++;
-        }
-      }
+      // Send spooled raster data...
+      if (!filter_raster(job, job->filename, false))
+	job->state = IPP_JSTATE_ABORTED;
     }
-
-    free(pixels);
-    free(line);
-
-    if (!(printer->driver_data.rendpage)(job, &options, job->printer->device, page))
+    else if (!strcmp(job->format, job->printer->driver_data.format))
     {
-      job->state = IPP_JSTATE_ABORTED;
-      break;
+      if (!filter_raw(job, job->printer->device))
+	job->state = IPP_JSTATE_ABORTED;
     }
-
-    if (job->is_canceled)
-      break;
-    else if (y < header.cupsHeight)
+    else
     {
-      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read page from raster stream from client - %s", cupsLastErrorString());
+      // Abort a job we can't process...
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to process job with format '%s'.", job->format);
       job->state = IPP_JSTATE_ABORTED;
-      break;
     }
   }
-  while (cupsRasterReadHeader2(ras, &header));
 
-  if (!(printer->driver_data.rendjob)(job, &options, job->printer->device))
-    job->state = IPP_JSTATE_ABORTED;
-  else if (header_pages == 0)
-    papplJobSetImpressions(job, (int)page);
+  // Move the job to a completed state...
+  finish_job(job);
+
+  return (NULL);
+}
+
+
+//
+// '_papplJobProcessRaster()' - Process an Apple/PWG Raster file.
+//
+
+void
+_papplJobProcessRaster(
+    pappl_job_t    *job,		// I - Job
+    pappl_client_t *client)		// I - Client
+{
+  cups_raster_t		*ras = NULL;	// Raster stream
+
+
+  // Start processing the job...
+  job->streaming = true;
+
+  start_job(job);
 
-  complete_job:
+  // Open the raster stream...
+  if ((ras = cupsRasterOpenIO((cups_raster_iocb_t)httpRead2, client->http, CUPS_RASTER_READ)) == NULL)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open raster stream from client - %s", cupsLastErrorString());
+    job->state = IPP_JSTATE_ABORTED;
+  }
+  else
+  {
+    process_raster(job, ras, -1, false);
+  }
 
   if (httpGetState(client->http) == HTTP_STATE_POST_RECV)
   {
@@ -706,6 +731,47 @@ cups_cspace_string(
 }
 
 
+//
+// 'filter_raster()' - Send an Apple/PWG Raster file to the driver.
+//
+// This function is used for spooled raster jobs and for jobs that have been
+// pre-RIPped.
+//
+
+static bool				// O - `true` on success, `false` otherwise
+filter_raster(
+    pappl_job_t *job,			// I - Job
+    const char  *filename,		// I - Raster filename
+    bool        preripped)		// I - Pre-RIPped raster data?
+{
+  int		fd;			// Raster file descriptor
+  cups_raster_t	*ras;			// Raster stream
+
+
+  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Printing raster data from '%s'.", filename);
+
+  if ((fd = open(filename, O_RDONLY)) < 0)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open raster file '%s': %s", filename, strerror(errno));
+    return (false);
+  }
+
+  if ((ras = cupsRasterOpen(fd, CUPS_RASTER_READ)) == NULL)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open raster file '%s': %s", filename, cupsLastErrorString());
+    close(fd);
+    return (false);
+  }
+
+  process_raster(job, ras, fd, preripped);
+
+  cupsRasterClose(ras);
+  close(fd);
+
+  return (job->state != IPP_JSTATE_ABORTED);
+}
+
+
 //
 // 'filter_raw()' - "Filter" a raw print file.
 //
@@ -738,6 +804,7 @@ finish_job(pappl_job_t  *job)		// I - Job
 {
   pappl_printer_t *printer = job->printer;
 					// Printer
+  bool		delete_printer;		// Delete the printer now?
 
 
   pthread_rwlock_wrlock(&job->rwlock);
@@ -769,19 +836,25 @@ finish_job(pappl_job_t  *job)		// I - Job
 
   printer->state_time = time(NULL);
 
-  cupsArrayRemove(printer->active_jobs, job);
+  if (cupsArrayRemove(printer->active_jobs, job))
+    printer->num_active_jobs --;
   cupsArrayAdd(printer->completed_jobs, job);
 
+  _papplJobRemovePreRIPFile(job);
+
   printer->impcompleted += job->impcompleted;
 
   if (!job->system->clean_time)
     job->system->clean_time = time(NULL) + 60;
 
+  // Pre-RIP threads delete the printer when they are done...
+  delete_printer = printer->is_deleted && printer->num_prerips == 0;
+
   pthread_rwlock_unlock(&printer->rwlock);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplSystemStateChanged(printer->system);
 
-  if (printer->is_deleted)
+  if (delete_printer)
   {
     papplPrinterDelete(printer);
   }
@@ -807,6 +880,688 @@ finish_job(pappl_job_t  *job)		// I - Job
 }
 
 
+//
+// 'next_copy()' - Rewind a pre-RIP raster file for the next copy.
+//
+
+static cups_raster_t *			// O - Raster stream or `NULL` on error
+next_copy(pappl_job_t   *job,		// I - Job
+          cups_raster_t **copy_ras,	// IO - Raster stream for copies
+          int           fd)		// I - Raster file descriptor
+{
+  if (*copy_ras)
+  {
+    cupsRasterClose(*copy_ras);
+    *copy_ras = NULL;
+  }
+
+  if (lseek(fd, 0, SEEK_SET) < 0)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to rewind raster file: %s", strerror(errno));
+    return (NULL);
+  }
+
+  *copy_ras = cupsRasterOpen(fd, CUPS_RASTER_READ);
+
+  return (*copy_ras);
+}
+
+
+//
+// 'pipeline_convert()' - Convert bands of raster data for the driver.
+//
+// The conversion thread runs for the whole job, converting bands in ring order
+// until the pipeline is stopped.
+//
+
+static void *				// O - Thread exit status
+pipeline_convert(
+    _pappl_pipeline_t *pipeline)	// I - Raster pipeline
+{
+  pappl_poptions_t	*options;	// Job options
+  cups_page_header2_t	*header;	// Page header
+  _pappl_band_t		*band;		// Current band
+  unsigned		b,		// Current band number
+			i,		// Line within band
+			y;		// Current line
+  unsigned char		*pixels,	// Incoming pixel line
+			*line;		// Output (bitmap) line
+  size_t		start;		// Start time
+
+
+  for (b = 0;; b = (b + 1) % _PAPPL_PIPELINE_BANDS)
+  {
+    // Wait for the next band to be read...
+    band = pipeline->bands + b;
+
+    if (!pipeline_wait(pipeline, band, _PAPPL_BAND_READ))
+      break;
+
+    start   = pipeline_usecs();
+    options = pipeline->options;
+    header  = pipeline->header;
+
+    for (i = 0, y = band->y; i < band->count; i ++, y ++)
+    {
+      pixels = band->pixels + i * header->cupsBytesPerLine;
+
+      if (pipeline->dither)
+      {
+        // Dither the line...
+        line = band->line + i * options->header.cupsBytesPerLine;
+
+	memset(line, 0, options->header.cupsBytesPerLine);
+
+        if (i >= band->valid)
+          continue;			// Blank line
+
+	_papplJobDitherLine(line, pixels, 0, header->cupsWidth, options->dither[y & 15], header->cupsColorSpace == CUPS_CSPACE_K);
+      }
+      else if (i >= band->valid)
+      {
+        // Blank line...
+	if (header->cupsColorSpace == CUPS_CSPACE_K || header->cupsColorSpace == CUPS_CSPACE_CMYK)
+	  memset(pixels, 0x00, header->cupsBytesPerLine);
+	else
+	  memset(pixels, 0xff, header->cupsBytesPerLine);
+      }
+    }
+
+    pipeline_done(pipeline, band, _PAPPL_BAND_CONVERTED, _PAPPL_STAGE_CONVERT, start);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'pipeline_done()' - Pass a band to the next stage of the pipeline.
+//
+
+static void
+pipeline_done(
+    _pappl_pipeline_t *pipeline,	// I - Raster pipeline
+    _pappl_band_t     *band,		// I - Band
+    _pappl_bstate_t   state,		// I - New band state
+    _pappl_stage_t    stage,		// I - Current stage
+    size_t            start)		// I - Time the stage started working on the band
+{
+  size_t	busy = pipeline_usecs() - start;
+					// Time spent on the band
+
+
+  pthread_mutex_lock(&pipeline->mutex);
+
+  band->state                 = state;
+  pipeline->busy_usecs[stage] += busy;
+
+  pthread_cond_broadcast(&pipeline->cond);
+  pthread_mutex_unlock(&pipeline->mutex);
+}
+
+
+//
+// 'pipeline_finish()' - Stop the pipeline threads and free the bands.
+//
+
+static void
+pipeline_finish(
+    _pappl_pipeline_t *pipeline)	// I - Raster pipeline
+{
+  int	b;				// Looping var
+
+
+  pthread_mutex_lock(&pipeline->mutex);
+  pipeline->abort = true;
+  pthread_cond_broadcast(&pipeline->cond);
+  pthread_mutex_unlock(&pipeline->mutex);
+
+  pthread_join(pipeline->convert_tid, NULL);
+  pthread_join(pipeline->write_tid, NULL);
+
+  for (b = 0; b < _PAPPL_PIPELINE_BANDS; b ++)
+  {
+    free(pipeline->bands[b].pixels);
+    free(pipeline->bands[b].line);
+
+    pipeline->bands[b].pixels = NULL;
+    pipeline->bands[b].line   = NULL;
+  }
+
+  pipeline->pixels_size = pipeline->line_size = 0;
+}
+
+
+//
+// 'pipeline_page()' - Prepare the pipeline for a page.
+//
+// The bands are only reallocated when a page needs larger buffers than the
+// previous pages.  This must only be called between pages, when all bands are
+// free.
+//
+
+static bool				// O - `true` on success, `false` on failure
+pipeline_page(
+    _pappl_pipeline_t *pipeline)	// I - Raster pipeline
+{
+  pappl_poptions_t	*options = pipeline->options;
+					// Job options
+  cups_page_header2_t	*header = pipeline->header;
+					// Page header
+  size_t		pixels_size,	// Size of band pixels
+			line_size;	// Size of band lines
+  unsigned char		*buffer;	// New band buffer
+  int			b;		// Looping var
+
+
+  pipeline->dither = header->cupsBitsPerPixel == 8 && options->header.cupsBitsPerPixel == 1;
+
+  if (pipeline->dither)
+    papplLogJob(pipeline->job, PAPPL_LOGLEVEL_DEBUG, "Dithering using %s code.", _papplJobDitherName());
+
+  pixels_size = _PAPPL_PIPELINE_LINES * header->cupsBytesPerLine;
+  line_size   = pipeline->dither ? _PAPPL_PIPELINE_LINES * options->header.cupsBytesPerLine : 0;
+
+  if (pixels_size > pipeline->pixels_size)
+  {
+    for (b = 0; b < _PAPPL_PIPELINE_BANDS; b ++)
+    {
+      if ((buffer = realloc(pipeline->bands[b].pixels, pixels_size)) == NULL)
+        goto error;
+
+      pipeline->bands[b].pixels = buffer;
+    }
+
+    pipeline->pixels_size = pixels_size;
+  }
+
+  if (line_size > pipeline->line_size)
+  {
+    for (b = 0; b < _PAPPL_PIPELINE_BANDS; b ++)
+    {
+      if ((buffer = realloc(pipeline->bands[b].line, line_size)) == NULL)
+        goto error;
+
+      pipeline->bands[b].line = buffer;
+    }
+
+    pipeline->line_size = line_size;
+  }
+
+  return (true);
+
+  // If we get here there was an error...
+  error:
+
+  papplLogJob(pipeline->job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for raster bands: %s", strerror(errno));
+
+  return (false);
+}
+
+
+//
+// 'pipeline_read()' - Read the lines of a page into the pipeline.
+//
+// Lines that cannot be read, either because of an error or because the job
+// was canceled, are sent to the driver as blank lines.  This function returns
+// once every band of the page has been written to the driver.
+//
+
+static unsigned				// O - Number of lines read
+pipeline_read(
+    _pappl_pipeline_t *pipeline,	// I - Raster pipeline
+    cups_raster_t     *ras)		// I - Raster stream
+{
+  pappl_job_t		*job = pipeline->job;
+					// Job
+  cups_page_header2_t	*header = pipeline->header;
+					// Page header
+  _pappl_band_t		*band;		// Current band
+  unsigned		b,		// Current band number
+			y,		// Current line
+			lines = 0;	// Lines read
+  bool			reading = true;	// Still reading lines?
+  size_t		start;		// Start time
+
+
+  for (y = 0; y < header->cupsHeight;)
+  {
+    // Wait for the next band to be available...
+    b                   = pipeline->next_band;
+    band                = pipeline->bands + b;
+    pipeline->next_band = (b + 1) % _PAPPL_PIPELINE_BANDS;
+
+    if (!pipeline_wait(pipeline, band, _PAPPL_BAND_FREE))
+      break;
+
+    start = pipeline_usecs();
+
+    band->y     = y;
+    band->count = header->cupsHeight - y;
+    band->valid = 0;
+
+    if (band->count > _PAPPL_PIPELINE_LINES)
+      band->count = _PAPPL_PIPELINE_LINES;
+
+    while (reading && band->valid < band->count)
+    {
+      if (!job->is_canceled && cupsRasterReadPixels(ras, band->pixels + band->valid * header->cupsBytesPerLine, header->cupsBytesPerLine))
+      {
+        band->valid ++;
+        lines ++;
+      }
+      else
+        reading = false;
+    }
+
+    y += band->count;
+
+    pipeline_done(pipeline, band, _PAPPL_BAND_READ, _PAPPL_STAGE_READ, start);
+  }
+
+  // Wait for the page to be written...
+  for (b = 0; b < _PAPPL_PIPELINE_BANDS; b ++)
+  {
+    if (!pipeline_wait(pipeline, pipeline->bands + b, _PAPPL_BAND_FREE))
+      break;
+  }
+
+  return (lines);
+}
+
+
+//
+// 'pipeline_start()' - Start the pipeline threads for a job.
+//
+// The conversion and writer threads are started once per job and pages are
+// passed to them through the ring buffer of bands.
+//
+
+static bool				// O - `true` on success, `false` on failure
+pipeline_start(
+    _pappl_pipeline_t *pipeline)	// I - Raster pipeline
+{
+  int	b;				// Looping var
+
+
+  pipeline->abort     = false;
+  pipeline->next_band = 0;
+
+  for (b = 0; b < _PAPPL_PIPELINE_BANDS; b ++)
+    pipeline->bands[b].state = _PAPPL_BAND_FREE;
+
+  if (pthread_create(&pipeline->convert_tid, NULL, (void *(*)(void *))pipeline_convert, pipeline))
+  {
+    papplLogJob(pipeline->job, PAPPL_LOGLEVEL_ERROR, "Unable to create raster conversion thread: %s", strerror(errno));
+    return (false);
+  }
+
+  if (pthread_create(&pipeline->write_tid, NULL, (void *(*)(void *))pipeline_write, pipeline))
+  {
+    papplLogJob(pipeline->job, PAPPL_LOGLEVEL_ERROR, "Unable to create raster writer thread: %s", strerror(errno));
+
+    pthread_mutex_lock(&pipeline->mutex);
+    pipeline->abort = true;
+    pthread_cond_broadcast(&pipeline->cond);
+    pthread_mutex_unlock(&pipeline->mutex);
+
+    pthread_join(pipeline->convert_tid, NULL);
+    return (false);
+  }
+
+  return (true);
+}
+
+
+//
+// 'pipeline_usecs()' - Get the current time in microseconds.
+//
+
+static size_t				// O - Current time in microseconds
+pipeline_usecs(void)
+{
+  struct timeval	curtime;	// Current time
+
+
+  gettimeofday(&curtime, NULL);
+
+  return ((size_t)curtime.tv_sec * 1000000 + (size_t)curtime.tv_usec);
+}
+
+
+//
+// 'pipeline_wait()' - Wait for a band to reach the given state.
+//
+
+static bool				// O - `true` when ready, `false` if the pipeline was aborted
+pipeline_wait(
+    _pappl_pipeline_t *pipeline,	// I - Raster pipeline
+    _pappl_band_t     *band,		// I - Band
+    _pappl_bstate_t   state)		// I - Band state to wait for
+{
+  bool	ret;				// Return value
+
+
+  pthread_mutex_lock(&pipeline->mutex);
+
+  while (band->state != state && !pipeline->abort)
+    pthread_cond_wait(&pipeline->cond, &pipeline->mutex);
+
+  ret = !pipeline->abort;
+
+  pthread_mutex_unlock(&pipeline->mutex);
+
+  return (ret);
+}
+
+
+//
+// 'pipeline_write()' - Write bands of raster data to the driver.
+//
+// The writer thread runs for the whole job, writing bands in ring order until
+// the pipeline is stopped.
+//
+
+static void *				// O - Thread exit status
+pipeline_write(
+    _pappl_pipeline_t *pipeline)	// I - Raster pipeline
+{
+  pappl_job_t		*job = pipeline->job;
+					// Job
+  pappl_printer_t	*printer = job->printer;
+					// Printer
+  pappl_poptions_t	*options;	// Job options
+  cups_page_header2_t	*header;	// Page header
+  _pappl_band_t		*band;		// Current band
+  unsigned		b,		// Current band number
+			i,		// Line within band
+			y;		// Current line
+  size_t		start;		// Start time
+
+
+  for (b = 0;; b = (b + 1) % _PAPPL_PIPELINE_BANDS)
+  {
+    // Wait for the next band to be converted...
+    band = pipeline->bands + b;
+
+    if (!pipeline_wait(pipeline, band, _PAPPL_BAND_CONVERTED))
+      break;
+
+    start   = pipeline_usecs();
+    options = pipeline->options;
+    header  = pipeline->header;
+
+    for (i = 0, y = band->y; i < band->count; i ++, y ++)
+    {
+      if (pipeline->dither)
+	(printer->driver_data.rwrite)(job, options, job->printer->device, y, band->line + i * options->header.cupsBytesPerLine);
+      else
+	(printer->driver_data.rwrite)(job, options, job->printer->device, y, band->pixels + i * header->cupsBytesPerLine);
+    }
+
+    pipeline_done(pipeline, band, _PAPPL_BAND_FREE, _PAPPL_STAGE_WRITE, start);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'prerip_supported()' - Determine whether a filter can be used to pre-RIP.
+//
+// Only the built-in image filters, which send their output through the
+// driver's raster callbacks, can be captured in a pre-RIP raster file.
+//
+
+static bool				// O - `true` if supported, `false` otherwise
+prerip_supported(
+    _pappl_mime_filter_t *filter)	// I - Filter
+{
+#ifdef HAVE_LIBJPEG
+  if (filter->cb == _papplJobFilterJPEG)
+    return (true);
+#endif // HAVE_LIBJPEG
+
+#ifdef HAVE_LIBPNG
+  if (filter->cb == _papplJobFilterPNG)
+    return (true);
+#endif // HAVE_LIBPNG
+
+  (void)filter;
+
+  return (false);
+}
+
+
+//
+// 'process_raster()' - Send raster data to the driver.
+//
+// This function is used for streamed and spooled Apple/PWG Raster jobs and for
+// jobs that have been pre-RIPped to a PWG Raster file.  Pre-RIP files contain
+// a single copy and are read again from "fd" for each additional copy.
+//
+// Each page is run through a three stage pipeline - the calling thread reads
+// bands of lines from the raster stream, a conversion thread dithers them as
+// needed, and a writer thread sends them to the driver - so that reading from
+// the network, converting, and writing to the device can overlap.
+//
+
+static void
+process_raster(
+    pappl_job_t   *job,			// I - Job
+    cups_raster_t *ras,			// I - Raster stream
+    int           fd,			// I - Raster file descriptor or `-1` for a stream
+    bool          preripped)		// I - Pre-RIPped raster data?
+{
+  pappl_printer_t	*printer = job->printer;
+					// Printer for job
+  _pappl_joptions_t	joptions[2],	// Compiled grayscale and color options
+			*jopt;		// Compiled options for current page
+  pappl_poptions_t	*options;	// Job options
+  cups_page_header2_t	header;		// Page header
+  unsigned		header_pages;	// Number of pages from page header
+  _pappl_pipeline_t	pipeline;	// Raster pipeline
+  cups_raster_t		*copy_ras = NULL;
+					// Raster stream for additional copies
+  int			copy = 1;	// Current copy
+  unsigned		page = 0,	// Current page
+			y;		// Lines read
+  size_t		start,		// Start time
+			elapsed;	// Elapsed time
+
+
+  // Prepare options...
+  if (!cupsRasterReadHeader2(ras, &header))
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read raster stream - %s", cupsLastErrorString());
+    job->state = IPP_JSTATE_ABORTED;
+    return;
+  }
+
+  if (preripped)
+    header_pages = job->impressions;	// Already set by the filter
+  else if ((header_pages = header.cupsInteger[CUPS_RASTER_PWG_TotalPageCount]) > 0)
+    papplJobSetImpressions(job, (int)header.cupsInteger[CUPS_RASTER_PWG_TotalPageCount]);
+
+  // The job options only depend on whether a page is in color, so they are
+  // compiled once per job rather than once per page...
+  memset(joptions, 0, sizeof(joptions));
+
+  jopt    = raster_options(job, joptions, &header, preripped);
+  options = &jopt->options;
+
+  if (!(printer->driver_data.rstartjob)(job, options, job->printer->device))
+  {
+    job->state = IPP_JSTATE_ABORTED;
+    return;
+  }
+
+  memset(&pipeline, 0, sizeof(pipeline));
+  pthread_mutex_init(&pipeline.mutex, NULL);
+  pthread_cond_init(&pipeline.cond, NULL);
+
+  pipeline.job     = job;
+  pipeline.header  = &header;
+
+  start = pipeline_usecs();
+
+  if (!pipeline_start(&pipeline))
+  {
+    job->state = IPP_JSTATE_ABORTED;
+    goto end_job;
+  }
+
+  // Print pages...
+  for (;;)
+  {
+    if (job->is_canceled)
+      break;
+
+    page ++;
+    papplJobSetImpressionsCompleted(job, 1);
+
+    papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Page %u raster data is %ux%ux%u (%s)", page, header.cupsWidth, header.cupsHeight, header.cupsBitsPerPixel, cups_cspace_string(header.cupsColorSpace));
+
+    // Set options for this page...
+    jopt    = raster_options(job, joptions, &header, preripped);
+    options = &jopt->options;
+
+    if (header.cupsWidth == 0 || header.cupsHeight == 0 || (header.cupsBitsPerColor != 1 && header.cupsBitsPerColor != 8) || header.cupsColorOrder != CUPS_ORDER_CHUNKED || (header.cupsBytesPerLine != ((header.cupsWidth * header.cupsBitsPerPixel + 7) / 8)))
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Bad raster data seen.");
+      papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_FORMAT_ERROR, PAPPL_JREASON_NONE);
+      job->state = IPP_JSTATE_ABORTED;
+      break;
+    }
+
+    if (header.cupsWidth > jopt->header.cupsWidth || header.cupsHeight > jopt->header.cupsHeight || (header.cupsBitsPerPixel > 8 && !(printer->driver_data.color_supported & PAPPL_COLOR_MODE_COLOR)))
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unsupported raster data seen.");
+      papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_UNPRINTABLE_ERROR, PAPPL_JREASON_NONE);
+      job->state = IPP_JSTATE_ABORTED;
+      break;
+    }
+
+    if (jopt->header.cupsBitsPerPixel >= 8 && header.cupsBitsPerPixel >= 8)
+    {
+      // Use page header from client...
+      options->header   = header;
+      jopt->page_header = true;
+    }
+    else if (jopt->page_header)
+    {
+      // Use compiled page header...
+      options->header   = jopt->header;
+      jopt->page_header = false;
+    }
+
+    pipeline.options = options;
+
+    if (!(printer->driver_data.rstartpage)(job, options, job->printer->device, page))
+    {
+      job->state = IPP_JSTATE_ABORTED;
+      break;
+    }
+
+    // Run the page through the pipeline...
+    if (!pipeline_page(&pipeline))
+    {
+      job->state = IPP_JSTATE_ABORTED;
+      break;
+    }
+
+    y = pipeline_read(&pipeline, ras);
+
+    if (!(printer->driver_data.rendpage)(job, options, job->printer->device, page))
+    {
+      job->state = IPP_JSTATE_ABORTED;
+      break;
+    }
+
+    if (job->is_canceled)
+      break;
+    else if (y < header.cupsHeight)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read page from raster stream - %s", cupsLastErrorString());
+      job->state = IPP_JSTATE_ABORTED;
+      break;
+    }
+
+    if (!cupsRasterReadHeader2(ras, &header))
+    {
+      // Pre-RIP files only contain one copy, so send them again for each
+      // additional copy...
+      if (!preripped || fd < 0 || copy >= options->copies)
+        break;
+
+      if ((ras = next_copy(job, &copy_ras, fd)) == NULL || !cupsRasterReadHeader2(ras, &header))
+      {
+        papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read raster file for copy %d.", copy + 1);
+        job->state = IPP_JSTATE_ABORTED;
+        break;
+      }
+
+      copy ++;
+    }
+  }
+
+  pipeline_finish(&pipeline);
+
+  end_job:
+
+  if (copy_ras)
+    cupsRasterClose(copy_ras);
+
+  if (!(printer->driver_data.rendjob)(job, options, job->printer->device))
+    job->state = IPP_JSTATE_ABORTED;
+  else if (header_pages == 0)
+    papplJobSetImpressions(job, (int)page);
+
+  // Report how busy each stage of the pipeline was...
+  if ((elapsed = pipeline_usecs() - start) > 0)
+    papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Raster pipeline utilization: read %d%%, convert %d%%, write %d%%.", (int)(100 * pipeline.busy_usecs[_PAPPL_STAGE_READ] / elapsed), (int)(100 * pipeline.busy_usecs[_PAPPL_STAGE_CONVERT] / elapsed), (int)(100 * pipeline.busy_usecs[_PAPPL_STAGE_WRITE] / elapsed));
+
+  pthread_mutex_destroy(&pipeline.mutex);
+  pthread_cond_destroy(&pipeline.cond);
+}
+
+
+//
+// 'raster_options()' - Get the compiled job options for a raster page.
+//
+// The options are compiled with @link papplJobGetPrintOptions@ the first time
+// a grayscale or color page is seen and then reused for the rest of the job.
+//
+
+static _pappl_joptions_t *		// O - Compiled options
+raster_options(
+    pappl_job_t         *job,		// I - Job
+    _pappl_joptions_t   *joptions,	// I - Compiled grayscale and color options
+    cups_page_header2_t *header,	// I - Page header
+    bool                preripped)	// I - Pre-RIPped raster data?
+{
+  bool			color = header->cupsBitsPerPixel > 8;
+					// Color page?
+  _pappl_joptions_t	*jopt = joptions + (color ? 1 : 0);
+					// Compiled options
+
+
+  if (!jopt->valid)
+  {
+    papplJobGetPrintOptions(job, &jopt->options, job->impressions, color);
+
+    if (preripped)
+      jopt->options.orientation_requested = IPP_ORIENT_PORTRAIT;
+
+    jopt->header      = jopt->options.header;
+    jopt->page_header = false;
+    jopt->valid       = true;
+  }
+
+  return (jopt);
+}
+
+
 //
 // 'start_job()' - Start processing a job...
 //
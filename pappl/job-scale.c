@@ -0,0 +1,498 @@
+//
+// Image scaling functions for the Printer Application Framework
+//
+// Copyright © 2020 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+//
+// Include necessary headers...
+//
+
+#include "pappl-private.h"
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define _PAPPL_SCALE_X86 1
+#  include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#  define _PAPPL_SCALE_NEON 1
+#  include <arm_neon.h>
+#endif // __GNUC__ && (__x86_64__ || __i386__)
+
+
+//
+// Constants...
+//
+
+#define _PAPPL_SCALE_BITS	7	// Bits of fraction in weights
+#define _PAPPL_SCALE_ONE	(1 << _PAPPL_SCALE_BITS)
+					// Weight of 1.0
+
+
+//
+// Local types...
+//
+
+typedef void (*_pappl_blend_cb_t)(unsigned char *dst, const unsigned char *src0, const unsigned char *src1, size_t count, unsigned frac);
+
+struct _pappl_scale_s			// Image scaler
+{
+  unsigned		width,			// Source width in columns
+			height,			// Source height in lines
+			depth,			// Bytes per pixel
+			xsize,			// Scaled width in columns
+			ysize,			// Scaled height in lines
+			xnext;			// Offset to the next source pixel
+  unsigned		*xoffsets;		// Source offset for each column
+  unsigned char		*xfracs;		// Weight of the next source pixel for each column
+  unsigned char		*rows[2],		// Scaled source lines
+			*line;			// Scaled output line
+  int			rowy[2];		// Source line numbers in "rows"
+};
+
+
+//
+// Local functions...
+//
+
+static void	blend_init(void);
+static void	blend_scalar(unsigned char *dst, const unsigned char *src0, const unsigned char *src1, size_t count, unsigned frac);
+#ifdef _PAPPL_SCALE_X86
+static void	blend_avx2(unsigned char *dst, const unsigned char *src0, const unsigned char *src1, size_t count, unsigned frac) __attribute__((target("avx2")));
+static void	blend_sse2(unsigned char *dst, const unsigned char *src0, const unsigned char *src1, size_t count, unsigned frac) __attribute__((target("sse2")));
+#endif // _PAPPL_SCALE_X86
+#ifdef _PAPPL_SCALE_NEON
+static void	blend_neon(unsigned char *dst, const unsigned char *src0, const unsigned char *src1, size_t count, unsigned frac);
+#endif // _PAPPL_SCALE_NEON
+static unsigned	scale_position(unsigned i, unsigned size, unsigned scaled);
+static void	scale_row(_pappl_scale_t *scale, unsigned char *dst, const unsigned char *src);
+
+
+//
+// Local globals...
+//
+
+static pthread_once_t		blend_once = PTHREAD_ONCE_INIT;
+					// One-time initialization control
+static _pappl_blend_cb_t	blend_cb = blend_scalar;
+					// Blend function
+
+
+//
+// '_papplJobScaleCreate()' - Create a bilinear image scaler.
+//
+// The scaler maps the center of each output pixel back to the source image
+// and blends the four nearest source pixels using fixed-point weights.  The
+// source column offsets and weights are computed once, and each source line
+// is scaled horizontally once and kept until it is no longer needed.
+//
+
+_pappl_scale_t *			// O - Image scaler or `NULL` on error
+_papplJobScaleCreate(
+    unsigned width,			// I - Source width in columns
+    unsigned height,			// I - Source height in lines
+    unsigned depth,			// I - Bytes per pixel
+    unsigned xsize,			// I - Scaled width in columns
+    unsigned ysize)			// I - Scaled height in lines
+{
+  _pappl_scale_t	*scale;		// Image scaler
+  unsigned		x,		// Current column
+			pos;		// Source position
+  size_t		bytes;		// Bytes per scaled line
+
+
+  if (width == 0 || height == 0 || depth == 0 || xsize == 0 || ysize == 0)
+    return (NULL);
+
+  pthread_once(&blend_once, blend_init);
+
+  if ((scale = calloc(1, sizeof(_pappl_scale_t))) == NULL)
+    return (NULL);
+
+  bytes = (size_t)xsize * (size_t)depth;
+
+  scale->width   = width;
+  scale->height  = height;
+  scale->depth   = depth;
+  scale->xsize   = xsize;
+  scale->ysize   = ysize;
+  scale->xnext   = width > 1 ? depth : 0;
+  scale->rowy[0] = -1;
+  scale->rowy[1] = -1;
+
+  if ((scale->xoffsets = calloc(xsize, sizeof(unsigned))) == NULL || (scale->xfracs = calloc(xsize, 1)) == NULL || (scale->rows[0] = malloc(bytes)) == NULL || (scale->rows[1] = malloc(bytes)) == NULL || (scale->line = malloc(bytes)) == NULL)
+  {
+    _papplJobScaleDelete(scale);
+    return (NULL);
+  }
+
+  // Compute the source offset and weight for each column...
+  for (x = 0; x < xsize; x ++)
+  {
+    pos = scale_position(x, width, xsize);
+
+    scale->xoffsets[x] = (pos >> _PAPPL_SCALE_BITS) * depth;
+    scale->xfracs[x]   = (unsigned char)(pos & (_PAPPL_SCALE_ONE - 1));
+
+    if (pos >= (width - 1) * _PAPPL_SCALE_ONE && width > 1)
+    {
+      // Use the last pixel at the right edge...
+      scale->xoffsets[x] = (width - 2) * depth;
+      scale->xfracs[x]   = _PAPPL_SCALE_ONE;
+    }
+  }
+
+  return (scale);
+}
+
+
+//
+// '_papplJobScaleDelete()' - Delete a bilinear image scaler.
+//
+
+void
+_papplJobScaleDelete(
+    _pappl_scale_t *scale)		// I - Image scaler
+{
+  if (scale)
+  {
+    free(scale->xoffsets);
+    free(scale->xfracs);
+    free(scale->rows[0]);
+    free(scale->rows[1]);
+    free(scale->line);
+    free(scale);
+  }
+}
+
+
+//
+// '_papplJobScaleGetLine()' - Get a scaled line.
+//
+// Source lines are requested from the callback in increasing order, and at
+// most two source lines are requested for each scaled line.  Scaled lines
+// must also be requested in increasing order.
+//
+
+const unsigned char *			// O - Scaled pixels or `NULL` on error
+_papplJobScaleGetLine(
+    _pappl_scale_t    *scale,		// I - Image scaler
+    unsigned          y,		// I - Scaled line number
+    _pappl_scale_cb_t cb,		// I - Source line callback
+    void              *cbdata)		// I - Source line callback data
+{
+  unsigned		pos,		// Source position
+			y0,		// First source line
+			y1,		// Second source line
+			frac;		// Weight of second source line
+  const unsigned char	*src;		// Source pixels
+  unsigned char		*temp;		// Temporary line pointer
+
+
+  // Figure out which source lines are needed...
+  pos  = scale_position(y, scale->height, scale->ysize);
+  y0   = pos >> _PAPPL_SCALE_BITS;
+  frac = pos & (_PAPPL_SCALE_ONE - 1);
+
+  if (scale->height == 1)
+  {
+    y1   = 0;
+    frac = 0;
+  }
+  else if (y0 >= scale->height - 1)
+  {
+    // Use the last line at the bottom edge...
+    y0   = scale->height - 2;
+    y1   = scale->height - 1;
+    frac = _PAPPL_SCALE_ONE;
+  }
+  else
+    y1 = y0 + 1;
+
+  // Move the window down to the needed lines...
+  if (scale->rowy[1] == (int)y0)
+  {
+    temp           = scale->rows[0];
+    scale->rows[0] = scale->rows[1];
+    scale->rows[1] = temp;
+    scale->rowy[0] = scale->rowy[1];
+    scale->rowy[1] = -1;
+  }
+
+  if (scale->rowy[0] != (int)y0)
+  {
+    if ((src = (cb)(cbdata, y0)) == NULL)
+      return (NULL);
+
+    scale_row(scale, scale->rows[0], src);
+    scale->rowy[0] = (int)y0;
+  }
+
+  if (frac == 0)
+    return (scale->rows[0]);
+
+  if (scale->rowy[1] != (int)y1)
+  {
+    if ((src = (cb)(cbdata, y1)) == NULL)
+      return (NULL);
+
+    scale_row(scale, scale->rows[1], src);
+    scale->rowy[1] = (int)y1;
+  }
+
+  if (frac == _PAPPL_SCALE_ONE)
+    return (scale->rows[1]);
+
+  // Blend the two lines...
+  (blend_cb)(scale->line, scale->rows[0], scale->rows[1], (size_t)scale->xsize * (size_t)scale->depth, frac);
+
+  return (scale->line);
+}
+
+
+#ifdef _PAPPL_SCALE_X86
+//
+// 'blend_avx2()' - Blend two lines using AVX2 instructions.
+//
+
+static void
+blend_avx2(
+    unsigned char       *dst,		// I - Output pixels
+    const unsigned char *src0,		// I - First line
+    const unsigned char *src1,		// I - Second line
+    size_t              count,		// I - Number of bytes
+    unsigned            frac)		// I - Weight of second line
+{
+  __m256i	w0 = _mm256_set1_epi16((short)(_PAPPL_SCALE_ONE - frac)),
+					// Weight of first line
+		w1 = _mm256_set1_epi16((short)frac),
+					// Weight of second line
+		round = _mm256_set1_epi16(_PAPPL_SCALE_ONE / 2),
+					// Rounding constant
+		zero = _mm256_setzero_si256(),
+					// Zero
+		a, b,			// Source pixels
+		lo, hi;			// 16-bit results
+
+
+  for (; count >= 32; count -= 32, src0 += 32, src1 += 32, dst += 32)
+  {
+    a  = _mm256_loadu_si256((const __m256i *)src0);
+    b  = _mm256_loadu_si256((const __m256i *)src1);
+    lo = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(a, zero), w0), _mm256_mullo_epi16(_mm256_unpacklo_epi8(b, zero), w1)), round);
+    hi = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(a, zero), w0), _mm256_mullo_epi16(_mm256_unpackhi_epi8(b, zero), w1)), round);
+
+    // Unpack and pack work within 128-bit lanes, so the byte order is kept...
+    _mm256_storeu_si256((__m256i *)dst, _mm256_packus_epi16(_mm256_srli_epi16(lo, _PAPPL_SCALE_BITS), _mm256_srli_epi16(hi, _PAPPL_SCALE_BITS)));
+  }
+
+  if (count > 0)
+    blend_sse2(dst, src0, src1, count, frac);
+}
+#endif // _PAPPL_SCALE_X86
+
+
+//
+// 'blend_init()' - Choose the blend implementation for this CPU.
+//
+
+static void
+blend_init(void)
+{
+#ifdef _PAPPL_SCALE_X86
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx2"))
+    blend_cb = blend_avx2;
+  else if (__builtin_cpu_supports("sse2"))
+    blend_cb = blend_sse2;
+
+#elif defined(_PAPPL_SCALE_NEON)
+  // NEON is always available on 64-bit ARM...
+  blend_cb = blend_neon;
+#endif // _PAPPL_SCALE_X86
+}
+
+
+#ifdef _PAPPL_SCALE_NEON
+//
+// 'blend_neon()' - Blend two lines using NEON instructions.
+//
+
+static void
+blend_neon(
+    unsigned char       *dst,		// I - Output pixels
+    const unsigned char *src0,		// I - First line
+    const unsigned char *src1,		// I - Second line
+    size_t              count,		// I - Number of bytes
+    unsigned            frac)		// I - Weight of second line
+{
+  uint8x8_t	w0 = vdup_n_u8((uint8_t)(_PAPPL_SCALE_ONE - frac)),
+					// Weight of first line
+		w1 = vdup_n_u8((uint8_t)frac);
+					// Weight of second line
+  uint8x16_t	a, b;			// Source pixels
+  uint16x8_t	lo, hi;			// 16-bit results
+
+
+  for (; count >= 16; count -= 16, src0 += 16, src1 += 16, dst += 16)
+  {
+    a  = vld1q_u8(src0);
+    b  = vld1q_u8(src1);
+    lo = vmlal_u8(vmull_u8(vget_low_u8(a), w0), vget_low_u8(b), w1);
+    hi = vmlal_u8(vmull_u8(vget_high_u8(a), w0), vget_high_u8(b), w1);
+
+    vst1q_u8(dst, vcombine_u8(vrshrn_n_u16(lo, _PAPPL_SCALE_BITS), vrshrn_n_u16(hi, _PAPPL_SCALE_BITS)));
+  }
+
+  if (count > 0)
+    blend_scalar(dst, src0, src1, count, frac);
+}
+#endif // _PAPPL_SCALE_NEON
+
+
+//
+// 'blend_scalar()' - Blend two lines one byte at a time.
+//
+
+static void
+blend_scalar(
+    unsigned char       *dst,		// I - Output pixels
+    const unsigned char *src0,		// I - First line
+    const unsigned char *src1,		// I - Second line
+    size_t              count,		// I - Number of bytes
+    unsigned            frac)		// I - Weight of second line
+{
+  unsigned	ifrac = _PAPPL_SCALE_ONE - frac;
+					// Weight of first line
+
+
+  for (; count > 0; count --)
+    *dst++ = (unsigned char)((*src0++ * ifrac + *src1++ * frac + _PAPPL_SCALE_ONE / 2) >> _PAPPL_SCALE_BITS);
+}
+
+
+#ifdef _PAPPL_SCALE_X86
+//
+// 'blend_sse2()' - Blend two lines using SSE2 instructions.
+//
+
+static void
+blend_sse2(
+    unsigned char       *dst,		// I - Output pixels
+    const unsigned char *src0,		// I - First line
+    const unsigned char *src1,		// I - Second line
+    size_t              count,		// I - Number of bytes
+    unsigned            frac)		// I - Weight of second line
+{
+  __m128i	w0 = _mm_set1_epi16((short)(_PAPPL_SCALE_ONE - frac)),
+					// Weight of first line
+		w1 = _mm_set1_epi16((short)frac),
+					// Weight of second line
+		round = _mm_set1_epi16(_PAPPL_SCALE_ONE / 2),
+					// Rounding constant
+		zero = _mm_setzero_si128(),
+					// Zero
+		a, b,			// Source pixels
+		lo, hi;			// 16-bit results
+
+
+  // Weights are at most 128, so 255 * 128 fits in an unsigned 16-bit value...
+  for (; count >= 16; count -= 16, src0 += 16, src1 += 16, dst += 16)
+  {
+    a  = _mm_loadu_si128((const __m128i *)src0);
+    b  = _mm_loadu_si128((const __m128i *)src1);
+    lo = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), w0), _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), w1)), round);
+    hi = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), w0), _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), w1)), round);
+
+    _mm_storeu_si128((__m128i *)dst, _mm_packus_epi16(_mm_srli_epi16(lo, _PAPPL_SCALE_BITS), _mm_srli_epi16(hi, _PAPPL_SCALE_BITS)));
+  }
+
+  if (count > 0)
+    blend_scalar(dst, src0, src1, count, frac);
+}
+#endif // _PAPPL_SCALE_X86
+
+
+//
+// 'scale_position()' - Compute the source position of a scaled pixel.
+//
+// The position is the center of scaled pixel "i" in source pixels, with
+// `_PAPPL_SCALE_BITS` bits of fraction, clamped to the first source pixel.
+//
+
+static unsigned				// O - Source position
+scale_position(unsigned i,		// I - Scaled pixel
+               unsigned size,		// I - Source size
+               unsigned scaled)		// I - Scaled size
+{
+  long long	pos;			// Source position
+
+
+  // pos = ((i + 0.5) * size / scaled - 0.5) * _PAPPL_SCALE_ONE
+  pos = (((2 * (long long)i + 1) * size - scaled) * _PAPPL_SCALE_ONE) / (2 * (long long)scaled);
+
+  return (pos < 0 ? 0 : (unsigned)pos);
+}
+
+
+//
+// 'scale_row()' - Scale a source line horizontally.
+//
+
+static void
+scale_row(_pappl_scale_t      *scale,	// I - Image scaler
+          unsigned char       *dst,	// I - Scaled line
+          const unsigned char *src)	// I - Source line
+{
+  unsigned		x,		// Current column
+			c,		// Current component
+			frac,		// Weight of next pixel
+			ifrac,		// Weight of current pixel
+			xnext = scale->xnext;
+					// Offset to next pixel
+  const unsigned	*xoffsets = scale->xoffsets;
+					// Source offsets
+  const unsigned char	*xfracs = scale->xfracs,
+					// Source weights
+			*p;		// Current source pixel
+
+
+  if (scale->depth == 1)
+  {
+    for (x = scale->xsize; x > 0; x --)
+    {
+      p     = src + *xoffsets++;
+      frac  = *xfracs++;
+      ifrac = _PAPPL_SCALE_ONE - frac;
+
+      *dst++ = (unsigned char)((p[0] * ifrac + p[xnext] * frac + _PAPPL_SCALE_ONE / 2) >> _PAPPL_SCALE_BITS);
+    }
+  }
+  else if (scale->depth == 3)
+  {
+    for (x = scale->xsize; x > 0; x --)
+    {
+      p     = src + *xoffsets++;
+      frac  = *xfracs++;
+      ifrac = _PAPPL_SCALE_ONE - frac;
+
+      *dst++ = (unsigned char)((p[0] * ifrac + p[xnext] * frac + _PAPPL_SCALE_ONE / 2) >> _PAPPL_SCALE_BITS);
+      *dst++ = (unsigned char)((p[1] * ifrac + p[xnext + 1] * frac + _PAPPL_SCALE_ONE / 2) >> _PAPPL_SCALE_BITS);
+      *dst++ = (unsigned char)((p[2] * ifrac + p[xnext + 2] * frac + _PAPPL_SCALE_ONE / 2) >> _PAPPL_SCALE_BITS);
+    }
+  }
+  else
+  {
+    for (x = scale->xsize; x > 0; x --)
+    {
+      p     = src + *xoffsets++;
+      frac  = *xfracs++;
+      ifrac = _PAPPL_SCALE_ONE - frac;
+
+      for (c = 0; c < scale->depth; c ++)
+        *dst++ = (unsigned char)((p[c] * ifrac + p[xnext + c] * frac + _PAPPL_SCALE_ONE / 2) >> _PAPPL_SCALE_BITS);
+    }
+  }
+}
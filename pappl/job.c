@@ -15,6 +15,13 @@
 #include "pappl-private.h"
 
 
+//
+// Local functions...
+//
+
+static void	start_prerip(pappl_printer_t *printer);
+
+
 //
 // 'papplJobCancel()' - Cancel a job.
 //
@@ -28,8 +35,10 @@ papplJobCancel(pappl_job_t *job)	// I - Job
   pthread_rwlock_wrlock(&job->rwlock);
   pthread_rwlock_wrlock(&job->printer->rwlock);
 
-  if (job->state == IPP_JSTATE_PROCESSING || (job->state == IPP_JSTATE_HELD && job->fd >= 0))
+  if (job->state == IPP_JSTATE_PROCESSING || (job->state == IPP_JSTATE_HELD && job->fd >= 0) || job->prerip == _PAPPL_PRERIP_RUNNING)
   {
+    // The job is still in use, so let the processing or pre-RIP thread finish
+    // canceling it...
     job->is_canceled = true;
   }
   else
@@ -39,7 +48,8 @@ papplJobCancel(pappl_job_t *job)	// I - Job
 
     _papplJobRemoveFile(job);
 
-    cupsArrayRemove(job->printer->active_jobs, job);
+    if (cupsArrayRemove(job->printer->active_jobs, job))
+      job->printer->num_active_jobs --;
     cupsArrayAdd(job->printer->completed_jobs, job);
   }
 
@@ -145,10 +155,11 @@ _papplJobCreate(
 
   cupsArrayAdd(printer->all_jobs, job);
   cupsArrayAdd(printer->active_jobs, job);
+  printer->num_active_jobs ++;
 
   pthread_rwlock_unlock(&printer->rwlock);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplSystemStateChanged(printer->system);
 
   return (job);
 }
@@ -284,6 +295,30 @@ _papplJobRemoveFile(pappl_job_t *job)	// I - Job
 
   free(job->filename);
   job->filename = NULL;
+
+  _papplJobRemovePreRIPFile(job);
+}
+
+
+//
+// '_papplJobRemovePreRIPFile()' - Remove the pre-RIP raster file for a job.
+//
+// The printer must be write-locked by the caller.
+//
+
+void
+_papplJobRemovePreRIPFile(
+    pappl_job_t *job)			// I - Job
+{
+  if (!job->prerip_filename)
+    return;
+
+  unlink(job->prerip_filename);
+  free(job->prerip_filename);
+  job->prerip_filename = NULL;
+
+  job->printer->prerip_size -= job->prerip_size;
+  job->prerip_size          = 0;
 }
 
 
@@ -376,12 +411,7 @@ _papplPrinterCheckJobs(
 
   papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Checking for new jobs to process.");
 
-  if (printer->processing_job)
-  {
-    papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Printer is already processing job %d.", printer->processing_job->job_id);
-    return;
-  }
-  else if (printer->is_deleted)
+  if (printer->is_deleted)
   {
     papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Printer is being deleted.");
     return;
@@ -394,35 +424,59 @@ _papplPrinterCheckJobs(
 
   pthread_rwlock_wrlock(&printer->rwlock);
 
-  for (job = (pappl_job_t *)cupsArrayFirst(printer->active_jobs);
-       job;
-       job = (pappl_job_t *)cupsArrayNext(printer->active_jobs))
+  if (printer->processing_job)
+  {
+    papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Printer is already processing job %d.", printer->processing_job->job_id);
+  }
+  else
   {
-    if (job->state == IPP_JSTATE_PENDING)
+    for (job = (pappl_job_t *)cupsArrayFirst(printer->active_jobs);
+	 job;
+	 job = (pappl_job_t *)cupsArrayNext(printer->active_jobs))
     {
-      pthread_t	t;			// Thread
+      if (job->state == IPP_JSTATE_PENDING)
+      {
+        if (job->prerip == _PAPPL_PRERIP_RUNNING)
+        {
+          // Wait for the pre-RIP to finish, it will check for jobs again when
+          // it is done...
+	  papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Waiting for pre-RIP of job %d to finish.", job->job_id);
+	  break;
+        }
 
-      papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Starting job %d.", job->job_id);
+	papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Starting job %d.", job->job_id);
 
-      if (pthread_create(&t, NULL, (void *(*)(void *))_papplJobProcess, job))
-      {
-	job->state     = IPP_JSTATE_ABORTED;
-	job->completed = time(NULL);
+	// Mark the job as the printer's processing job now so that it is not
+	// queued a second time while it waits for a worker thread...
+	printer->processing_job = job;
 
-	cupsArrayRemove(printer->active_jobs, job);
-	cupsArrayAdd(printer->completed_jobs, job);
+	if (!_papplSystemAddWork(printer->system, (_pappl_work_cb_t)_papplJobProcess, job))
+	{
+	  printer->processing_job = NULL;
 
-	if (!printer->system->clean_time)
-	  printer->system->clean_time = time(NULL) + 60;
+	  job->state     = IPP_JSTATE_ABORTED;
+	  job->completed = time(NULL);
+
+	  _papplJobRemovePreRIPFile(job);
+
+	  if (cupsArrayRemove(printer->active_jobs, job))
+	    printer->num_active_jobs --;
+	  cupsArrayAdd(printer->completed_jobs, job);
+
+	  if (!printer->system->clean_time)
+	    printer->system->clean_time = time(NULL) + 60;
+	}
+	break;
       }
-      else
-	pthread_detach(t);
-      break;
     }
+
+    if (!job)
+      papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "No jobs to process at this time.");
   }
 
-  if (!job)
-    papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "No jobs to process at this time.");
+  // Pre-RIP the following jobs while the printer is busy...
+  if (printer->processing_job)
+    start_prerip(printer);
 
   pthread_rwlock_unlock(&printer->rwlock);
 }
@@ -459,6 +513,8 @@ void
 papplSystemCleanJobs(
     pappl_system_t *system)		// I - System
 {
+  _pappl_plist_t	*plist;		// Printer list
+  int			i;		// Looping var
   pappl_printer_t	*printer;	// Current printer
   pappl_job_t		*job;		// Current job
   time_t		cleantime;	// Clean time
@@ -466,10 +522,12 @@ papplSystemCleanJobs(
 
   cleantime = time(NULL) - 60;
 
-  pthread_rwlock_rdlock(&system->rwlock);
+  plist = _papplSystemGetPrinters(system);
 
-  for (printer = (pappl_printer_t *)cupsArrayFirst(system->printers); printer; printer = (pappl_printer_t *)cupsArrayNext(system->printers))
+  for (i = 0; i < plist->num_printers; i ++)
   {
+    printer = plist->printers[i];
+
     if (cupsArrayCount(printer->completed_jobs) == 0 || printer->max_completed_jobs <= 0)
       continue;
 
@@ -477,7 +535,7 @@ papplSystemCleanJobs(
 
     for (job = (pappl_job_t *)cupsArrayFirst(printer->completed_jobs); job; job = (pappl_job_t *)cupsArrayNext(printer->completed_jobs))
     {
-      if (job->completed && job->completed < cleantime && cupsArrayCount(printer->completed_jobs) > printer->max_completed_jobs)
+      if (job->completed && job->completed < cleantime && job->prerip != _PAPPL_PRERIP_RUNNING && cupsArrayCount(printer->completed_jobs) > printer->max_completed_jobs)
       {
 	cupsArrayRemove(printer->completed_jobs, job);
 	cupsArrayRemove(printer->all_jobs, job);
@@ -489,5 +547,58 @@ papplSystemCleanJobs(
     pthread_rwlock_unlock(&printer->rwlock);
   }
 
-  pthread_rwlock_unlock(&system->rwlock);
+  _papplSystemReleasePrinters(system, plist);
+}
+
+
+//
+// 'start_prerip()' - Start pre-RIPping pending jobs.
+//
+// Pending jobs are converted to raster data, in order, while the printer is
+// busy with the current job so that the next job can be sent to the device
+// as soon as the current job is done.  The number of pre-RIPped jobs and the
+// amount of spooled raster data is limited by the "max_prerip_jobs" and
+// "max_prerip_size" values.
+//
+// The printer must be write-locked by the caller.
+//
+
+static void
+start_prerip(pappl_printer_t *printer)	// I - Printer
+{
+  pappl_job_t	*job;			// Current job
+  int		count = 0;		// Number of pre-RIPped jobs
+
+
+  if (printer->max_prerip_jobs <= 0 || printer->is_deleted)
+    return;
+
+  for (job = (pappl_job_t *)cupsArrayFirst(printer->active_jobs);
+       job;
+       job = (pappl_job_t *)cupsArrayNext(printer->active_jobs))
+  {
+    if (job == printer->processing_job || job->state != IPP_JSTATE_PENDING || !job->filename || job->prerip == _PAPPL_PRERIP_FAILED)
+      continue;
+
+    if (job->prerip == _PAPPL_PRERIP_NONE)
+    {
+      if (count >= printer->max_prerip_jobs || printer->prerip_size >= printer->max_prerip_size)
+        break;
+
+      papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Queuing job for pre-RIP.");
+
+      job->prerip = _PAPPL_PRERIP_RUNNING;
+      printer->num_prerips ++;
+
+      if (!_papplSystemAddWork(printer->system, (_pappl_work_cb_t)_papplJobPreRIP, job))
+      {
+        job->prerip = _PAPPL_PRERIP_FAILED;
+        printer->num_prerips --;
+        break;
+      }
+    }
+
+    if (++ count >= printer->max_prerip_jobs)
+      break;
+  }
 }
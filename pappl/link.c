@@ -73,7 +73,7 @@ papplSystemAddLink(
   if (!system || !label || !path_or_url)
     return;
 
-  pthread_rwlock_wrlock(&system->rwlock);
+  _papplSystemWRLock(system);
 
   if (!system->links)
     system->links = cupsArrayNew3((cups_array_func_t)compare_links, NULL, NULL, 0, (cups_acopy_func_t)copy_link, (cups_afree_func_t)free_link);
@@ -45,17 +45,7 @@ int					// O - Number of jobs
 papplPrinterGetActiveJobs(
     pappl_printer_t *printer)		// I - Printer
 {
-  int	num_jobs = 0;			// Number of jobs
-
-
-  if (printer)
-  {
-    pthread_rwlock_rdlock(&printer->rwlock);
-    num_jobs = cupsArrayCount(printer->active_jobs);
-    pthread_rwlock_unlock(&printer->rwlock);
-  }
-
-  return (num_jobs);
+  return (printer ? atomic_load_explicit(&printer->num_active_jobs, memory_order_relaxed) : 0);
 }
 
 
@@ -158,7 +148,7 @@ int					// O - Number of printed impressions/sides
 papplPrinterGetImpressionsCompleted(
     pappl_printer_t *printer)		// I - Printer
 {
-  return (printer ? printer->impcompleted : 0);
+  return (printer ? atomic_load_explicit(&printer->impcompleted, memory_order_relaxed) : 0);
 }
 
 
@@ -212,6 +202,30 @@ papplPrinterGetMaxCompletedJobs(
 }
 
 
+//
+// 'papplPrinterGetMaxPreRIPJobs()' - Get the maximum number of pending jobs to pre-RIP.
+//
+
+int					// O - Maximum number of pre-RIP jobs
+papplPrinterGetMaxPreRIPJobs(
+    pappl_printer_t *printer)		// I - Printer
+{
+  return (printer ? printer->max_prerip_jobs : 0);
+}
+
+
+//
+// 'papplPrinterGetMaxPreRIPSize()' - Get the maximum size of pre-RIP spool files.
+//
+
+size_t					// O - Maximum size of pre-RIP spool files in bytes
+papplPrinterGetMaxPreRIPSize(
+    pappl_printer_t *printer)		// I - Printer
+{
+  return (printer ? printer->max_prerip_size : 0);
+}
+
+
 //
 // 'papplPrinterGetName()' - Get the printer name.
 //
@@ -244,7 +258,7 @@ int					// O - Number of active print jobs
 papplPrinterGetNumberOfActiveJobs(
     pappl_printer_t *printer)		// I - Printer
 {
-  return (printer ? cupsArrayCount(printer->active_jobs) : 0);
+  return (printer ? atomic_load_explicit(&printer->num_active_jobs, memory_order_relaxed) : 0);
 }
 
 
@@ -358,17 +372,19 @@ pappl_preason_t				// O - "printer-state-reasons" bit values
 papplPrinterGetReasons(
     pappl_printer_t *printer)		// I - Printer
 {
+  pappl_preason_t	ret;		// Return value
+
+
   if (!printer)
     return (PAPPL_PREASON_NONE);
 
-  if (!printer->device_in_use && !printer->processing_job && (time(NULL) - printer->status_time) > 1 && printer->driver_data.status)
-  {
-    // Update printer status...
-    (printer->driver_data.status)(printer);
-    printer->status_time = time(NULL);
-  }
+  // Printer status is polled in the background, so just return the cached
+  // value...
+  pthread_rwlock_rdlock(&printer->rwlock);
+  ret = printer->state_reasons;
+  pthread_rwlock_unlock(&printer->rwlock);
 
-  return (printer->state_reasons);
+  return (ret);
 }
 
 
@@ -380,7 +396,39 @@ ipp_pstate_t				// O - "printer-state" value
 papplPrinterGetState(
     pappl_printer_t *printer)		// I - Printer
 {
-  return (printer ? printer->state : IPP_PSTATE_STOPPED);
+  return (printer ? atomic_load_explicit(&printer->state, memory_order_relaxed) : IPP_PSTATE_STOPPED);
+}
+
+
+//
+// 'papplPrinterGetStatusMetrics()' - Get the status polling metrics.
+//
+// The metrics report when the printer status was last updated, when it will
+// next be polled, and how long the driver's status callback takes.  The
+// printer status is polled in the background at the interval set with
+// @link papplSystemSetStatusInterval@.
+//
+
+pappl_smetrics_t *			// O - Metrics data or `NULL` on error
+papplPrinterGetStatusMetrics(
+    pappl_printer_t  *printer,		// I - Printer
+    pappl_smetrics_t *metrics)		// I - Buffer for metrics data
+{
+  if (!printer || !metrics)
+    return (NULL);
+
+  pthread_rwlock_rdlock(&printer->rwlock);
+
+  metrics->status_time  = printer->status_time;
+  metrics->next_time    = printer->status_next;
+  metrics->num_polls    = printer->status_polls;
+  metrics->num_failures = printer->status_failures;
+  metrics->last_usecs   = printer->status_usecs;
+  metrics->max_usecs    = printer->status_max_usecs;
+
+  pthread_rwlock_unlock(&printer->rwlock);
+
+  return (metrics);
 }
 
 
@@ -562,7 +610,7 @@ papplPrinterOpenDevice(
     printer->device_in_use = device != NULL;
   }
 
-  pthread_rwlock_wrlock(&printer->rwlock);
+  pthread_rwlock_unlock(&printer->rwlock);
 
   return (device);
 }
@@ -634,7 +682,7 @@ papplPrinterSetContact(
 
   pthread_rwlock_unlock(&printer->rwlock);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplPrinterConfigChanged(printer);
 }
 
 
@@ -665,7 +713,7 @@ papplPrinterSetDNSSDName(
 
   pthread_rwlock_unlock(&printer->rwlock);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplPrinterConfigChanged(printer);
 }
 
 
@@ -691,7 +739,7 @@ papplPrinterSetGeoLocation(
 
   pthread_rwlock_unlock(&printer->rwlock);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplPrinterConfigChanged(printer);
 }
 
 
@@ -714,7 +762,7 @@ papplPrinterSetImpressionsCompleted(
 
   pthread_rwlock_unlock(&printer->rwlock);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplSystemStateChanged(printer->system);
 }
 
 
@@ -740,7 +788,7 @@ papplPrinterSetLocation(
 
   pthread_rwlock_unlock(&printer->rwlock);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplPrinterConfigChanged(printer);
 }
 
 
@@ -763,7 +811,7 @@ papplPrinterSetMaxActiveJobs(
 
   pthread_rwlock_unlock(&printer->rwlock);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplPrinterConfigChanged(printer);
 }
 
 
@@ -786,7 +834,65 @@ papplPrinterSetMaxCompletedJobs(
 
   pthread_rwlock_unlock(&printer->rwlock);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplPrinterConfigChanged(printer);
+}
+
+
+//
+// 'papplPrinterSetMaxPreRIPJobs()' - Set the maximum number of pending jobs to pre-RIP.
+//
+// Image jobs that are waiting for the printer are converted ("pre-RIPped") to
+// a spooled raster stream while the current job is printing, so the next job
+// can be sent to the device as soon as the current job finishes.  Set the
+// maximum to `0` to disable pre-RIP.
+//
+// The default maximum number of pre-RIP jobs is `1`.
+//
+
+void
+papplPrinterSetMaxPreRIPJobs(
+    pappl_printer_t *printer,		// I - Printer
+    int             max_prerip_jobs)	// I - Maximum number of pre-RIP jobs, `0` to disable
+{
+  if (!printer || max_prerip_jobs < 0)
+    return;
+
+  pthread_rwlock_wrlock(&printer->rwlock);
+
+  printer->max_prerip_jobs = max_prerip_jobs;
+  printer->config_time     = time(NULL);
+
+  pthread_rwlock_unlock(&printer->rwlock);
+
+  _papplPrinterConfigChanged(printer);
+}
+
+
+//
+// 'papplPrinterSetMaxPreRIPSize()' - Set the maximum size of pre-RIP spool files.
+//
+// No new jobs are pre-RIPped while the total size of the printer's pre-RIP
+// spool files is at or above this limit.
+//
+// The default maximum size is 64MiB or `67108864` bytes.
+//
+
+void
+papplPrinterSetMaxPreRIPSize(
+    pappl_printer_t *printer,		// I - Printer
+    size_t          max_prerip_size)	// I - Maximum size in bytes
+{
+  if (!printer)
+    return;
+
+  pthread_rwlock_wrlock(&printer->rwlock);
+
+  printer->max_prerip_size = max_prerip_size;
+  printer->config_time     = time(NULL);
+
+  pthread_rwlock_unlock(&printer->rwlock);
+
+  _papplPrinterConfigChanged(printer);
 }
 
 
@@ -812,7 +918,7 @@ papplPrinterSetNextJobID(
 
   pthread_rwlock_unlock(&printer->rwlock);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplSystemStateChanged(printer->system);
 }
 
 
@@ -836,7 +942,7 @@ papplPrinterSetOrganization(
 
   pthread_rwlock_unlock(&printer->rwlock);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplPrinterConfigChanged(printer);
 }
 
 
@@ -860,7 +966,7 @@ papplPrinterSetOrganizationalUnit(
 
   pthread_rwlock_unlock(&printer->rwlock);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplPrinterConfigChanged(printer);
 }
 
 
@@ -900,7 +1006,7 @@ papplPrinterSetPrintDefaults(
 
   pthread_rwlock_unlock(&printer->rwlock);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplPrinterConfigChanged(printer);
 }
 
 
@@ -938,7 +1044,7 @@ papplPrinterSetPrintGroup(
 
   pthread_rwlock_unlock(&printer->rwlock);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplPrinterConfigChanged(printer);
 }
 
 
@@ -966,7 +1072,7 @@ papplPrinterSetReadyMedia(
 
   pthread_rwlock_unlock(&printer->rwlock);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplPrinterConfigChanged(printer);
 }
 
 
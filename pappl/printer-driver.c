@@ -144,6 +144,8 @@ papplPrinterSetPrintDriverData(
     ippCopyAttributes(printer->driver_attrs, attrs, 0, NULL, NULL);
 
   pthread_rwlock_unlock(&printer->rwlock);
+
+  _papplPrinterConfigChanged(printer);
 }
 
 
@@ -254,8 +256,10 @@ make_attrs(pappl_system_t       *system,// I - System
   if (data->format && strcmp(data->format, "application/octet-stream"))
     svalues[num_values ++] = data->format;
 
-  for (filter = (_pappl_mime_filter_t *)cupsArrayFirst(system->filters); filter; filter = (_pappl_mime_filter_t *)cupsArrayNext(system->filters))
+  for (j = 0; j < system->num_filters; j ++)
   {
+    filter = system->filter_list[j];
+
     if ((data->format && !strcmp(filter->dst, data->format)) || !strcmp(filter->dst, "image/pwg-raster"))
     {
       for (i = 0; i < num_values; i ++)
@@ -19,6 +19,7 @@
 #  include "printer.h"
 #  include "log.h"
 #  include <grp.h>
+#  include <stdatomic.h>
 #  ifdef __APPLE__
 #    include <sys/param.h>
 #    include <sys/mount.h>
@@ -45,12 +46,20 @@
 // Types and structures...
 //
 
+// The atomic printer fields follow the same rules as the atomic job fields
+// (see job-private.h).
 struct _pappl_printer_s			// Printer data
 {
   pthread_rwlock_t	rwlock;			// Reader/writer lock
   pappl_system_t	*system;		// Containing system
   pappl_service_type_t	type;			// "printer-service-type" value
   int			printer_id;		// "printer-id" value
+  pappl_printer_t	*id_next,		// Next printer in printer-id index
+			*resource_next,		// Next printer in resource index
+			*uri_next,		// Next printer in device URI index
+			*removed_next;		// Next removed printer
+  unsigned		resource_hash,		// Hash of resource path
+			uri_hash;		// Hash of device URI
   char			*name,			// "printer-name" value
 			*dns_sd_name,		// "printer-dns-sd-name" value
 			*location,		// "printer-location" value
@@ -61,7 +70,7 @@ struct _pappl_printer_s			// Printer data
   char			*resource;		// Resource path of printer
   size_t		resourcelen;		// Length of resource path
   char			*uriname;		// Name for URLs
-  ipp_pstate_t		state;			// "printer-state" value
+  _Atomic ipp_pstate_t	state;			// "printer-state" value
   pappl_preason_t	state_reasons;		// "printer-state-reasons" values
   time_t		state_time;		// "printer-state-change-time" value
   bool			is_stopped,		// Are we stopping this printer?
@@ -74,9 +83,19 @@ struct _pappl_printer_s			// Printer data
   pappl_pdriver_data_t	driver_data;		// Driver data
   ipp_t			*driver_attrs;		// Driver attributes
   ipp_t			*attrs;			// Other (static) printer attributes
+  pthread_rwlock_t	attrs_rwlock;		// Reader/writer lock for cached attributes
+  ipp_t			*attrs_cache;		// Cached configuration attributes
+  size_t		attrs_generation;	// Configuration generation of cached attributes
+  atomic_size_t		config_generation;	// Configuration generation
   time_t		start_time;		// Startup time
   time_t		config_time;		// "printer-config-change-time" value
-  time_t		status_time;		// Last time status was updated
+  time_t		status_time,		// Last time status was updated
+			status_next;		// Next time status will be polled
+  size_t		status_polls,		// Number of status polls
+			status_failures,	// Number of failed status polls
+			status_usecs,		// Microseconds for last status poll
+			status_max_usecs;	// Maximum microseconds for a status poll
+  int			status_backoff;		// Number of consecutive failed status polls
   char			*print_group;		// PAM printing group, if any
   gid_t			print_gid;		// PAM printing group ID
   int			num_supply;		// Number of "printer-supply" values
@@ -84,12 +103,17 @@ struct _pappl_printer_s			// Printer data
 						// "printer-supply" values
   pappl_job_t		*processing_job;	// Currently printing job, if any
   int			max_active_jobs,	// Maximum number of active jobs to accept
-			max_completed_jobs;	// Maximum number of completed jobs to retain in history
+			max_completed_jobs,	// Maximum number of completed jobs to retain in history
+			max_prerip_jobs,	// Maximum number of pending jobs to pre-RIP
+			num_prerips;		// Number of queued or running pre-RIPs
+  size_t		max_prerip_size,	// Maximum size of pre-RIP spool files
+			prerip_size;		// Current size of pre-RIP spool files
   cups_array_t		*active_jobs,		// Array of active jobs
 			*all_jobs,		// Array of all jobs
 			*completed_jobs;	// Array of completed jobs
-  int			next_job_id,		// Next "job-id" value
-			impcompleted;		// "printer-impressions-completed" value
+  atomic_int		num_active_jobs;	// Number of active jobs
+  int			next_job_id;		// Next "job-id" value
+  atomic_int		impcompleted;		// "printer-impressions-completed" value
   cups_array_t		*links;			// Web navigation links
 #  ifdef HAVE_DNSSD
   _pappl_srv_t		dns_sd_ipp_ref,		// DNS-SD IPP service
@@ -120,6 +144,7 @@ extern void		*_papplPrinterRunRaw(pappl_printer_t *printer) _PAPPL_PRIVATE;
 extern void		_papplPrinterCheckJobs(pappl_printer_t *printer) _PAPPL_PRIVATE;
 extern void		_papplPrinterCleanJobs(pappl_printer_t *printer) _PAPPL_PRIVATE;
 extern int		_papplPrinterCompare(pappl_printer_t *a, pappl_printer_t *b) _PAPPL_PRIVATE;
+extern void		_papplPrinterConfigChanged(pappl_printer_t *printer) _PAPPL_PRIVATE;
 extern void		_papplPrinterInitPrintDriverData(pappl_pdriver_data_t *d) _PAPPL_PRIVATE;
 extern bool		_papplPrinterRegisterDNSSDNoLock(pappl_printer_t *printer) _PAPPL_PRIVATE;
 extern void		_papplPrinterUnregisterDNSSDNoLock(pappl_printer_t *printer) _PAPPL_PRIVATE;
@@ -88,7 +88,7 @@ _papplPrinterRunRaw(
   while (printer->listeners[0].fd >= 0)
   {
     // Don't accept connections if we can't accept a new job...
-    while (cupsArrayCount(printer->active_jobs) >= printer->max_active_jobs && printer->listeners[0].fd >= 0)
+    while (atomic_load_explicit(&printer->num_active_jobs, memory_order_relaxed) >= printer->max_active_jobs && printer->listeners[0].fd >= 0)
       sleep(1);
 
     if (printer->listeners[0].fd < 0)
@@ -182,7 +182,8 @@ _papplPrinterRunRaw(
 
 	  pthread_rwlock_wrlock(&printer->rwlock);
 
-	  cupsArrayRemove(printer->active_jobs, job);
+	  if (cupsArrayRemove(printer->active_jobs, job))
+	    printer->num_active_jobs --;
 	  cupsArrayAdd(printer->completed_jobs, job);
 
 	  if (!printer->system->clean_time)
@@ -19,11 +19,23 @@
 // Local functions...
 //
 
+static void	add_printer_index(pappl_system_t *system, pappl_printer_t *printer);
 static int	compare_active_jobs(pappl_job_t *a, pappl_job_t *b);
 static int	compare_all_jobs(pappl_job_t *a, pappl_job_t *b);
 static int	compare_completed_jobs(pappl_job_t *a, pappl_job_t *b);
 static int	compare_printers(pappl_printer_t *a, pappl_printer_t *b);
 static void	free_printer(pappl_printer_t *printer);
+static void	link_printer(pappl_system_t *system, pappl_printer_t *printer);
+static void	reclaim_printers(pappl_system_t *system);
+static void	remove_printer_index(pappl_system_t *system, pappl_printer_t *printer);
+static void	update_printers(pappl_system_t *system);
+
+
+//
+// Local globals...
+//
+
+static _pappl_plist_t	plist_empty;	// Empty printer list
 
 
 //
@@ -54,7 +66,8 @@ papplPrinterCancelAllJobs(
 
       _papplJobRemoveFile(job);
 
-      cupsArrayRemove(printer->active_jobs, job);
+      if (cupsArrayRemove(printer->active_jobs, job))
+        printer->num_active_jobs --;
       cupsArrayAdd(printer->completed_jobs, job);
     }
   }
@@ -66,6 +79,23 @@ papplPrinterCancelAllJobs(
 }
 
 
+//
+// '_papplPrinterConfigChanged()' - Mark the printer configuration as changed.
+//
+// This invalidates the printer's cached attributes and schedules a save of
+// the system configuration.  It must not be called with the printer locked.
+//
+
+void
+_papplPrinterConfigChanged(
+    pappl_printer_t *printer)		// I - Printer
+{
+  printer->config_generation ++;
+
+  _papplSystemConfigChanged(printer->system);
+}
+
+
 //
 // 'papplPrinterCreate()' - Create a new printer.
 //
@@ -216,6 +246,7 @@ papplPrinterCreate(
 
   // Initialize printer structure and attributes...
   pthread_rwlock_init(&printer->rwlock, NULL);
+  pthread_rwlock_init(&printer->attrs_rwlock, NULL);
 
   printer->system             = system;
   printer->type               = type;
@@ -238,6 +269,8 @@ papplPrinterCreate(
   printer->next_job_id        = 1;
   printer->max_active_jobs    = (system->options & PAPPL_SOPTIONS_MULTI_QUEUE) ? 0 : 1;
   printer->max_completed_jobs = 100;
+  printer->max_prerip_jobs    = 1;
+  printer->max_prerip_size    = 64 * 1024 * 1024;
 
   if (papplSystemGetDefaultPrintGroup(system, print_group, sizeof(print_group)))
     papplPrinterSetPrintGroup(printer, print_group);
@@ -475,7 +508,7 @@ papplPrinterCreate(
   ippAddStrings(printer->attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "which-jobs-supported", sizeof(which_jobs) / sizeof(which_jobs[0]), NULL, which_jobs);
 
   // Add the printer to the system...
-  pthread_rwlock_wrlock(&system->rwlock);
+  _papplSystemWRLock(system);
 
   if (printer_id)
     printer->printer_id = printer_id;
@@ -483,9 +516,11 @@ papplPrinterCreate(
     printer->printer_id = system->next_printer_id ++;
 
   if (!system->printers)
-    system->printers = cupsArrayNew3((cups_array_func_t)compare_printers, NULL, NULL, 0, NULL, (cups_afree_func_t)free_printer);
+    system->printers = cupsArrayNew3((cups_array_func_t)compare_printers, NULL, NULL, 0, NULL, NULL);
 
   cupsArrayAdd(system->printers, printer);
+  add_printer_index(system, printer);
+  update_printers(system);
 
   if (!system->default_printer_id)
     system->default_printer_id = printer->printer_id;
@@ -578,13 +613,84 @@ papplPrinterDelete(
   pappl_system_t *system = printer->system;
 					// System
 
+
+  // Pre-RIP threads may still be using the printer's jobs, so let the last one
+  // delete the printer...
+  pthread_rwlock_wrlock(&printer->rwlock);
+
+  printer->is_deleted = true;
+
+  if (printer->num_prerips > 0)
+  {
+    pthread_rwlock_unlock(&printer->rwlock);
+    return;
+  }
+
+  pthread_rwlock_unlock(&printer->rwlock);
+
   // Remove the printer from the system object...
-  pthread_rwlock_wrlock(&system->rwlock);
+  _papplSystemWRLock(system);
+
+  _papplPrinterUnregisterDNSSDNoLock(printer);
+
+  remove_printer_index(system, printer);
   cupsArrayRemove(system->printers, printer);
+
+  // Readers may still be using the printer, so free it once all printer lists
+  // that contain it have been released...
+  pthread_mutex_lock(&system->plist_mutex);
+  printer->removed_next    = system->removed_printers;
+  system->removed_printers = printer;
+  pthread_mutex_unlock(&system->plist_mutex);
+
+  update_printers(system);
+
   pthread_rwlock_unlock(&system->rwlock);
 }
 
 
+//
+// '_papplSystemDeletePrinters()' - Free all printers and printer lists.
+//
+
+void
+_papplSystemDeletePrinters(
+    pappl_system_t *system)		// I - System
+{
+  pappl_printer_t	*printer;	// Current printer
+  _pappl_plist_t	*plist;		// Current printer list
+
+
+  for (printer = (pappl_printer_t *)cupsArrayFirst(system->printers); printer; printer = (pappl_printer_t *)cupsArrayNext(system->printers))
+  {
+    _papplPrinterUnregisterDNSSDNoLock(printer);
+    free_printer(printer);
+  }
+
+  cupsArrayDelete(system->printers);
+  system->printers = NULL;
+
+  while ((printer = system->removed_printers) != NULL)
+  {
+    system->removed_printers = printer->removed_next;
+    free_printer(printer);
+  }
+
+  free(system->plist);
+  system->plist = NULL;
+
+  while ((plist = system->retired_plists) != NULL)
+  {
+    system->retired_plists = plist->next;
+    free(plist);
+  }
+
+  free(system->printer_ids);
+  free(system->printer_resources);
+  free(system->printer_uris);
+}
+
+
 //
 // 'papplSystemFindPrinter()' - Find a printer by resource, ID, or device URI...
 //
@@ -596,40 +702,202 @@ papplSystemFindPrinter(
     int            printer_id,		// I - Printer ID or `0`
     const char     *device_uri)		// I - Device URI or `NULL`
 {
-  pappl_printer_t	*printer;	// Matching printer
-
+  pappl_printer_t	*printer = NULL,// Matching printer
+			*match;		// Current printer in index
+  const char		*ptr;		// Pointer into resource
+  size_t		len;		// Length of resource prefix
+  unsigned		hash;		// Hash value
 
-  papplLog(system, PAPPL_LOGLEVEL_DEBUG, "papplSystemFindPrinter(system, resource=\"%s\", printer_id=%d, device_uri=\"%s\")", resource, printer_id, device_uri);
 
-  pthread_rwlock_rdlock(&system->rwlock);
+  _papplSystemRDLock(system);
 
   if (resource && (!strcmp(resource, "/") || !strcmp(resource, "/ipp/print") || (!strncmp(resource, "/ipp/print/", 11) && isdigit(resource[11] & 255))))
   {
     printer_id = system->default_printer_id;
     resource   = NULL;
-
-    papplLog(system, PAPPL_LOGLEVEL_DEBUG, "papplSystemFindPrinter: Looking for default printer_id=%d", printer_id);
   }
 
-  for (printer = (pappl_printer_t *)cupsArrayFirst(system->printers); printer; printer = (pappl_printer_t *)cupsArrayNext(system->printers))
+  if (system->printer_ids)
   {
-    papplLog(system, PAPPL_LOGLEVEL_DEBUG, "papplSystemFindPrinter: printer '%s' - resource=\"%s\", printer_id=%d, device_uri=\"%s\"", printer->name, printer->resource, printer->printer_id, printer->device_uri);
+    if (resource)
+    {
+      // Requests can be for the printer or for resources below it (jobs,
+      // etc.), so look up each leading path component of the resource...
+      for (ptr = resource, hash = _PAPPL_HASH_INIT; !printer; ptr ++)
+      {
+        if (ptr > resource && (!*ptr || *ptr == '/'))
+        {
+          len = (size_t)(ptr - resource);
+
+          for (match = system->printer_resources[hash & system->printer_mask]; match; match = match->resource_next)
+          {
+            if (match->resource_hash == hash && match->resourcelen == len && !strncmp(match->resource, resource, len))
+            {
+              printer = match;
+              break;
+            }
+          }
+        }
+
+        if (!*ptr)
+          break;
+
+        hash = _PAPPL_HASH_STEP(hash, *ptr);
+      }
+    }
 
-    if (resource && !strncmp(printer->resource, resource, printer->resourcelen) && (!resource[printer->resourcelen] || resource[printer->resourcelen] == '/'))
-      break;
-    else if (printer->printer_id == printer_id)
-      break;
-    else if (device_uri && !strcmp(printer->device_uri, device_uri))
-      break;
+    if (!printer && printer_id > 0)
+    {
+      for (match = system->printer_ids[(unsigned)printer_id & system->printer_mask]; match; match = match->id_next)
+      {
+        if (match->printer_id == printer_id)
+        {
+          printer = match;
+          break;
+        }
+      }
+    }
+
+    if (!printer && device_uri)
+    {
+      hash = _papplHashString(device_uri, NULL);
+
+      for (match = system->printer_uris[hash & system->printer_mask]; match; match = match->uri_next)
+      {
+        if (match->uri_hash == hash && !strcmp(match->device_uri, device_uri))
+        {
+          printer = match;
+          break;
+        }
+      }
+    }
   }
+
   pthread_rwlock_unlock(&system->rwlock);
 
-  papplLog(system, PAPPL_LOGLEVEL_DEBUG, "papplSystemFindPrinter: Returning %p(%s)", printer, printer ? printer->name : "none");
+  papplLog(system, PAPPL_LOGLEVEL_DEBUG, "papplSystemFindPrinter(resource=\"%s\", printer_id=%d, device_uri=\"%s\"): Returning %p(%s)", resource, printer_id, device_uri, printer, printer ? printer->name : "none");
 
   return (printer);
 }
 
 
+//
+// '_papplSystemGetPrinters()' - Get the current list of printers.
+//
+// The returned list can be used without holding the system lock and must be
+// released using `_papplSystemReleasePrinters()`.  The printers in the list
+// are not freed until every list containing them has been released.
+//
+
+_pappl_plist_t *			// O - Printer list
+_papplSystemGetPrinters(
+    pappl_system_t *system)		// I - System
+{
+  _pappl_plist_t	*plist;		// Printer list
+
+
+  pthread_mutex_lock(&system->plist_mutex);
+
+  if ((plist = system->plist) != NULL)
+    plist->refcount ++;
+  else
+    plist = &plist_empty;
+
+  pthread_mutex_unlock(&system->plist_mutex);
+
+  return (plist);
+}
+
+
+//
+// '_papplSystemReleasePrinters()' - Release a list of printers.
+//
+
+void
+_papplSystemReleasePrinters(
+    pappl_system_t *system,		// I - System
+    _pappl_plist_t *plist)		// I - Printer list
+{
+  if (!plist || plist == &plist_empty)
+    return;
+
+  pthread_mutex_lock(&system->plist_mutex);
+
+  plist->refcount --;
+
+  if (plist->refcount == 0 && plist != system->plist)
+    reclaim_printers(system);
+
+  pthread_mutex_unlock(&system->plist_mutex);
+}
+
+
+//
+// 'add_printer_index()' - Add a printer to the system's lookup indexes.
+//
+// The caller must hold the system write lock and have already added the
+// printer to the printers array.  The indexes are grown so that each hash
+// chain holds about one printer.
+//
+
+static void
+add_printer_index(
+    pappl_system_t  *system,		// I - System
+    pappl_printer_t *printer)		// I - Printer
+{
+  size_t		count = (size_t)cupsArrayCount(system->printers),
+					// Number of printers
+			size;		// Size of indexes
+  pappl_printer_t	**ids,		// New printer-id index
+			**resources,	// New resource index
+			**uris,		// New device URI index
+			*current;	// Current printer
+
+
+  printer->resource_hash = _papplHashString(printer->resource, NULL);
+  printer->uri_hash      = _papplHashString(printer->device_uri, NULL);
+
+  if (system->printer_ids && count <= system->printer_mask + 1)
+  {
+    link_printer(system, printer);
+    return;
+  }
+
+  // Grow the indexes and re-add all of the printers...
+  for (size = 64; size < count; size *= 2);
+
+  ids       = (pappl_printer_t **)calloc(size, sizeof(pappl_printer_t *));
+  resources = (pappl_printer_t **)calloc(size, sizeof(pappl_printer_t *));
+  uris      = (pappl_printer_t **)calloc(size, sizeof(pappl_printer_t *));
+
+  if (!ids || !resources || !uris)
+  {
+    // Keep using the current indexes with longer chains...
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to allocate printer indexes: %s", strerror(errno));
+
+    free(ids);
+    free(resources);
+    free(uris);
+
+    if (system->printer_ids)
+      link_printer(system, printer);
+    return;
+  }
+
+  free(system->printer_ids);
+  free(system->printer_resources);
+  free(system->printer_uris);
+
+  system->printer_mask      = size - 1;
+  system->printer_ids       = ids;
+  system->printer_resources = resources;
+  system->printer_uris      = uris;
+
+  for (current = (pappl_printer_t *)cupsArrayFirst(system->printers); current; current = (pappl_printer_t *)cupsArrayNext(system->printers))
+    link_printer(system, current);
+}
+
+
 //
 // 'compare_active_jobs()' - Compare two active jobs.
 //
@@ -685,9 +953,6 @@ compare_printers(pappl_printer_t *a,	// I - First printer
 static void
 free_printer(pappl_printer_t *printer)	// I - Printer
 {
-  // Remove DNS-SD registrations...
-  _papplPrinterUnregisterDNSSDNoLock(printer);
-
   // Free memory...
   free(printer->name);
   free(printer->dns_sd_name);
@@ -702,6 +967,9 @@ free_printer(pappl_printer_t *printer)	// I - Printer
 
   ippDelete(printer->driver_attrs);
   ippDelete(printer->attrs);
+  ippDelete(printer->attrs_cache);
+
+  pthread_rwlock_destroy(&printer->attrs_rwlock);
 
   cupsArrayDelete(printer->active_jobs);
   cupsArrayDelete(printer->completed_jobs);
@@ -712,3 +980,155 @@ free_printer(pappl_printer_t *printer)	// I - Printer
   free(printer);
 }
 
+
+//
+// 'link_printer()' - Link a printer into the system's lookup indexes.
+//
+
+static void
+link_printer(pappl_system_t  *system,	// I - System
+             pappl_printer_t *printer)	// I - Printer
+{
+  size_t	i;			// Index bucket
+
+
+  i = (unsigned)printer->printer_id & system->printer_mask;
+  printer->id_next       = system->printer_ids[i];
+  system->printer_ids[i] = printer;
+
+  i = printer->resource_hash & system->printer_mask;
+  printer->resource_next       = system->printer_resources[i];
+  system->printer_resources[i] = printer;
+
+  i = printer->uri_hash & system->printer_mask;
+  printer->uri_next       = system->printer_uris[i];
+  system->printer_uris[i] = printer;
+}
+
+
+//
+// 'reclaim_printers()' - Free retired printer lists and removed printers.
+//
+// The caller must hold the printer list mutex.  Removed printers are only
+// freed once no retired printer list is in use.
+//
+
+static void
+reclaim_printers(pappl_system_t *system)// I - System
+{
+  _pappl_plist_t	*plist,		// Current printer list
+			**pptr;		// Pointer into retired printer lists
+  pappl_printer_t	*printer;	// Current printer
+
+
+  for (pptr = &system->retired_plists; *pptr;)
+  {
+    if ((*pptr)->refcount == 0)
+    {
+      plist = *pptr;
+      *pptr = plist->next;
+      free(plist);
+    }
+    else
+      pptr = &(*pptr)->next;
+  }
+
+  if (system->retired_plists)
+    return;
+
+  while ((printer = system->removed_printers) != NULL)
+  {
+    system->removed_printers = printer->removed_next;
+    free_printer(printer);
+  }
+}
+
+
+//
+// 'remove_printer_index()' - Remove a printer from the system's lookup indexes.
+//
+// The caller must hold the system write lock.
+//
+
+static void
+remove_printer_index(
+    pappl_system_t  *system,		// I - System
+    pappl_printer_t *printer)		// I - Printer
+{
+  pappl_printer_t	**pptr;		// Pointer into index chain
+
+
+  if (!system->printer_ids)
+    return;
+
+  for (pptr = system->printer_ids + ((unsigned)printer->printer_id & system->printer_mask); *pptr; pptr = &(*pptr)->id_next)
+  {
+    if (*pptr == printer)
+    {
+      *pptr = printer->id_next;
+      break;
+    }
+  }
+
+  for (pptr = system->printer_resources + (printer->resource_hash & system->printer_mask); *pptr; pptr = &(*pptr)->resource_next)
+  {
+    if (*pptr == printer)
+    {
+      *pptr = printer->resource_next;
+      break;
+    }
+  }
+
+  for (pptr = system->printer_uris + (printer->uri_hash & system->printer_mask); *pptr; pptr = &(*pptr)->uri_next)
+  {
+    if (*pptr == printer)
+    {
+      *pptr = printer->uri_next;
+      break;
+    }
+  }
+}
+
+
+//
+// 'update_printers()' - Publish a new list of printers.
+//
+// The caller must hold the system write lock.
+//
+
+static void
+update_printers(pappl_system_t *system)	// I - System
+{
+  _pappl_plist_t	*plist,		// New printer list
+			*old;		// Old printer list
+  pappl_printer_t	*printer;	// Current printer
+  int			count = cupsArrayCount(system->printers);
+					// Number of printers
+
+
+  if ((plist = (_pappl_plist_t *)calloc(1, sizeof(_pappl_plist_t) + (size_t)count * sizeof(pappl_printer_t *))) == NULL)
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to allocate printer list: %s", strerror(errno));
+  else
+  {
+    for (printer = (pappl_printer_t *)cupsArrayFirst(system->printers); printer; printer = (pappl_printer_t *)cupsArrayNext(system->printers))
+      plist->printers[plist->num_printers ++] = printer;
+  }
+
+  // Swap in the new list (or none if we ran out of memory, so that removed
+  // printers are never visible) and retire the old one...
+  pthread_mutex_lock(&system->plist_mutex);
+
+  old           = system->plist;
+  system->plist = plist;
+  system->printer_snapshots ++;
+
+  if (old)
+  {
+    old->next              = system->retired_plists;
+    system->retired_plists = old;
+  }
+
+  reclaim_printers(system);
+
+  pthread_mutex_unlock(&system->plist_mutex);
+}
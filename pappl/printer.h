@@ -348,6 +348,16 @@ typedef struct pappl_psupply_s		// Supply data
   pappl_supply_type_t	type;			// Type
 } pappl_supply_t;
 
+typedef struct pappl_smetrics_s		// Printer status polling metrics
+{
+  time_t		status_time,		// Time of last status update
+			next_time;		// Time of next status poll
+  size_t		num_polls,		// Number of status polls
+			num_failures,		// Number of failed status polls
+			last_usecs,		// Microseconds taken by last status poll
+			max_usecs;		// Maximum microseconds taken by a status poll
+} pappl_smetrics_t;
+
 struct pappl_pdriver_data_s		// Print driver data
 {
   pappl_identfunc_t	identify;		// Identify-Printer function
@@ -457,6 +467,8 @@ extern int		papplPrinterGetImpressionsCompleted(pappl_printer_t *printer) _PAPPL
 extern char		*papplPrinterGetLocation(pappl_printer_t *printer, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern int		papplPrinterGetMaxActiveJobs(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern int		papplPrinterGetMaxCompletedJobs(pappl_printer_t *printer) _PAPPL_PUBLIC;
+extern int		papplPrinterGetMaxPreRIPJobs(pappl_printer_t *printer) _PAPPL_PUBLIC;
+extern size_t		papplPrinterGetMaxPreRIPSize(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern const char	*papplPrinterGetName(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern int		papplPrinterGetNextJobID(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern int		papplPrinterGetNumberOfActiveJobs(pappl_printer_t *printer) _PAPPL_PUBLIC;
@@ -468,6 +480,7 @@ extern pappl_pdriver_data_t *papplPrinterGetPrintDriverData(pappl_printer_t *pri
 extern char		*papplPrinterGetPrintGroup(pappl_printer_t *printer, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern pappl_preason_t	papplPrinterGetReasons(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern ipp_pstate_t	papplPrinterGetState(pappl_printer_t *printer) _PAPPL_PUBLIC;
+extern pappl_smetrics_t	*papplPrinterGetStatusMetrics(pappl_printer_t *printer, pappl_smetrics_t *metrics) _PAPPL_PUBLIC;
 extern int		papplPrinterGetSupplies(pappl_printer_t *printer, int max_supplies, pappl_supply_t *supplies) _PAPPL_PUBLIC;
 extern pappl_system_t	*papplPrinterGetSystem(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern pappl_service_type_t papplPrinterGetType(pappl_printer_t *printer) _PAPPL_PUBLIC;
@@ -488,6 +501,8 @@ extern void		papplPrinterSetImpressionsCompleted(pappl_printer_t *printer, int a
 extern void		papplPrinterSetLocation(pappl_printer_t *printer, const char *value) _PAPPL_PUBLIC;
 extern void		papplPrinterSetMaxActiveJobs(pappl_printer_t *printer, int max_active_jobs) _PAPPL_PUBLIC;
 extern void		papplPrinterSetMaxCompletedJobs(pappl_printer_t *printer, int max_completed_jobs) _PAPPL_PUBLIC;
+extern void		papplPrinterSetMaxPreRIPJobs(pappl_printer_t *printer, int max_prerip_jobs) _PAPPL_PUBLIC;
+extern void		papplPrinterSetMaxPreRIPSize(pappl_printer_t *printer, size_t max_prerip_size) _PAPPL_PUBLIC;
 extern void		papplPrinterSetNextJobID(pappl_printer_t *printer, int next_job_id) _PAPPL_PUBLIC;
 extern void		papplPrinterSetOrganization(pappl_printer_t *printer, const char *value) _PAPPL_PUBLIC;
 extern void		papplPrinterSetOrganizationalUnit(pappl_printer_t *printer, const char *value) _PAPPL_PUBLIC;
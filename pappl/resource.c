@@ -24,6 +24,8 @@ static void		add_resource(pappl_system_t *system, _pappl_resource_t *r);
 static int		compare_resources(_pappl_resource_t *a, _pappl_resource_t *b);
 static _pappl_resource_t *copy_resource(_pappl_resource_t *r);
 static void		free_resource(_pappl_resource_t *r);
+static void		reclaim_resources(pappl_system_t *system);
+static void		update_router(pappl_system_t *system);
 
 
 //
@@ -287,40 +289,154 @@ papplSystemAddStringsFile(
 }
 
 
+//
+// '_papplSystemDeleteResources()' - Free all resources and resource routers.
+//
+
+void
+_papplSystemDeleteResources(
+    pappl_system_t *system)		// I - System object
+{
+  _pappl_resource_t	*r;		// Current resource
+  _pappl_router_t	*router;	// Current router
+
+
+  for (r = (_pappl_resource_t *)cupsArrayFirst(system->resources); r; r = (_pappl_resource_t *)cupsArrayNext(system->resources))
+    free_resource(r);
+
+  cupsArrayDelete(system->resources);
+  system->resources = NULL;
+
+  while ((r = system->removed_resources) != NULL)
+  {
+    system->removed_resources = r->removed_next;
+    free_resource(r);
+  }
+
+  free(atomic_load_explicit(&system->router, memory_order_relaxed));
+  atomic_store_explicit(&system->router, NULL, memory_order_relaxed);
+
+  while ((router = system->retired_routers) != NULL)
+  {
+    system->retired_routers = router->next;
+    free(router);
+  }
+}
+
+
 //
 // '_papplSystemFindResource()' - Find a resource at a path.
 //
+// The lookup uses the current router without taking any locks.  If there is
+// no resource at the exact path, the directory resource at "path/" is returned
+// instead.  The returned resource must be released using the
+// @code _papplSystemReleaseResource@ function.
+//
+// The router reader count keeps retired routers and removed resources from
+// being freed while the lookup is using them.
+//
 
 _pappl_resource_t *			// O - Resource object
 _papplSystemFindResource(
     pappl_system_t *system,		// I - System object
     const char     *path)		// I - Resource path
 {
-  _pappl_resource_t	key,		// Search key
-			*match;		// Matching resource, if any
-  char			altpath[1024];	// Alternate path
+  _pappl_router_t	*router;	// Current router
+  _pappl_route_t	*route;		// Current route
+  unsigned		hash,		// Hash of path
+			althash;	// Hash of "path/"
+  size_t		i,		// Current table index
+			pathlen;	// Length of path
+  const char		*rpath;		// Resource path
+  _pappl_resource_t	*match = NULL;	// Matching resource
 
 
-  if (!system || !system->resources || !path)
+  if (!system || !path)
     return (NULL);
 
-  key.path = (char *)path;
+  hash    = _papplHashString(path, &pathlen);
+  althash = _PAPPL_HASH_STEP(hash, '/');
 
-  pthread_rwlock_rdlock(&system->rwlock);
+  // Register as a reader before loading the router - the fence pairs with the
+  // one in reclaim_resources() so that either the reader count is seen there
+  // or the newest router is seen here...
+  atomic_fetch_add_explicit(&system->router_readers, 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
 
-  if ((match = (_pappl_resource_t *)cupsArrayFind(system->resources, &key)) == NULL)
+  if ((router = atomic_load_explicit(&system->router, memory_order_acquire)) != NULL)
   {
-    snprintf(altpath, sizeof(altpath), "%s/", path);
-    key.path = altpath;
-    match = (_pappl_resource_t *)cupsArrayFind(system->resources, &key);
+    // Look for an exact match...
+    for (i = hash & router->mask, route = router->routes + i; route->resource; i = (i + 1) & router->mask, route = router->routes + i)
+    {
+      if (route->hash == hash && !strcmp(route->resource->path, path))
+      {
+        match = route->resource;
+        break;
+      }
+    }
+
+    // Then look for a directory match using the hash extended with a trailing
+    // slash...
+    for (i = althash & router->mask, route = router->routes + i; !match && route->resource; i = (i + 1) & router->mask, route = router->routes + i)
+    {
+      rpath = route->resource->path;
+
+      if (route->hash == althash && !strncmp(rpath, path, pathlen) && rpath[pathlen] == '/' && !rpath[pathlen + 1])
+        match = route->resource;
+    }
+
+    if (match)
+    {
+      // Reference the resource, then make sure it wasn't removed after this
+      // router was loaded...
+      atomic_fetch_add_explicit(&match->refcount, 1, memory_order_relaxed);
+
+      if (atomic_load_explicit(&match->removed, memory_order_acquire))
+      {
+        atomic_fetch_sub_explicit(&match->refcount, 1, memory_order_release);
+        match = NULL;
+      }
+    }
   }
 
-  pthread_rwlock_unlock(&system->rwlock);
+  atomic_fetch_sub_explicit(&system->router_readers, 1, memory_order_release);
 
   return (match);
 }
 
 
+//
+// '_papplSystemReleaseResource()' - Release a resource found with
+//                                   @code _papplSystemFindResource@.
+//
+// Removed resources are freed once the last client releases them and no
+// lookup is using a router that contains them.
+//
+
+void
+_papplSystemReleaseResource(
+    pappl_system_t    *system,		// I - System object
+    _pappl_resource_t *r)		// I - Resource
+{
+  bool	removed;			// Has the resource been removed?
+
+
+  if (!system || !r)
+    return;
+
+  // Check for removal first since the resource can be freed as soon as the
+  // reference is dropped...
+  removed = atomic_load_explicit(&r->removed, memory_order_acquire);
+
+  if (atomic_fetch_sub_explicit(&r->refcount, 1, memory_order_release) == 1 && removed)
+  {
+    pthread_mutex_lock(&system->router_mutex);
+    reclaim_resources(system);
+    pthread_mutex_unlock(&system->router_mutex);
+  }
+}
+
+
 //
 // 'papplSystemRemoveResource()' - Remove a resource at the specified path.
 //
@@ -339,12 +455,23 @@ papplSystemRemoveResource(
 
   key.path = (char *)path;
 
-  pthread_rwlock_wrlock(&system->rwlock);
+  _papplSystemWRLock(system);
 
   if ((match = (_pappl_resource_t *)cupsArrayFind(system->resources, &key)) != NULL)
   {
     papplLog(system, PAPPL_LOGLEVEL_DEBUG, "Removing resource for '%s'.", path);
     cupsArrayRemove(system->resources, match);
+
+    // Clients may still be using the resource, so mark it removed and let
+    // reclaim_resources() free it once they are done...
+    atomic_store_explicit(&match->removed, true, memory_order_release);
+
+    pthread_mutex_lock(&system->router_mutex);
+    match->removed_next       = system->removed_resources;
+    system->removed_resources = match;
+    pthread_mutex_unlock(&system->router_mutex);
+
+    update_router(system);
   }
 
   pthread_rwlock_unlock(&system->rwlock);
@@ -359,16 +486,18 @@ static void
 add_resource(pappl_system_t    *system,	// I - System object
              _pappl_resource_t *r)	// I - Resource
 {
-  pthread_rwlock_wrlock(&system->rwlock);
+  _papplSystemWRLock(system);
 
   if (!cupsArrayFind(system->resources, r))
   {
     papplLog(system, PAPPL_LOGLEVEL_DEBUG, "Adding resource for '%s'.", r->path);
 
     if (!system->resources)
-      system->resources = cupsArrayNew3((cups_array_func_t)compare_resources, NULL, NULL, 0, (cups_acopy_func_t)copy_resource, (cups_afree_func_t)free_resource);
+      system->resources = cupsArrayNew3((cups_array_func_t)compare_resources, NULL, NULL, 0, (cups_acopy_func_t)copy_resource, NULL);
 
     cupsArrayAdd(system->resources, r);
+
+    update_router(system);
   }
 
   pthread_rwlock_unlock(&system->rwlock);
@@ -407,8 +536,18 @@ copy_resource(_pappl_resource_t *r)	// I - Resource to copy
     newr->cb            = r->cb;
     newr->cbdata        = r->cbdata;
 
+    newr->fd            = -1;
+
     if (r->filename)
+    {
       newr->filename = strdup(r->filename);
+
+      // Keep the file open so it can be sent without opening it for every
+      // request...
+      if (newr->length > 0)
+        newr->fd = open(newr->filename, O_RDONLY | O_CLOEXEC);
+    }
+
     if (r->language)
       newr->language = strdup(r->language);
   }
@@ -429,5 +568,111 @@ free_resource(_pappl_resource_t *r)	// I - Resource
   free(r->filename);
   free(r->language);
 
+  if (r->fd >= 0)
+    close(r->fd);
+
   free(r);
 }
+
+
+//
+// 'reclaim_resources()' - Free retired routers and removed resources.
+//
+// The caller must hold the router mutex.  Nothing is freed while a lookup is
+// using a router, and removed resources are only freed once every client
+// reference has been released.  Anything left over is freed by a later call.
+//
+
+static void
+reclaim_resources(
+    pappl_system_t *system)		// I - System object
+{
+  _pappl_router_t	*router;	// Current router
+  _pappl_resource_t	*r,		// Current resource
+			**rptr;		// Pointer into removed resources
+
+
+  // Pairs with the fence in _papplSystemFindResource() - a lookup that starts
+  // after this sees the current router, which has no retired resources...
+  atomic_thread_fence(memory_order_seq_cst);
+
+  if (atomic_load_explicit(&system->router_readers, memory_order_acquire) > 0)
+    return;
+
+  while ((router = system->retired_routers) != NULL)
+  {
+    system->retired_routers = router->next;
+    free(router);
+  }
+
+  for (rptr = &system->removed_resources; *rptr;)
+  {
+    if (atomic_load_explicit(&(*rptr)->refcount, memory_order_acquire) == 0)
+    {
+      r     = *rptr;
+      *rptr = r->removed_next;
+      free_resource(r);
+    }
+    else
+      rptr = &(*rptr)->removed_next;
+  }
+}
+
+
+//
+// 'update_router()' - Build and publish a new resource router.
+//
+// The caller must hold the system write lock.  Lookups don't lock the router,
+// so the old router is retired and freed by reclaim_resources() once no lookup
+// can be using it.
+//
+
+static void
+update_router(pappl_system_t *system)	// I - System object
+{
+  _pappl_router_t	*router,	// New router
+			*old;		// Old router
+  _pappl_resource_t	*r;		// Current resource
+  size_t		size,		// Size of routes table
+			i;		// Current table index
+
+
+  // Size the table so it is never more than half full...
+  for (size = 16; size < 2 * (size_t)cupsArrayCount(system->resources); size *= 2);
+
+  if ((router = (_pappl_router_t *)calloc(1, sizeof(_pappl_router_t) + size * sizeof(_pappl_route_t))) == NULL)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to allocate resource router: %s", strerror(errno));
+  }
+  else
+  {
+    router->mask = size - 1;
+
+    for (r = (_pappl_resource_t *)cupsArrayFirst(system->resources); r; r = (_pappl_resource_t *)cupsArrayNext(system->resources))
+    {
+      unsigned hash = _papplHashString(r->path, NULL);
+					// Hash of path
+
+      for (i = hash & router->mask; router->routes[i].resource; i = (i + 1) & router->mask);
+
+      router->routes[i].hash     = hash;
+      router->routes[i].resource = r;
+    }
+  }
+
+  // Publish the new router (or none if we ran out of memory, so that removed
+  // resources are never found) and retire the old one...
+  old = atomic_exchange_explicit(&system->router, router, memory_order_release);
+
+  pthread_mutex_lock(&system->router_mutex);
+
+  if (old)
+  {
+    old->next               = system->retired_routers;
+    system->retired_routers = old;
+  }
+
+  reclaim_resources(system);
+
+  pthread_mutex_unlock(&system->router_mutex);
+}
@@ -29,6 +29,7 @@
 //
 
 static bool		add_listeners(pappl_system_t *system, const char *name, int port, int family);
+static int		compare_filter_ptrs(_pappl_mime_filter_t **a, _pappl_mime_filter_t **b);
 static int		compare_filters(_pappl_mime_filter_t *a, _pappl_mime_filter_t *b);
 static _pappl_mime_filter_t *copy_filter(_pappl_mime_filter_t *f);
 
@@ -123,8 +124,22 @@ papplSystemAddMIMEFilter(
 
   if (!cupsArrayFind(system->filters, &key))
   {
+    _pappl_mime_filter_t	**filter_list,	// New filter list
+				*filter;	// Current filter
+
     papplLog(system, PAPPL_LOGLEVEL_DEBUG, "Adding '%s' to '%s' filter.", srctype, dsttype);
     cupsArrayAdd(system->filters, &key);
+
+    // Update the sorted filter list that is used for lookups while the system
+    // is running...
+    if ((filter_list = (_pappl_mime_filter_t **)realloc(system->filter_list, (size_t)cupsArrayCount(system->filters) * sizeof(_pappl_mime_filter_t *))) != NULL)
+    {
+      system->filter_list = filter_list;
+      system->num_filters = 0;
+
+      for (filter = (_pappl_mime_filter_t *)cupsArrayFirst(system->filters); filter; filter = (_pappl_mime_filter_t *)cupsArrayNext(system->filters))
+        system->filter_list[system->num_filters ++] = filter;
+    }
   }
 }
 
@@ -138,7 +153,7 @@ _papplSystemExportVersions(
     pappl_system_t *system,		// I - System
     ipp_t          *ipp,		// I - IPP message
     ipp_tag_t      group_tag,		// I - Group (`IPP_TAG_PRINTER` or `IPP_TAG_SYSTEM`)
-    cups_array_t   *ra)			// I - Requested attributes or `NULL` for all
+    _pappl_ra_t    *ra)			// I - Requested attributes or `NULL` for all
 {
   int		i;			// Looping var
   ipp_attribute_t *attr;		// Attribute
@@ -154,7 +169,7 @@ _papplSystemExportVersions(
 
   // "xxx-firmware-name"
   snprintf(name, sizeof(name), "%s-firmware-name", name_prefix);
-  if (!ra || cupsArrayFind(ra, name))
+  if (_papplRAFind(ra, name))
   {
     for (i = 0; i < system->num_versions; i ++)
       values[i] = system->versions[i].name;
@@ -176,7 +191,7 @@ _papplSystemExportVersions(
 
   // "xxx-firmware-patches"
   snprintf(name, sizeof(name), "%s-firmware-patches", name_prefix);
-  if (!ra || cupsArrayFind(ra, name))
+  if (_papplRAFind(ra, name))
   {
     for (i = 0; i < system->num_versions; i ++)
       values[i] = system->versions[i].patches;
@@ -198,7 +213,7 @@ _papplSystemExportVersions(
 
   // "xxx-firmware-string-version"
   snprintf(name, sizeof(name), "%s-firmware-string-version", name_prefix);
-  if (!ra || cupsArrayFind(ra, name))
+  if (_papplRAFind(ra, name))
   {
     for (i = 0; i < system->num_versions; i ++)
       values[i] = system->versions[i].sversion;
@@ -222,7 +237,7 @@ _papplSystemExportVersions(
 
   // "xxx-firmware-version"
   snprintf(name, sizeof(name), "%s-firmware-version", name_prefix);
-  if (!ra || cupsArrayFind(ra, name))
+  if (_papplRAFind(ra, name))
   {
     for (i = 0, attr = NULL; i < system->num_versions; i ++)
     {
@@ -271,22 +286,21 @@ _papplSystemFindMIMEFilter(
     const char     *dsttype)		// I - Destination MIME media type string
 {
   _pappl_mime_filter_t	key,		// Search key
-			*match;		// Matching filter
+			*pkey = &key,	// Pointer to search key
+			**match;	// Matching filter
 
 
-  if (!system || !srctype || !dsttype)
+  if (!system || !srctype || !dsttype || !system->filter_list)
     return (NULL);
 
-  pthread_rwlock_rdlock(&system->rwlock);
-
+  // Filters cannot be added while the system is running, so the sorted filter
+  // list can be searched without locking...
   key.src = srctype;
   key.dst = dsttype;
 
-  match = (_pappl_mime_filter_t *)cupsArrayFind(system->filters, &key);
-
-  pthread_rwlock_unlock(&system->rwlock);
+  match = (_pappl_mime_filter_t **)bsearch(&pkey, system->filter_list, (size_t)system->num_filters, sizeof(_pappl_mime_filter_t *), (int (*)(const void *, const void *))compare_filter_ptrs);
 
-  return (match);
+  return (match ? *match : NULL);
 }
 
 
@@ -305,7 +319,7 @@ papplSystemGetAdminGroup(
 
   if (system && buffer && bufsize > 0)
   {
-    pthread_rwlock_rdlock(&system->rwlock);
+    _papplSystemRDLock(system);
 
     if (system->admin_group)
     {
@@ -336,6 +350,28 @@ papplSystemGetAuthService(
 }
 
 
+//
+// 'papplSystemGetCompressionThreshold()' - Get the minimum size of compressed responses.
+//
+
+size_t					// O - Minimum response size in bytes or `0` if compression is disabled
+papplSystemGetCompressionThreshold(
+    pappl_system_t *system)		// I - System
+{
+  size_t	ret = 0;		// Return value
+
+
+  if (system)
+  {
+    _papplSystemRDLock(system);
+    ret = system->compression;
+    pthread_rwlock_unlock(&system->rwlock);
+  }
+
+  return (ret);
+}
+
+
 //
 // 'papplSystemGetContact()' - Get the "system-contact" value.
 //
@@ -353,7 +389,7 @@ papplSystemGetContact(
     return (contact);
   }
 
-  pthread_rwlock_rdlock(&system->rwlock);
+  _papplSystemRDLock(system);
 
   *contact = system->contact;
 
@@ -390,7 +426,7 @@ papplSystemGetDefaultPrintGroup(
 
   if (system && buffer && bufsize > 0)
   {
-    pthread_rwlock_rdlock(&system->rwlock);
+    _papplSystemRDLock(system);
 
     if (system->default_print_group)
     {
@@ -424,7 +460,7 @@ papplSystemGetDNSSDName(
 
   if (system && buffer && bufsize > 0)
   {
-    pthread_rwlock_rdlock(&system->rwlock);
+    _papplSystemRDLock(system);
 
     if (system->dns_sd_name)
     {
@@ -470,7 +506,7 @@ papplSystemGetGeoLocation(
 
   if (system && buffer && bufsize > 0)
   {
-    pthread_rwlock_rdlock(&system->rwlock);
+    _papplSystemRDLock(system);
 
     if (system->geo_location)
     {
@@ -504,7 +540,7 @@ papplSystemGetHostname(
 
   if (system && buffer && bufsize > 0)
   {
-    pthread_rwlock_rdlock(&system->rwlock);
+    _papplSystemRDLock(system);
 
     if (system->hostname)
     {
@@ -538,7 +574,7 @@ papplSystemGetLocation(
 
   if (system && buffer && bufsize > 0)
   {
-    pthread_rwlock_rdlock(&system->rwlock);
+    _papplSystemRDLock(system);
 
     if (system->location)
     {
@@ -557,6 +593,35 @@ papplSystemGetLocation(
 }
 
 
+//
+// 'papplSystemGetLockMetrics()' - Get the system lock metrics.
+//
+// The metrics report how often the system lock was taken and how often a
+// reader or writer had to wait for it, along with the number of printer lists
+// that have been published.
+//
+
+pappl_lmetrics_t *			// O - Metrics data or `NULL` on error
+papplSystemGetLockMetrics(
+    pappl_system_t   *system,		// I - System
+    pappl_lmetrics_t *metrics)		// I - Buffer for metrics data
+{
+  if (!system || !metrics)
+    return (NULL);
+
+  metrics->read_locks  = atomic_load_explicit(&system->read_locks, memory_order_relaxed);
+  metrics->read_waits  = atomic_load_explicit(&system->read_waits, memory_order_relaxed);
+  metrics->write_locks = atomic_load_explicit(&system->write_locks, memory_order_relaxed);
+  metrics->write_waits = atomic_load_explicit(&system->write_waits, memory_order_relaxed);
+
+  pthread_mutex_lock(&system->plist_mutex);
+  metrics->printer_snapshots = system->printer_snapshots;
+  pthread_mutex_unlock(&system->plist_mutex);
+
+  return (metrics);
+}
+
+
 //
 // 'papplSystemGetLogLevel()' - Get the system log level.
 //
@@ -602,7 +667,7 @@ papplSystemGetName(
 
   if (system && buffer && bufsize > 0)
   {
-    pthread_rwlock_rdlock(&system->rwlock);
+    _papplSystemRDLock(system);
 
     if (system->name)
     {
@@ -660,7 +725,7 @@ papplSystemGetOrganization(
 
   if (system && buffer && bufsize > 0)
   {
-    pthread_rwlock_rdlock(&system->rwlock);
+    _papplSystemRDLock(system);
 
     if (system->organization)
     {
@@ -694,7 +759,7 @@ papplSystemGetOrganizationalUnit(
 
   if (system && buffer && bufsize > 0)
   {
-    pthread_rwlock_rdlock(&system->rwlock);
+    _papplSystemRDLock(system);
 
     if (system->org_unit)
     {
@@ -728,7 +793,7 @@ papplSystemGetPassword(
 {
   if (system && buffer && bufsize > 0)
   {
-    pthread_rwlock_rdlock(&system->rwlock);
+    _papplSystemRDLock(system);
 
     strlcpy(buffer, system->password_hash, bufsize);
 
@@ -771,7 +836,7 @@ papplSystemGetSessionKey(
 
   if (system && buffer && bufsize > 0)
   {
-    pthread_rwlock_wrlock(&system->rwlock);
+    _papplSystemWRLock(system);
 
     if ((curtime - system->session_time) > 86400)
     {
@@ -830,7 +895,7 @@ papplSystemGetFirmware(
 
   if (system && versions && system->num_versions > 0)
   {
-    pthread_rwlock_rdlock(&system->rwlock);
+    _papplSystemRDLock(system);
 
     if (max_versions > system->num_versions)
       memcpy(versions, system->versions, (size_t)system->num_versions * sizeof(pappl_version_t));
@@ -911,6 +976,9 @@ papplSystemIsRunning(
 //
 // 'papplSystemIteratePrinters()' - Iterate all of the printers.
 //
+// The callback is called for each printer in the current list of printers
+// without locking the system, so it can safely add or delete printers.
+//
 
 void
 papplSystemIteratePrinters(
@@ -918,16 +986,19 @@ papplSystemIteratePrinters(
     pappl_printer_cb_t cb,		// I - Callback function
     void               *data)		// I - Callback data
 {
-  pappl_printer_t	*printer;	// Current printer
+  _pappl_plist_t	*plist;		// Printer list
+  int			i;		// Looping var
 
 
   if (!system || !cb)
     return;
 
-  pthread_rwlock_rdlock(&system->rwlock);
-  for (printer = (pappl_printer_t *)cupsArrayFirst(system->printers); printer; printer = (pappl_printer_t *)cupsArrayNext(system->printers))
-    (cb)(printer, data);
-  pthread_rwlock_unlock(&system->rwlock);
+  plist = _papplSystemGetPrinters(system);
+
+  for (i = 0; i < plist->num_printers; i ++)
+    (cb)(plist->printers[i], data);
+
+  _papplSystemReleasePrinters(system, plist);
 }
 
 
@@ -942,7 +1013,7 @@ papplSystemSetAdminGroup(
 {
   if (system)
   {
-    pthread_rwlock_wrlock(&system->rwlock);
+    _papplSystemWRLock(system);
 
     free(system->admin_group);
     system->admin_group = value ? strdup(value) : NULL;
@@ -961,6 +1032,9 @@ papplSystemSetAdminGroup(
     else
       system->admin_gid = (gid_t)-1;
 
+    // Cached group membership may no longer be valid...
+    _papplSystemClearAuthCache(system);
+
     system->config_time = time(NULL);
     system->config_changes ++;
 
@@ -969,6 +1043,33 @@ papplSystemSetAdminGroup(
 }
 
 
+//
+// 'papplSystemSetCompressionThreshold()' - Set the minimum size of compressed responses.
+//
+// Web and IPP responses of at least the specified number of bytes are sent
+// with gzip or deflate Content-Encoding when the client supports it, as are
+// dynamic (streamed) web pages.  Images, PDF files, and other formats that are
+// already compressed are always sent as-is.  Smaller thresholds reduce the
+// amount of data sent at the cost of additional CPU time.  Set the threshold
+// to `0` to disable compression.
+//
+// The default compression threshold is `1024` bytes.
+//
+
+void
+papplSystemSetCompressionThreshold(
+    pappl_system_t *system,		// I - System
+    size_t         threshold)		// I - Minimum response size in bytes or `0` to disable compression
+{
+  if (system)
+  {
+    _papplSystemWRLock(system);
+    system->compression = threshold;
+    pthread_rwlock_unlock(&system->rwlock);
+  }
+}
+
+
 //
 // 'papplSystemSetContact()' - Set the "system-contact" value.
 //
@@ -981,7 +1082,7 @@ papplSystemSetContact(
   if (!system || !contact)
     return;
 
-  pthread_rwlock_wrlock(&system->rwlock);
+  _papplSystemWRLock(system);
 
   system->contact = *contact;
 
@@ -1003,7 +1104,7 @@ papplSystemSetDefaultPrinterID(
 {
   if (system)
   {
-    pthread_rwlock_wrlock(&system->rwlock);
+    _papplSystemWRLock(system);
 
     system->default_printer_id = default_printer_id;
 
@@ -1026,7 +1127,7 @@ papplSystemSetDefaultPrintGroup(
 {
   if (system)
   {
-    pthread_rwlock_wrlock(&system->rwlock);
+    _papplSystemWRLock(system);
 
     free(system->default_print_group);
     system->default_print_group = value ? strdup(value) : NULL;
@@ -1050,7 +1151,7 @@ papplSystemSetDNSSDName(
 {
   if (system)
   {
-    pthread_rwlock_wrlock(&system->rwlock);
+    _papplSystemWRLock(system);
 
     free(system->dns_sd_name);
     system->dns_sd_name      = value ? strdup(value) : NULL;
@@ -1082,7 +1183,7 @@ papplSystemSetFooterHTML(
 {
   if (system && html && !system->is_running)
   {
-    pthread_rwlock_wrlock(&system->rwlock);
+    _papplSystemWRLock(system);
 
     free(system->footer_html);
     system->footer_html = strdup(html);
@@ -1103,7 +1204,7 @@ papplSystemSetGeoLocation(
 {
   if (system)
   {
-    pthread_rwlock_wrlock(&system->rwlock);
+    _papplSystemWRLock(system);
 
     free(system->geo_location);
     system->geo_location = value ? strdup(value) : NULL;
@@ -1128,7 +1229,7 @@ papplSystemSetHostname(
 {
   if (system)
   {
-    pthread_rwlock_wrlock(&system->rwlock);
+    _papplSystemWRLock(system);
 
     free(system->hostname);
 
@@ -1201,7 +1302,7 @@ papplSystemSetLocation(
 {
   if (system)
   {
-    pthread_rwlock_wrlock(&system->rwlock);
+    _papplSystemWRLock(system);
 
     free(system->location);
     system->location    = value ? strdup(value) : NULL;
@@ -1225,7 +1326,7 @@ papplSystemSetLogLevel(
 {
   if (system)
   {
-    pthread_rwlock_wrlock(&system->rwlock);
+    _papplSystemWRLock(system);
 
     system->loglevel = loglevel;
 
@@ -1254,7 +1355,7 @@ papplSystemSetMaxLogSize(
 {
   if (system)
   {
-    pthread_rwlock_wrlock(&system->rwlock);
+    _papplSystemWRLock(system);
 
     system->logmaxsize = maxsize;
 
@@ -1288,7 +1389,7 @@ papplSystemSetMIMECallback(
 {
   if (system)
   {
-    pthread_rwlock_wrlock(&system->rwlock);
+    _papplSystemWRLock(system);
 
     system->config_time = time(NULL);
     system->mime_cb     = cb;
@@ -1312,7 +1413,7 @@ papplSystemSetNextPrinterID(
 {
   if (system && !system->is_running)
   {
-    pthread_rwlock_wrlock(&system->rwlock);
+    _papplSystemWRLock(system);
 
     system->next_printer_id = next_printer_id;
 
@@ -1338,7 +1439,7 @@ papplSystemSetOperationCallback(
 {
   if (system && !system->is_running)
   {
-    pthread_rwlock_wrlock(&system->rwlock);
+    _papplSystemWRLock(system);
     system->op_cb     = cb;
     system->op_cbdata = data;
     pthread_rwlock_unlock(&system->rwlock);
@@ -1357,7 +1458,7 @@ papplSystemSetOrganization(
 {
   if (system)
   {
-    pthread_rwlock_wrlock(&system->rwlock);
+    _papplSystemWRLock(system);
 
     free(system->organization);
     system->organization = value ? strdup(value) : NULL;
@@ -1381,7 +1482,7 @@ papplSystemSetOrganizationalUnit(
 {
   if (system)
   {
-    pthread_rwlock_wrlock(&system->rwlock);
+    _papplSystemWRLock(system);
 
     free(system->org_unit);
     system->org_unit = value ? strdup(value) : NULL;
@@ -1411,7 +1512,7 @@ papplSystemSetPassword(
 {
   if (system && hash)
   {
-    pthread_rwlock_wrlock(&system->rwlock);
+    _papplSystemWRLock(system);
 
     strlcpy(system->password_hash, hash, sizeof(system->password_hash));
 
@@ -1440,7 +1541,7 @@ papplSystemSetPrintDrivers(
 {
   if (system)
   {
-    pthread_rwlock_wrlock(&system->rwlock);
+    _papplSystemWRLock(system);
 
     system->config_time    = time(NULL);
     system->num_pdrivers   = num_names;
@@ -1455,7 +1556,11 @@ papplSystemSetPrintDrivers(
 
 
 //
-// The save callback can only be set prior to calling @link papplSystemRun@.
+// 'papplSystemSetSaveCallback()' - Set the save callback.
+//
+// The save callback is called from a background thread once changes have been
+// coalesced, see @link papplSystemSetSaveInterval@.  It can only be set prior
+// to calling @link papplSystemRun@.
 //
 
 void
@@ -1466,7 +1571,7 @@ papplSystemSetSaveCallback(
 {
   if (system && !system->is_running)
   {
-    pthread_rwlock_wrlock(&system->rwlock);
+    _papplSystemWRLock(system);
     system->save_cb     = cb;
     system->save_cbdata = data;
     pthread_rwlock_unlock(&system->rwlock);
@@ -1487,7 +1592,7 @@ papplSystemSetUUID(
 {
   if (system && !system->is_running)
   {
-    pthread_rwlock_wrlock(&system->rwlock);
+    _papplSystemWRLock(system);
 
     free(system->uuid);
 
@@ -1525,7 +1630,7 @@ papplSystemSetVersions(
 {
   if (system && num_versions && versions && !system->is_running)
   {
-    pthread_rwlock_wrlock(&system->rwlock);
+    _papplSystemWRLock(system);
 
     if (num_versions > (int)(sizeof(system->versions) / sizeof(system->versions[0])))
       system->num_versions = (int)(sizeof(system->versions) / sizeof(system->versions[0]));
@@ -1595,6 +1700,19 @@ add_listeners(
 }
 
 
+//
+// 'compare_filter_ptrs()' - Compare two filter pointers.
+//
+
+static int				// O - Result of comparison
+compare_filter_ptrs(
+    _pappl_mime_filter_t **a,		// I - First filter
+    _pappl_mime_filter_t **b)		// I - Second filter
+{
+  return (compare_filters(*a, *b));
+}
+
+
 //
 // 'compare_filters()' - Compare two filters.
 //
@@ -0,0 +1,822 @@
+//
+// Client connection handling for the Printer Application Framework
+//
+// Copyright © 2020 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+//
+// Include necessary headers...
+//
+
+#include "pappl-private.h"
+#ifdef HAVE_SYS_EPOLL_H
+#  include <sys/epoll.h>
+#endif // HAVE_SYS_EPOLL_H
+
+
+//
+// Local functions...
+//
+
+static pappl_client_t	*accept_client(pappl_system_t *system, int sock);
+static int		compare_addrs(_pappl_addr_t *a, _pappl_addr_t *b);
+static _pappl_addr_t	*find_addr(pappl_system_t *system, http_addr_t *addr);
+#ifdef HAVE_SYS_EPOLL_H
+static void		park_client(pappl_client_t *client);
+static void		*run_client(pappl_client_t *client);
+static void		unlink_client(pappl_system_t *system, pappl_client_t *client);
+#endif // HAVE_SYS_EPOLL_H
+
+
+//
+// '_papplSystemAdmitRequest()' - Apply admission control to a client request.
+//
+// Each request from a client address uses a token from that address' token
+// bucket, which refills at the configured request rate.  Polling requests are
+// rejected when the bucket is empty or when the client worker pool is
+// saturated.  Printer and job management requests and web interface requests
+// are admitted while the client worker pool is saturated but are still subject
+// to the rate limit.  Job submission requests are always admitted.
+//
+
+bool					// O - `true` to process the request, `false` to reject it
+_papplSystemAdmitRequest(
+    pappl_system_t *system,		// I - System
+    pappl_client_t *client,		// I - Client
+    _pappl_admit_t admit)		// I - Admission class of request
+{
+  bool			ret = true;	// Return value
+  bool			saturated;	// Is the client worker pool saturated?
+  _pappl_addr_t		*address = client->address;
+					// Client address
+  struct timeval	curtime;	// Current time
+
+
+  saturated = admit == _PAPPL_ADMIT_POLL && _papplSystemIsSaturated(system);
+
+  pthread_mutex_lock(&system->clients_mutex);
+
+  if (saturated)
+  {
+    system->rejected_busy ++;
+    ret = false;
+  }
+  else if (address && system->request_rate > 0)
+  {
+    // Refill the token bucket and use a token...
+    gettimeofday(&curtime, NULL);
+
+    address->tokens += system->request_rate * ((curtime.tv_sec - address->tokens_time.tv_sec) + 0.000001 * (curtime.tv_usec - address->tokens_time.tv_usec));
+    if (address->tokens > system->request_burst)
+      address->tokens = system->request_burst;
+
+    address->tokens_time = curtime;
+
+    if (address->tokens >= 1.0)
+    {
+      address->tokens -= 1.0;
+    }
+    else if (admit != _PAPPL_ADMIT_SUBMIT)
+    {
+      system->rejected_rate ++;
+      ret = false;
+    }
+  }
+
+  pthread_mutex_unlock(&system->clients_mutex);
+
+  if (!ret)
+    papplLogClient(client, PAPPL_LOGLEVEL_DEBUG, "Rejecting request (%s).", saturated ? "server busy" : "too many requests");
+
+  return (ret);
+}
+
+
+//
+// 'papplSystemGetClientMetrics()' - Get the client connection metrics.
+//
+// The metrics report the number of client connections along with the number
+// of connections and requests that have been rejected by admission control.
+//
+
+pappl_cmetrics_t *			// O - Metrics data or `NULL` on error
+papplSystemGetClientMetrics(
+    pappl_system_t   *system,		// I - System
+    pappl_cmetrics_t *metrics)		// I - Buffer for metrics data
+{
+  if (!system || !metrics)
+    return (NULL);
+
+  pthread_mutex_lock(&system->clients_mutex);
+
+  metrics->max_clients      = system->max_clients;
+  metrics->num_clients      = system->num_clients;
+  metrics->rejected_clients = system->rejected_clients;
+  metrics->rejected_address = system->rejected_address;
+  metrics->rejected_rate    = system->rejected_rate;
+  metrics->rejected_busy    = system->rejected_busy;
+  metrics->header_timeouts  = system->header_timeouts;
+
+  pthread_mutex_unlock(&system->clients_mutex);
+
+  return (metrics);
+}
+
+
+//
+// 'papplSystemGetHeaderTimeout()' - Get the request header timeout.
+//
+
+int					// O - Seconds to receive request header fields
+papplSystemGetHeaderTimeout(
+    pappl_system_t *system)		// I - System
+{
+  int	ret = 0;			// Return value
+
+
+  if (system)
+  {
+    pthread_mutex_lock(&system->clients_mutex);
+    ret = system->header_timeout;
+    pthread_mutex_unlock(&system->clients_mutex);
+  }
+
+  return (ret);
+}
+
+
+//
+// 'papplSystemGetMaxClients()' - Get the maximum number of client connections.
+//
+
+int					// O - Maximum number of client connections
+papplSystemGetMaxClients(
+    pappl_system_t *system)		// I - System
+{
+  int	ret = 0;			// Return value
+
+
+  if (system)
+  {
+    pthread_mutex_lock(&system->clients_mutex);
+    ret = system->max_clients;
+    pthread_mutex_unlock(&system->clients_mutex);
+  }
+
+  return (ret);
+}
+
+
+//
+// 'papplSystemGetMaxClientsPerAddress()' - Get the maximum number of client connections per address.
+//
+
+int					// O - Maximum number of client connections per address or `0` for no limit
+papplSystemGetMaxClientsPerAddress(
+    pappl_system_t *system)		// I - System
+{
+  int	ret = 0;			// Return value
+
+
+  if (system)
+  {
+    pthread_mutex_lock(&system->clients_mutex);
+    ret = system->max_addr_clients;
+    pthread_mutex_unlock(&system->clients_mutex);
+  }
+
+  return (ret);
+}
+
+
+//
+// 'papplSystemGetRequestRate()' - Get the request rate limit for each client address.
+//
+
+int					// O - Requests per second or `0` for no limit
+papplSystemGetRequestRate(
+    pappl_system_t *system,		// I - System
+    int            *burst)		// O - Maximum burst of requests or `NULL`
+{
+  int	ret = 0;			// Return value
+
+
+  if (burst)
+    *burst = 0;
+
+  if (system)
+  {
+    pthread_mutex_lock(&system->clients_mutex);
+    ret = system->request_rate;
+    if (burst)
+      *burst = system->request_burst;
+    pthread_mutex_unlock(&system->clients_mutex);
+  }
+
+  return (ret);
+}
+
+
+//
+// '_papplSystemRunClients()' - Accept and dispatch client connections.
+//
+// On platforms that support it, client connections are monitored using a
+// single epoll descriptor.  Idle (keep-alive) connections only use memory for
+// the client and HTTP connection state - a request is handed to the worker
+// pool when data arrives, and the connection is returned to the idle list once
+// the request has been processed.  Connections that stay idle for more than
+// 30 seconds are closed.
+//
+// Otherwise each client connection is processed on its own thread.
+//
+// In both cases, connections from clients that have not sent a complete
+// request line and header fields by the header timeout are shut down so that
+// slow clients cannot hold on to a thread.
+//
+
+bool					// O - `true` on success, `false` on hard error
+_papplSystemRunClients(
+    pappl_system_t *system,		// I - System
+    int            timeout)		// I - Timeout in milliseconds
+{
+  int			i,		// Looping var
+			count;		// Number of events
+  pappl_client_t	*client;	// Current client
+  time_t		curtime;	// Current time
+#ifdef HAVE_SYS_EPOLL_H
+  struct epoll_event	events[64],	// Events
+			*event;		// Current event
+  struct pollfd		*listener;	// Listener socket
+  pappl_client_t	*expired = NULL;// Expired idle clients
+
+
+  if ((count = epoll_wait(system->clients_fd, events, (int)(sizeof(events) / sizeof(events[0])), timeout)) < 0 && errno != EINTR && errno != EAGAIN)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to accept new connections: %s", strerror(errno));
+    return (false);
+  }
+
+  for (i = 0, event = events; i < count; i ++, event ++)
+  {
+    listener = (struct pollfd *)event->data.ptr;
+
+    if (listener >= system->listeners && listener < (system->listeners + system->num_listeners))
+    {
+      // Accept a new client connection...
+      if ((client = accept_client(system, listener->fd)) != NULL)
+        park_client(client);
+    }
+    else
+    {
+      // Process the next request(s) from a client on a worker thread...
+      client = (pappl_client_t *)event->data.ptr;
+
+      pthread_mutex_lock(&system->clients_mutex);
+      unlink_client(system, client);
+      pthread_mutex_unlock(&system->clients_mutex);
+
+      if (!_papplSystemAddClientWork(system, (_pappl_work_cb_t)run_client, client))
+        papplClientDelete(client);
+    }
+  }
+
+  // Close idle client connections...
+  curtime = time(NULL);
+
+  pthread_mutex_lock(&system->clients_mutex);
+
+  while ((client = system->idle_first) != NULL && client->idle_time < (curtime - _PAPPL_CLIENT_IDLE))
+  {
+    unlink_client(system, client);
+    epoll_ctl(system->clients_fd, EPOLL_CTL_DEL, httpGetFd(client->http), NULL);
+
+    client->idle_next = expired;
+    expired           = client;
+  }
+
+  pthread_mutex_unlock(&system->clients_mutex);
+
+  while ((client = expired) != NULL)
+  {
+    expired = client->idle_next;
+
+    papplClientDelete(client);
+  }
+
+#else
+  if ((count = poll(system->listeners, (nfds_t)system->num_listeners, timeout)) < 0 && errno != EINTR && errno != EAGAIN)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to accept new connections: %s", strerror(errno));
+    return (false);
+  }
+
+  if (count > 0)
+  {
+    // Accept client connections as needed...
+    for (i = 0; i < system->num_listeners; i ++)
+    {
+      if (system->listeners[i].revents & POLLIN)
+      {
+	if ((client = accept_client(system, system->listeners[i].fd)) != NULL)
+	{
+	  if (pthread_create(&client->thread_id, NULL, (void *(*)(void *))_papplClientRun, client))
+	  {
+	    // Unable to create client thread...
+	    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create client thread: %s", strerror(errno));
+	    papplClientDelete(client);
+	  }
+	  else
+	  {
+	    // Detach the main thread from the client thread to prevent hangs...
+	    pthread_detach(client->thread_id);
+	  }
+	}
+      }
+    }
+  }
+
+  curtime = time(NULL);
+#endif // HAVE_SYS_EPOLL_H
+
+  pthread_mutex_lock(&system->clients_mutex);
+
+  if (system->clients_time != curtime)
+  {
+    _pappl_addr_t	*address;	// Current client address
+
+    system->clients_time = curtime;
+
+    // Shut down connections from slow clients.  The connection is closed by
+    // the thread processing the client once its read fails...
+    for (client = (pappl_client_t *)cupsArrayFirst(system->header_clients); client; client = (pappl_client_t *)cupsArrayNext(system->header_clients))
+    {
+      if (client->header_time <= curtime)
+      {
+	papplLogClient(client, PAPPL_LOGLEVEL_WARN, "Timed out waiting for request header fields.");
+	shutdown(httpGetFd(client->http), SHUT_RDWR);
+	cupsArrayRemove(system->header_clients, client);
+	system->header_timeouts ++;
+      }
+    }
+
+    // Forget addresses without connections whose token bucket has refilled...
+    for (address = (_pappl_addr_t *)cupsArrayFirst(system->addrs); address; address = (_pappl_addr_t *)cupsArrayNext(system->addrs))
+    {
+      if (address->num_clients == 0 && (system->request_rate <= 0 || (address->tokens + system->request_rate * (curtime - address->tokens_time.tv_sec)) >= system->request_burst))
+      {
+        cupsArrayRemove(system->addrs, address);
+        free(address);
+      }
+    }
+  }
+
+  pthread_mutex_unlock(&system->clients_mutex);
+
+  return (true);
+}
+
+
+//
+// 'papplSystemSetHeaderTimeout()' - Set the request header timeout.
+//
+// Clients must send a complete request line and header fields within the
+// specified number of seconds of the start of each request, otherwise the
+// connection is closed.  This prevents slow clients from trickling in headers
+// to tie up threads and connections.
+//
+// The default request header timeout is `15` seconds.
+//
+
+void
+papplSystemSetHeaderTimeout(
+    pappl_system_t *system,		// I - System
+    int            timeout)		// I - Seconds to receive request header fields
+{
+  if (system && timeout > 0)
+  {
+    pthread_mutex_lock(&system->clients_mutex);
+    system->header_timeout = timeout;
+    pthread_mutex_unlock(&system->clients_mutex);
+  }
+}
+
+
+//
+// 'papplSystemSetMaxClients()' - Set the maximum number of client connections.
+//
+// New connections are closed immediately while the maximum number of client
+// connections are open.
+//
+// The default maximum number of client connections is `1024`.
+//
+
+void
+papplSystemSetMaxClients(
+    pappl_system_t *system,		// I - System
+    int            max_clients)		// I - Maximum number of client connections
+{
+  if (system && max_clients > 0)
+  {
+    pthread_mutex_lock(&system->clients_mutex);
+    system->max_clients = max_clients;
+    pthread_mutex_unlock(&system->clients_mutex);
+  }
+}
+
+
+//
+// 'papplSystemSetMaxClientsPerAddress()' - Set the maximum number of client connections per address.
+//
+// New connections from a client address are closed immediately while the
+// maximum number of client connections from that address are open.
+//
+// The default is `0` which only applies the overall limit set using
+// @link papplSystemSetMaxClients@.
+//
+
+void
+papplSystemSetMaxClientsPerAddress(
+    pappl_system_t *system,		// I - System
+    int            max_clients)		// I - Maximum number of client connections per address or `0` for no limit
+{
+  if (system && max_clients >= 0)
+  {
+    pthread_mutex_lock(&system->clients_mutex);
+    system->max_addr_clients = max_clients;
+    pthread_mutex_unlock(&system->clients_mutex);
+  }
+}
+
+
+//
+// 'papplSystemSetRequestRate()' - Set the request rate limit for each client address.
+//
+// Requests from each client address are limited to an average of "rate"
+// requests per second with bursts of up to "burst" requests.  Web requests
+// over the limit get a "503 Service Unavailable" response and IPP requests get
+// a "server-error-busy" response.  Job submission requests (Print-Job,
+// Print-URI, Create-Job, Send-Document, and Send-URI) are always accepted.
+//
+// The default is `0` which disables the rate limit.
+//
+
+void
+papplSystemSetRequestRate(
+    pappl_system_t *system,		// I - System
+    int            rate,		// I - Requests per second or `0` for no limit
+    int            burst)		// I - Maximum burst of requests
+{
+  if (system && rate >= 0)
+  {
+    if (burst < rate)
+      burst = rate;
+
+    pthread_mutex_lock(&system->clients_mutex);
+    system->request_rate  = rate;
+    system->request_burst = burst;
+    pthread_mutex_unlock(&system->clients_mutex);
+  }
+}
+
+
+//
+// '_papplSystemStartClients()' - Start accepting client connections.
+//
+
+bool					// O - `true` on success, `false` on failure
+_papplSystemStartClients(
+    pappl_system_t *system)		// I - System
+{
+#ifdef HAVE_SYS_EPOLL_H
+  int			i,		// Looping var
+			fd;		// Event descriptor
+  struct epoll_event	event;		// Listener event
+
+
+  if ((fd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_FATAL, "Unable to create client event descriptor: %s", strerror(errno));
+    return (false);
+  }
+
+  for (i = 0; i < system->num_listeners; i ++)
+  {
+    event.events   = EPOLLIN;
+    event.data.ptr = system->listeners + i;
+
+    if (epoll_ctl(fd, EPOLL_CTL_ADD, system->listeners[i].fd, &event))
+    {
+      papplLog(system, PAPPL_LOGLEVEL_FATAL, "Unable to monitor listener socket: %s", strerror(errno));
+      close(fd);
+      return (false);
+    }
+  }
+
+  pthread_mutex_lock(&system->clients_mutex);
+  system->clients_fd = fd;
+  pthread_mutex_unlock(&system->clients_mutex);
+
+#else
+  (void)system;
+#endif // HAVE_SYS_EPOLL_H
+
+  return (true);
+}
+
+
+//
+// '_papplSystemStopClients()' - Stop accepting client connections.
+//
+// Idle client connections are closed immediately.  Client connections with a
+// request in progress are closed once the request has been processed.
+//
+
+void
+_papplSystemStopClients(
+    pappl_system_t *system)		// I - System
+{
+#ifdef HAVE_SYS_EPOLL_H
+  int			fd;		// Event descriptor
+  pappl_client_t	*client,	// Current client
+			*next;		// Next client
+
+
+  pthread_mutex_lock(&system->clients_mutex);
+
+  fd                 = system->clients_fd;
+  client             = system->idle_first;
+  system->clients_fd = -1;
+  system->idle_first = system->idle_last = NULL;
+
+  pthread_mutex_unlock(&system->clients_mutex);
+
+  if (fd >= 0)
+    close(fd);
+
+  for (; client; client = next)
+  {
+    next = client->idle_next;
+
+    papplClientDelete(client);
+  }
+
+#else
+  (void)system;
+#endif // HAVE_SYS_EPOLL_H
+}
+
+
+//
+// '_papplSystemUnwatchClient()' - Stop watching a client's request headers.
+//
+
+void
+_papplSystemUnwatchClient(
+    pappl_system_t *system,		// I - System
+    pappl_client_t *client)		// I - Client
+{
+  pthread_mutex_lock(&system->clients_mutex);
+  cupsArrayRemove(system->header_clients, client);
+  client->header_time = 0;
+  pthread_mutex_unlock(&system->clients_mutex);
+}
+
+
+//
+// '_papplSystemWatchClient()' - Start watching a client's request headers.
+//
+// The client's connection is shut down if the request line and header fields
+// are not received before the header timeout.  Watching a client that is
+// already being watched keeps the current deadline.
+//
+
+void
+_papplSystemWatchClient(
+    pappl_system_t *system,		// I - System
+    pappl_client_t *client)		// I - Client
+{
+  pthread_mutex_lock(&system->clients_mutex);
+
+  if (!client->header_time)
+  {
+    client->header_time = time(NULL) + system->header_timeout;
+
+    if (!system->header_clients)
+      system->header_clients = cupsArrayNew(NULL, NULL);
+
+    cupsArrayAdd(system->header_clients, client);
+  }
+
+  pthread_mutex_unlock(&system->clients_mutex);
+}
+
+
+//
+// 'accept_client()' - Accept a new client connection.
+//
+
+static pappl_client_t *			// O - Client or `NULL` on error
+accept_client(pappl_system_t *system,	// I - System
+              int            sock)	// I - Listener socket
+{
+  pappl_client_t	*client;	// New client
+  _pappl_addr_t		*address;	// Client address
+  const char		*reason = NULL;	// Reason for rejecting client
+
+
+  if ((client = papplClientCreate(system, sock)) == NULL)
+    return (NULL);
+
+  pthread_mutex_lock(&system->clients_mutex);
+
+  if (system->num_clients > system->max_clients)
+  {
+    reason = "Too many client connections.";
+    system->rejected_clients ++;
+  }
+  else if ((address = find_addr(system, httpGetAddress(client->http))) == NULL)
+  {
+    reason = "Unable to allocate memory for client address.";
+  }
+  else if (system->max_addr_clients > 0 && address->num_clients >= system->max_addr_clients)
+  {
+    reason = "Too many client connections from this address.";
+    system->rejected_address ++;
+  }
+  else
+  {
+    client->address = address;
+    address->num_clients ++;
+  }
+
+  pthread_mutex_unlock(&system->clients_mutex);
+
+  if (reason)
+  {
+    papplLogClient(client, PAPPL_LOGLEVEL_WARN, "%s", reason);
+    papplClientDelete(client);
+    return (NULL);
+  }
+
+  return (client);
+}
+
+
+//
+// 'compare_addrs()' - Compare two client addresses.
+//
+
+static int				// O - Result of comparison
+compare_addrs(_pappl_addr_t *a,		// I - First address
+              _pappl_addr_t *b)		// I - Second address
+{
+  if (a->addr.addr.sa_family != b->addr.addr.sa_family)
+    return (a->addr.addr.sa_family - b->addr.addr.sa_family);
+
+  switch (a->addr.addr.sa_family)
+  {
+    case AF_INET :
+        return (memcmp(&a->addr.ipv4.sin_addr, &b->addr.ipv4.sin_addr, sizeof(a->addr.ipv4.sin_addr)));
+
+#ifdef AF_INET6
+    case AF_INET6 :
+        return (memcmp(&a->addr.ipv6.sin6_addr, &b->addr.ipv6.sin6_addr, sizeof(a->addr.ipv6.sin6_addr)));
+#endif // AF_INET6
+
+    default :
+        // All local (domain socket) clients share the same address...
+        return (0);
+  }
+}
+
+
+//
+// 'find_addr()' - Find or add a client address.
+//
+// The caller must hold the clients mutex.
+//
+
+static _pappl_addr_t *			// O - Client address or `NULL` on error
+find_addr(pappl_system_t *system,	// I - System
+          http_addr_t    *addr)		// I - Address
+{
+  _pappl_addr_t	key,			// Search key
+		*address;		// Client address
+
+
+  if (!addr)
+    return (NULL);
+
+  if (!system->addrs && (system->addrs = cupsArrayNew((cups_array_func_t)compare_addrs, NULL)) == NULL)
+    return (NULL);
+
+  key.addr = *addr;
+
+  if ((address = (_pappl_addr_t *)cupsArrayFind(system->addrs, &key)) == NULL)
+  {
+    // New address, start with a full token bucket...
+    if ((address = calloc(1, sizeof(_pappl_addr_t))) == NULL)
+      return (NULL);
+
+    address->addr   = *addr;
+    address->tokens = system->request_burst;
+    gettimeofday(&address->tokens_time, NULL);
+
+    cupsArrayAdd(system->addrs, address);
+  }
+
+  return (address);
+}
+
+
+#ifdef HAVE_SYS_EPOLL_H
+//
+// 'park_client()' - Add a client to the idle list and wait for its next request.
+//
+
+static void
+park_client(pappl_client_t *client)	// I - Client
+{
+  pappl_system_t	*system = client->system;
+					// System
+  struct epoll_event	event;		// Client event
+  bool			parked = false;	// Was the client parked?
+
+
+  pthread_mutex_lock(&system->clients_mutex);
+
+  if (system->clients_fd >= 0)
+  {
+    // Wait for a single event - the client is re-armed after each request...
+    event.events   = EPOLLIN | EPOLLONESHOT;
+    event.data.ptr = client;
+
+    if (epoll_ctl(system->clients_fd, client->started ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, httpGetFd(client->http), &event))
+    {
+      papplLogClient(client, PAPPL_LOGLEVEL_ERROR, "Unable to monitor client connection: %s", strerror(errno));
+    }
+    else
+    {
+      client->idle_time = time(NULL);
+      client->idle_prev = system->idle_last;
+      client->idle_next = NULL;
+
+      if (system->idle_last)
+        system->idle_last->idle_next = client;
+      else
+        system->idle_first = client;
+
+      system->idle_last = client;
+      parked            = true;
+    }
+  }
+
+  pthread_mutex_unlock(&system->clients_mutex);
+
+  if (!parked)
+    papplClientDelete(client);
+}
+
+
+//
+// 'run_client()' - Process client requests on a worker thread.
+//
+
+static void *				// O - Thread exit status
+run_client(pappl_client_t *client)	// I - Client
+{
+  if (_papplClientProcessRequests(client))
+    park_client(client);
+  else
+    papplClientDelete(client);
+
+  return (NULL);
+}
+
+
+//
+// 'unlink_client()' - Remove a client from the idle list.
+//
+// The caller must hold the clients mutex.
+//
+
+static void
+unlink_client(pappl_system_t *system,	// I - System
+              pappl_client_t *client)	// I - Client
+{
+  if (client->idle_prev)
+    client->idle_prev->idle_next = client->idle_next;
+  else if (system->idle_first == client)
+    system->idle_first = client->idle_next;
+
+  if (client->idle_next)
+    client->idle_next->idle_prev = client->idle_prev;
+  else if (system->idle_last == client)
+    system->idle_last = client->idle_prev;
+
+  client->idle_prev = client->idle_next = NULL;
+}
+#endif // HAVE_SYS_EPOLL_H
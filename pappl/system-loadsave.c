@@ -20,6 +20,7 @@
 
 static void	parse_contact(char *value, pappl_contact_t *contact);
 static void	parse_media_col(char *value, pappl_media_col_t *media);
+static bool	sync_directory(pappl_system_t *system, const char *filename);
 static void	write_contact(cups_file_t *fp, pappl_contact_t *contact);
 static void	write_media_col(cups_file_t *fp, const char *name, pappl_media_col_t *media);
 static void	write_options(cups_file_t *fp, const char *name, int num_options, cups_option_t *options);
@@ -144,6 +145,10 @@ papplSystemLoadState(
 	  papplPrinterSetMaxActiveJobs(printer, atoi(value));
 	else if (!strcasecmp(line, "MaxCompletedJobs"))
 	  papplPrinterSetMaxCompletedJobs(printer, atoi(value));
+	else if (!strcasecmp(line, "MaxPreRIPJobs"))
+	  papplPrinterSetMaxPreRIPJobs(printer, atoi(value));
+	else if (!strcasecmp(line, "MaxPreRIPSize"))
+	  papplPrinterSetMaxPreRIPSize(printer, (size_t)strtoul(value, NULL, 10));
 	else if (!strcasecmp(line, "NextJobId"))
 	  printer->next_job_id = atoi(value);
 	else if (!strcasecmp(line, "ImpressionsCompleted"))
@@ -211,27 +216,40 @@ papplSystemLoadState(
 //
 // 'papplSystemSaveState()' - Save the current system state.
 //
-
+// The state is written to a temporary file that is synchronized to disk and
+// then renamed over the state file, so the state file is never left partially
+// written.  Saves are serialized so that the background save thread and an
+// explicit save do not write the same temporary file.
+//
 
 bool					// O - `true` on success, `false` on failure
 papplSystemSaveState(
     pappl_system_t *system,		// I - System
     const char     *filename)		// I - File to save
 {
-  int			i;		// Looping var
+  int			i, j;		// Looping vars
   cups_file_t		*fp;		// Output file
+  char			tempfile[1024];	// Temporary file
+  _pappl_plist_t	*plist;		// Printer list
   pappl_printer_t	*printer;	// Current printer
+  bool			ret = false;	// Return value
 
 
-  if ((fp = cupsFileOpen(filename, "w")) == NULL)
+  snprintf(tempfile, sizeof(tempfile), "%s.N", filename);
+
+  pthread_mutex_lock(&system->save_file_mutex);
+
+  if ((fp = cupsFileOpen(tempfile, "w")) == NULL)
   {
-    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create system state file '%s': %s", filename, cupsLastErrorString());
-    return (false);
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create system state file '%s': %s", tempfile, cupsLastErrorString());
+    goto done;
   }
 
   papplLog(system, PAPPL_LOGLEVEL_INFO, "Saving system state to '%s'.", filename);
 
-  pthread_rwlock_rdlock(&system->rwlock);
+  _papplSystemRDLock(system);
+
+  plist = _papplSystemGetPrinters(system);
 
   if (system->dns_sd_name)
     cupsFilePutConf(fp, "DNSSDName", system->dns_sd_name);
@@ -254,11 +272,13 @@ papplSystemSaveState(
   cupsFilePrintf(fp, "NextPrinterID %d\n", system->next_printer_id);
   cupsFilePutConf(fp, "UUID", system->uuid);
 
-  for (printer = (pappl_printer_t *)cupsArrayFirst(system->printers); printer; printer = (pappl_printer_t *)cupsArrayNext(system->printers))
+  for (j = 0; j < plist->num_printers; j ++)
   {
     int			num_options = 0;// Number of options
     cups_option_t	*options = NULL;// Options
 
+    printer = plist->printers[j];
+
     if (printer->is_deleted)
       continue;
 
@@ -286,6 +306,8 @@ papplSystemSaveState(
       cupsFilePutConf(fp, "PrintGroup", printer->print_group);
     cupsFilePrintf(fp, "MaxActiveJobs %d\n", printer->max_active_jobs);
     cupsFilePrintf(fp, "MaxCompletedJobs %d\n", printer->max_completed_jobs);
+    cupsFilePrintf(fp, "MaxPreRIPJobs %d\n", printer->max_prerip_jobs);
+    cupsFilePrintf(fp, "MaxPreRIPSize %lu\n", (unsigned long)printer->max_prerip_size);
     cupsFilePrintf(fp, "NextJobId %d\n", printer->next_job_id);
     cupsFilePrintf(fp, "ImpressionsCompleted %d\n", printer->impcompleted);
 
@@ -333,11 +355,41 @@ papplSystemSaveState(
     cupsFilePuts(fp, "</Printer>\n");
   }
 
+  _papplSystemReleasePrinters(system, plist);
+
   pthread_rwlock_unlock(&system->rwlock);
 
-  cupsFileClose(fp);
+  // Make sure the new state is on disk before replacing the old state...
+  if (cupsFileFlush(fp) || fsync(cupsFileNumber(fp)))
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to write system state file '%s': %s", tempfile, strerror(errno));
+    cupsFileClose(fp);
+    unlink(tempfile);
+    goto done;
+  }
 
-  return (true);
+  if (cupsFileClose(fp))
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to write system state file '%s': %s", tempfile, strerror(errno));
+    unlink(tempfile);
+    goto done;
+  }
+
+  if (rename(tempfile, filename))
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to rename '%s' to '%s': %s", tempfile, filename, strerror(errno));
+    unlink(tempfile);
+    goto done;
+  }
+
+  // Make sure the rename is on disk too...
+  ret = sync_directory(system, filename);
+
+  done:
+
+  pthread_mutex_unlock(&system->save_file_mutex);
+
+  return (ret);
 }
 
 
@@ -420,6 +472,48 @@ parse_media_col(
 }
 
 
+//
+// 'sync_directory()' - Synchronize the directory containing a file to disk.
+//
+
+static bool				// O - `true` on success, `false` on failure
+sync_directory(
+    pappl_system_t *system,		// I - System
+    const char     *filename)		// I - Filename
+{
+  char	directory[1024],		// Directory name
+	*ptr;				// Pointer into directory name
+  int	fd;				// Directory file descriptor
+  bool	ret = true;			// Return value
+
+
+  strlcpy(directory, filename, sizeof(directory));
+
+  if ((ptr = strrchr(directory, '/')) == NULL)
+    strlcpy(directory, ".", sizeof(directory));
+  else if (ptr == directory)
+    ptr[1] = '\0';
+  else
+    *ptr = '\0';
+
+  if ((fd = open(directory, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to open directory '%s': %s", directory, strerror(errno));
+    return (false);
+  }
+
+  if (fsync(fd))
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to synchronize directory '%s': %s", directory, strerror(errno));
+    ret = false;
+  }
+
+  close(fd);
+
+  return (ret);
+}
+
+
 //
 // 'write_contact()' - Write an "xxx-contact" value.
 //
@@ -18,19 +18,61 @@
 #  include "dnssd-private.h"
 #  include "system.h"
 #  include <grp.h>
+#  include <stdatomic.h>
+#  include <sys/time.h>
 
 
 //
 // Constants...
 //
 
+#  define _PAPPL_AUTH_CACHE	32	// Number of cached authentications
+#  define _PAPPL_AUTH_TTL	60	// Seconds to cache an authentication
+#  define _PAPPL_CLIENT_IDLE	30	// Seconds before idle client connections are closed
+#  define _PAPPL_COMPRESSION	1024	// Default minimum size of compressed responses
+#  define _PAPPL_HEADER_TIMEOUT	15	// Default seconds to receive request header fields
+#  define _PAPPL_MAX_CLIENTS	1024	// Default maximum number of client connections
+#  define _PAPPL_MAX_CLIENT_WORKERS 16	// Default maximum number of client worker threads
 #  define _PAPPL_MAX_LISTENERS	32	// Maximum number of listener sockets
+#  define _PAPPL_MAX_WORKERS	32	// Default maximum number of job worker threads
+#  define _PAPPL_SAVE_INTERVAL	2	// Default seconds to coalesce configuration changes
+#  define _PAPPL_SAVE_STATE_INTERVAL 60	// Seconds to coalesce counter-only changes
+#  define _PAPPL_STATUS_INTERVAL	5	// Default seconds between printer status polls
+#  define _PAPPL_STATUS_MAX_INTERVAL 300	// Maximum seconds between printer status polls
 
 
 //
 // Types and structures...
 //
 
+typedef enum _pappl_admit_e		// Request admission classes
+{
+  _PAPPL_ADMIT_POLL,				// Polling request, rejected when busy or over the rate limit
+  _PAPPL_ADMIT_PRIORITY,			// Management or web request, rejected when over the rate limit
+  _PAPPL_ADMIT_SUBMIT				// Job submission request, always admitted
+} _pappl_admit_t;
+
+typedef struct _pappl_addr_s		// Client address
+{
+  http_addr_t		addr;			// Address (port is ignored)
+  int			num_clients;		// Number of client connections
+  double		tokens;			// Number of request tokens available
+  struct timeval	tokens_time;		// Time of last token update
+} _pappl_addr_t;
+
+typedef struct _pappl_auth_s		// Cached authentication
+{
+  unsigned char		hash[32];		// Salted SHA-256 hash of "username:password"
+  time_t		expires;		// Expiration time or `0` if unused
+  gid_t			gid;			// Primary group ID
+  int			num_groups;		// Number of supplementary groups
+#  ifdef __APPLE__
+  int			groups[32];		// Supplementary groups
+#  else
+  gid_t			groups[32];		// Supplementary groups
+#  endif // __APPLE__
+} _pappl_auth_t;
+
 typedef struct _pappl_mime_filter_s	// MIME filter
 {
   const char		*src,			// Source MIME media type
@@ -39,6 +81,42 @@ typedef struct _pappl_mime_filter_s	// MIME filter
   void			*cbdata;		// Filter callback data
 } _pappl_mime_filter_t;
 
+typedef struct _pappl_plist_s		// Printer list (read-only snapshot)
+{
+  struct _pappl_plist_s	*next;			// Next retired printer list
+  int			refcount;		// Number of readers
+  int			num_printers;		// Number of printers
+  pappl_printer_t	*printers[];		// Printers, sorted by name
+} _pappl_plist_t;
+
+typedef void *(*_pappl_work_cb_t)(void *data);
+					// Worker pool callback function
+
+typedef struct _pappl_work_s		// Worker pool work item
+{
+  struct _pappl_work_s	*next;			// Next work item in queue
+  _pappl_work_cb_t	cb;			// Work callback function
+  void			*data;			// Work callback data
+  struct timeval	queued;			// Time when work item was queued
+} _pappl_work_t;
+
+typedef struct _pappl_pool_s		// Worker thread pool
+{
+  pappl_system_t	*system;		// System
+  pthread_mutex_t	mutex;			// Worker pool mutex
+  pthread_cond_t	cond;			// Worker pool condition
+  bool			shutdown;		// Are worker threads shutting down?
+  int			max_workers,		// Maximum number of worker threads
+			num_workers,		// Number of worker threads
+			idle_workers;		// Number of idle worker threads
+  _pappl_work_t		*work_first,		// First queued work item
+			*work_last;		// Last queued work item
+  size_t		work_queued,		// Number of queued work items
+			work_completed,		// Number of completed work items
+			work_wait_msecs,	// Total milliseconds work items waited in queue
+			work_max_wait_msecs;	// Maximum milliseconds a work item waited in queue
+} _pappl_pool_t;
+
 typedef struct _pappl_resource_s	// Resource
 {
   char			*path,			// Path
@@ -47,11 +125,28 @@ typedef struct _pappl_resource_s	// Resource
 			*language;		// Language (for strings)
   time_t		last_modified;		// Last-Modified date/time
   const void		*data;			// Static data
+  int			fd;			// Open file descriptor, if any
   size_t		length;			// Length of file/data
   pappl_resource_cb_t	cb;			// Dynamic callback
   void			*cbdata;		// Callback data
+  atomic_int		refcount;		// Number of client references
+  atomic_bool		removed;		// Has the resource been removed?
+  struct _pappl_resource_s *removed_next;	// Next removed resource
 } _pappl_resource_t;
 
+typedef struct _pappl_route_s		// Resource router entry
+{
+  unsigned		hash;			// Hash of path
+  _pappl_resource_t	*resource;		// Resource
+} _pappl_route_t;
+
+typedef struct _pappl_router_s		// Resource router (read-only snapshot)
+{
+  struct _pappl_router_s *next;			// Next retired router
+  size_t		mask;			// Size of routes table - 1
+  _pappl_route_t	routes[];		// Routes table
+} _pappl_router_t;
+
 struct _pappl_system_s			// System data
 {
   pthread_rwlock_t	rwlock;			// Reader/writer lock
@@ -62,6 +157,7 @@ struct _pappl_system_s			// System data
 			clean_time,		// Next clean time
 			shutdown_time;		// Shutdown requested?
   size_t		config_changes,		// Number of configuration changes
+			state_changes,		// Number of counter-only changes
 			save_changes;		// Number of saved changes
   char			*uuid,			// "system-uuid" value
 			*name,			// "system-name" value
@@ -82,11 +178,18 @@ struct _pappl_system_s			// System data
   int			logfd;			// Log file descriptor, if any
   pappl_loglevel_t	loglevel;		// Log level
   size_t		logmaxsize;		// Maximum log file size or `0` for none
+  size_t		compression;		// Minimum size of compressed responses or `0` for none
   char			*subtypes;		// DNS-SD sub-types, if any
   bool			tls_only;		// Only support TLS?
   char			*auth_service;		// PAM authorization service, if any
   char			*admin_group;		// PAM administrative group, if any
   gid_t			admin_gid;		// PAM administrative group ID
+  pthread_mutex_t	auth_mutex;		// Authentication cache mutex
+  char			auth_salt[33];		// Authentication cache hash salt
+  _pappl_auth_t		auth_cache[_PAPPL_AUTH_CACHE];
+						// Authentication cache
+  size_t		auth_hits,		// Number of authentication cache hits
+			auth_misses;		// Number of authentication cache misses
   char			*default_print_group;	// Default PAM printing group, if any
   char			session_key[65];	// Session key
   time_t		session_time;		// Session key time
@@ -95,9 +198,29 @@ struct _pappl_system_s			// System data
 						// Listener sockets
   cups_array_t		*links;			// Web navigation links
   cups_array_t		*resources;		// Array of resources
+  _Atomic(_pappl_router_t *) router;		// Current resource router
+  atomic_int		router_readers;		// Number of lookups using a router
+  pthread_mutex_t	router_mutex;		// Retired router mutex
+  _pappl_router_t	*retired_routers;	// Retired resource routers
+  _pappl_resource_t	*removed_resources;	// Removed resources
   cups_array_t		*filters;		// Array of filters
+  int			num_filters;		// Number of filters
+  _pappl_mime_filter_t	**filter_list;		// Sorted filters for lookups
   int			next_client;		// Next client number
   cups_array_t		*printers;		// Array of printers
+  size_t		printer_mask;		// Size of printer indexes - 1
+  pappl_printer_t	**printer_ids,		// Printers by printer-id
+			**printer_resources,	// Printers by resource path
+			**printer_uris;		// Printers by device URI
+  pthread_mutex_t	plist_mutex;		// Printer list mutex
+  _pappl_plist_t	*plist,			// Current printer list
+			*retired_plists;	// Retired printer lists
+  pappl_printer_t	*removed_printers;	// Removed printers
+  size_t		printer_snapshots;	// Number of printer lists published
+  atomic_size_t		read_locks,		// Number of system read locks
+			read_waits,		// Number of system read locks that waited
+			write_locks,		// Number of system write locks
+			write_waits;		// Number of system write locks that waited
   int			default_printer_id,	// Default printer-id
 			next_printer_id;	// Next printer-id
   char			password_hash[100];	// Access password hash
@@ -112,6 +235,16 @@ struct _pappl_system_s			// System data
   void			*op_cbdata;		// IPP operation callback data
   pappl_save_cb_t	save_cb;		// Save callback
   void			*save_cbdata;		// Save callback data
+  pthread_mutex_t	save_mutex;		// Save thread mutex
+  pthread_cond_t	save_cond;		// Save thread condition
+  pthread_mutex_t	save_file_mutex;	// Mutex for writing state files
+  pthread_t		save_tid;		// Save thread
+  bool			save_running,		// Is the save thread running?
+			save_shutdown;		// Is the save thread shutting down?
+  int			save_interval;		// Seconds to coalesce configuration changes
+  size_t		save_state_changes;	// Number of saved counter-only changes
+  time_t		save_config_time,	// Time of first unsaved configuration change
+			save_state_time;	// Time of first unsaved counter-only change
   _pappl_srv_t		dns_sd_ref;		// DNS-SD IPPS service
 #  ifdef HAVE_DNSSD
   DNSRecordRef		dns_sd_loc_ref;		// DNS-SD LOC record
@@ -120,6 +253,32 @@ struct _pappl_system_s			// System data
   bool			dns_sd_any_collision;	// Was there a name collision for any printer?
   bool			dns_sd_collision;	// Was there a name collision for this system?
   int			dns_sd_serial;		// DNS-SD serial number (for collisions)
+  _pappl_pool_t		job_workers,		// Worker pool for jobs and pre-RIPs
+			client_workers;		// Worker pool for client requests
+  pthread_mutex_t	status_mutex;		// Status poller mutex
+  pthread_cond_t	status_cond;		// Status poller condition
+  pthread_t		status_tid;		// Status poller thread
+  bool			status_running,		// Is the status poller running?
+			status_shutdown;	// Is the status poller shutting down?
+  int			status_interval;	// Seconds between status polls
+  pthread_mutex_t	clients_mutex;		// Client connection mutex
+  int			clients_fd;		// Client event (epoll) descriptor, if any
+  int			max_clients,		// Maximum number of client connections
+			num_clients;		// Number of client connections
+  pappl_client_t	*idle_first,		// Least recently active idle client
+			*idle_last;		// Most recently active idle client
+  int			header_timeout;		// Seconds to receive request header fields
+  cups_array_t		*header_clients;	// Clients reading request header fields
+  time_t		clients_time;		// Time of last client check
+  cups_array_t		*addrs;			// Client addresses
+  int			max_addr_clients,	// Maximum number of client connections per address
+			request_rate,		// Requests per second per address
+			request_burst;		// Maximum request burst per address
+  size_t		rejected_clients,	// Number of connections rejected by the global limit
+			rejected_address,	// Number of connections rejected by the per-address limit
+			rejected_rate,		// Number of requests rejected by the rate limit
+			rejected_busy,		// Number of requests rejected while saturated
+			header_timeouts;	// Number of connections closed by the header timeout
 };
 
 
@@ -127,15 +286,38 @@ struct _pappl_system_s			// System data
 // Functions...
 //
 
+extern bool		_papplSystemAddClientWork(pappl_system_t *system, _pappl_work_cb_t cb, void *data) _PAPPL_PRIVATE;
+extern bool		_papplSystemAddWork(pappl_system_t *system, _pappl_work_cb_t cb, void *data) _PAPPL_PRIVATE;
+extern bool		_papplSystemAdmitRequest(pappl_system_t *system, pappl_client_t *client, _pappl_admit_t admit) _PAPPL_PRIVATE;
 extern void		_papplSystemAddPrinterIcons(pappl_system_t *system, pappl_printer_t *printer) _PAPPL_PRIVATE;
 extern void		_papplSystemCleanJobs(pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplSystemClearAuthCache(pappl_system_t *system) _PAPPL_PRIVATE;
 extern void		_papplSystemConfigChanged(pappl_system_t *system) _PAPPL_PRIVATE;
-extern void		_papplSystemExportVersions(pappl_system_t *system, ipp_t *ipp, ipp_tag_t group_tag, cups_array_t *ra);
+extern void		_papplSystemDeletePrinters(pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplSystemDeleteResources(pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplSystemExportVersions(pappl_system_t *system, ipp_t *ipp, ipp_tag_t group_tag, _pappl_ra_t *ra) _PAPPL_PRIVATE;
 extern _pappl_mime_filter_t *_papplSystemFindMIMEFilter(pappl_system_t *system, const char *srctype, const char *dsttype) _PAPPL_PRIVATE;
 extern _pappl_resource_t *_papplSystemFindResource(pappl_system_t *system, const char *path) _PAPPL_PRIVATE;
+extern _pappl_plist_t	*_papplSystemGetPrinters(pappl_system_t *system) _PAPPL_PRIVATE;
+extern bool		_papplSystemIsSaturated(pappl_system_t *system) _PAPPL_PRIVATE;
 extern char		*_papplSystemMakeUUID(pappl_system_t *system, const char *printer_name, int job_id, char *buffer, size_t bufsize) _PAPPL_PRIVATE;
+extern void		_papplSystemRDLock(pappl_system_t *system) _PAPPL_PRIVATE;
 extern bool		_papplSystemRegisterDNSSDNoLock(pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplSystemReleasePrinters(pappl_system_t *system, _pappl_plist_t *plist) _PAPPL_PRIVATE;
+extern void		_papplSystemReleaseResource(pappl_system_t *system, _pappl_resource_t *r) _PAPPL_PRIVATE;
+extern bool		_papplSystemRunClients(pappl_system_t *system, int timeout) _PAPPL_PRIVATE;
+extern bool		_papplSystemStartClients(pappl_system_t *system) _PAPPL_PRIVATE;
+extern bool		_papplSystemStartSave(pappl_system_t *system) _PAPPL_PRIVATE;
+extern bool		_papplSystemStartStatus(pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplSystemStateChanged(pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplSystemStopClients(pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplSystemStopSave(pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplSystemStopStatus(pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplSystemStopWorkers(pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplSystemUnwatchClient(pappl_system_t *system, pappl_client_t *client) _PAPPL_PRIVATE;
+extern void		_papplSystemWatchClient(pappl_system_t *system, pappl_client_t *client) _PAPPL_PRIVATE;
 extern void		_papplSystemUnregisterDNSSDNoLock(pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplSystemWRLock(pappl_system_t *system) _PAPPL_PRIVATE;
 
 extern void		_papplSystemWebAddPrinter(pappl_client_t *client, pappl_system_t *system) _PAPPL_PRIVATE;
 extern void		_papplSystemWebConfig(pappl_client_t *client, pappl_system_t *system) _PAPPL_PRIVATE;
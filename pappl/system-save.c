@@ -0,0 +1,235 @@
+//
+// Background state saving for the Printer Application Framework
+//
+// Copyright © 2020 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+//
+// Include necessary headers...
+//
+
+#include "pappl-private.h"
+
+
+//
+// Local functions...
+//
+
+static void	check_save(pappl_system_t *system, int interval, bool force);
+static void	*run_save(pappl_system_t *system);
+
+
+//
+// 'papplSystemGetSaveInterval()' - Get the configuration save interval.
+//
+
+int					// O - Seconds to coalesce configuration changes
+papplSystemGetSaveInterval(
+    pappl_system_t *system)		// I - System
+{
+  int	ret = 0;			// Return value
+
+
+  if (system)
+  {
+    pthread_mutex_lock(&system->save_mutex);
+    ret = system->save_interval;
+    pthread_mutex_unlock(&system->save_mutex);
+  }
+
+  return (ret);
+}
+
+
+//
+// 'papplSystemSetSaveInterval()' - Set the configuration save interval.
+//
+// Configuration changes are coalesced and saved by calling the save callback
+// from a background thread the specified number of seconds after the first
+// unsaved change.  Changes that only update job IDs and impression counters
+// are saved with the next configuration change or at most once every 60
+// seconds.  Any unsaved changes are saved when the system is shut down.
+//
+// The default save interval is `2` seconds.
+//
+
+void
+papplSystemSetSaveInterval(
+    pappl_system_t *system,		// I - System
+    int            interval)		// I - Seconds to coalesce configuration changes
+{
+  if (system && interval >= 0)
+  {
+    pthread_mutex_lock(&system->save_mutex);
+    system->save_interval = interval;
+    pthread_cond_signal(&system->save_cond);
+    pthread_mutex_unlock(&system->save_mutex);
+  }
+}
+
+
+//
+// '_papplSystemStartSave()' - Start the background save thread.
+//
+
+bool					// O - `true` on success, `false` on failure
+_papplSystemStartSave(
+    pappl_system_t *system)		// I - System
+{
+  bool	ret = true;			// Return value
+
+
+  pthread_mutex_lock(&system->save_mutex);
+
+  if (!system->save_running && system->save_cb)
+  {
+    system->save_shutdown = false;
+
+    if (pthread_create(&system->save_tid, NULL, (void *(*)(void *))run_save, system))
+    {
+      papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create save thread: %s", strerror(errno));
+      ret = false;
+    }
+    else
+      system->save_running = true;
+  }
+
+  pthread_mutex_unlock(&system->save_mutex);
+
+  return (ret);
+}
+
+
+//
+// '_papplSystemStopSave()' - Stop the background save thread.
+//
+// This function waits for any save in progress to complete and then saves any
+// remaining changes.
+//
+
+void
+_papplSystemStopSave(
+    pappl_system_t *system)		// I - System
+{
+  pthread_mutex_lock(&system->save_mutex);
+
+  if (system->save_running)
+  {
+    system->save_shutdown = true;
+    pthread_cond_signal(&system->save_cond);
+
+    pthread_mutex_unlock(&system->save_mutex);
+
+    pthread_join(system->save_tid, NULL);
+
+    pthread_mutex_lock(&system->save_mutex);
+    system->save_running = false;
+  }
+
+  pthread_mutex_unlock(&system->save_mutex);
+
+  if (system->save_cb)
+    check_save(system, 0, true);
+}
+
+
+//
+// 'check_save()' - Save the system state if changes are due to be saved.
+//
+
+static void
+check_save(pappl_system_t *system,	// I - System
+           int            interval,	// I - Seconds to coalesce configuration changes
+           bool           force)	// I - Save all changes now?
+{
+  size_t	config_changes,		// Number of configuration changes
+		state_changes;		// Number of counter-only changes
+  time_t	curtime = time(NULL);	// Current time
+  bool		save = false;		// Save now?
+
+
+  _papplSystemRDLock(system);
+  config_changes = system->config_changes;
+  state_changes  = system->state_changes;
+  pthread_rwlock_unlock(&system->rwlock);
+
+  if (config_changes > system->save_changes)
+  {
+    // Configuration changes are saved shortly after the first change...
+    if (!system->save_config_time)
+      system->save_config_time = curtime;
+
+    if (force || curtime >= (system->save_config_time + interval))
+      save = true;
+  }
+
+  if (state_changes > system->save_state_changes)
+  {
+    // Counter-only changes are saved much less often...
+    if (!system->save_state_time)
+      system->save_state_time = curtime;
+
+    if (force || curtime >= (system->save_state_time + _PAPPL_SAVE_STATE_INTERVAL))
+      save = true;
+  }
+
+  if (!save)
+    return;
+
+  // Save the configuration and counters...
+  if ((system->save_cb)(system, system->save_cbdata))
+  {
+    system->save_changes       = config_changes;
+    system->save_state_changes = state_changes;
+    system->save_config_time   = 0;
+    system->save_state_time    = 0;
+  }
+  else
+  {
+    // Try again after the save interval...
+    system->save_config_time = curtime;
+    system->save_state_time  = curtime;
+  }
+}
+
+
+//
+// 'run_save()' - Save the system state in the background.
+//
+
+static void *				// O - Thread exit status
+run_save(pappl_system_t *system)	// I - System
+{
+  int			interval;	// Seconds to coalesce changes
+  struct timespec	timeout;	// Timeout for condition
+
+
+  pthread_mutex_lock(&system->save_mutex);
+
+  while (!system->save_shutdown)
+  {
+    interval = system->save_interval;
+
+    pthread_mutex_unlock(&system->save_mutex);
+
+    check_save(system, interval, false);
+
+    // Check for changes once a second...
+    pthread_mutex_lock(&system->save_mutex);
+
+    if (!system->save_shutdown)
+    {
+      timeout.tv_sec  = time(NULL) + 1;
+      timeout.tv_nsec = 0;
+
+      pthread_cond_timedwait(&system->save_cond, &system->save_mutex, &timeout);
+    }
+  }
+
+  pthread_mutex_unlock(&system->save_mutex);
+
+  return (NULL);
+}
@@ -0,0 +1,267 @@
+//
+// Printer status poller for the Printer Application Framework
+//
+// Copyright © 2020 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+//
+// Include necessary headers...
+//
+
+#include "pappl-private.h"
+
+
+//
+// Local functions...
+//
+
+static void	poll_status(pappl_printer_t *printer, int interval);
+static void	*run_status(pappl_system_t *system);
+
+
+//
+// 'papplSystemGetStatusInterval()' - Get the printer status polling interval.
+//
+
+int					// O - Seconds between status polls
+papplSystemGetStatusInterval(
+    pappl_system_t *system)		// I - System
+{
+  int	ret = 0;			// Return value
+
+
+  if (system)
+  {
+    pthread_mutex_lock(&system->status_mutex);
+    ret = system->status_interval;
+    pthread_mutex_unlock(&system->status_mutex);
+  }
+
+  return (ret);
+}
+
+
+//
+// 'papplSystemSetStatusInterval()' - Set the printer status polling interval.
+//
+// Printer status is queried in the background by calling the driver's status
+// callback for each idle printer at the specified interval.  A small random
+// delay is added to each poll so that printers are not queried in lockstep,
+// and the interval is doubled (up to 5 minutes) each time the status callback
+// fails.  IPP and web clients only see the cached results.
+//
+// The default status polling interval is `5` seconds.
+//
+
+void
+papplSystemSetStatusInterval(
+    pappl_system_t *system,		// I - System
+    int            interval)		// I - Seconds between status polls
+{
+  if (system && interval > 0)
+  {
+    pthread_mutex_lock(&system->status_mutex);
+    system->status_interval = interval;
+    pthread_cond_signal(&system->status_cond);
+    pthread_mutex_unlock(&system->status_mutex);
+  }
+}
+
+
+//
+// '_papplSystemStartStatus()' - Start the printer status poller.
+//
+
+bool					// O - `true` on success, `false` on failure
+_papplSystemStartStatus(
+    pappl_system_t *system)		// I - System
+{
+  bool	ret = true;			// Return value
+
+
+  pthread_mutex_lock(&system->status_mutex);
+
+  if (!system->status_running)
+  {
+    system->status_shutdown = false;
+
+    if (pthread_create(&system->status_tid, NULL, (void *(*)(void *))run_status, system))
+    {
+      papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create status thread: %s", strerror(errno));
+      ret = false;
+    }
+    else
+      system->status_running = true;
+  }
+
+  pthread_mutex_unlock(&system->status_mutex);
+
+  return (ret);
+}
+
+
+//
+// '_papplSystemStopStatus()' - Stop the printer status poller.
+//
+// This function waits for any status poll in progress to complete.
+//
+
+void
+_papplSystemStopStatus(
+    pappl_system_t *system)		// I - System
+{
+  pthread_mutex_lock(&system->status_mutex);
+
+  if (!system->status_running)
+  {
+    pthread_mutex_unlock(&system->status_mutex);
+    return;
+  }
+
+  system->status_shutdown = true;
+  pthread_cond_signal(&system->status_cond);
+
+  pthread_mutex_unlock(&system->status_mutex);
+
+  pthread_join(system->status_tid, NULL);
+
+  pthread_mutex_lock(&system->status_mutex);
+  system->status_running = false;
+  pthread_mutex_unlock(&system->status_mutex);
+}
+
+
+//
+// 'poll_status()' - Query the status of a printer and schedule the next poll.
+//
+
+static void
+poll_status(pappl_printer_t *printer,	// I - Printer
+            int             interval)	// I - Seconds between status polls
+{
+  bool			ret;		// Did the status callback succeed?
+  struct timeval	start,		// Start time
+			end;		// End time
+  size_t		usecs;		// Microseconds for status callback
+  time_t		delay;		// Seconds until next poll
+
+
+  gettimeofday(&start, NULL);
+  ret = (printer->driver_data.status)(printer);
+  gettimeofday(&end, NULL);
+
+  usecs = (size_t)(1000000 * (end.tv_sec - start.tv_sec) + end.tv_usec - start.tv_usec);
+
+  pthread_rwlock_wrlock(&printer->rwlock);
+
+  printer->status_polls ++;
+  printer->status_usecs = usecs;
+  if (usecs > printer->status_max_usecs)
+    printer->status_max_usecs = usecs;
+
+  if (ret)
+  {
+    printer->status_time    = end.tv_sec;
+    printer->status_backoff = 0;
+    delay                   = interval;
+  }
+  else
+  {
+    // Back off exponentially while the device isn't responding...
+    printer->status_failures ++;
+    if (printer->status_backoff < 8)
+      printer->status_backoff ++;
+
+    if ((delay = (time_t)interval << printer->status_backoff) > _PAPPL_STATUS_MAX_INTERVAL)
+      delay = _PAPPL_STATUS_MAX_INTERVAL;
+  }
+
+  // Add up to 25% jitter so that printers are not queried in lockstep...
+  delay += (time_t)(_papplGetRand() % (unsigned)(delay / 4 + 1));
+
+  printer->status_next = end.tv_sec + delay;
+
+  pthread_rwlock_unlock(&printer->rwlock);
+
+  if (ret)
+    papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Status updated in %u.%03u seconds.", (unsigned)(usecs / 1000000), (unsigned)((usecs / 1000) % 1000));
+  else
+    papplLogPrinter(printer, PAPPL_LOGLEVEL_WARN, "Unable to update status, retrying in %d seconds.", (int)delay);
+}
+
+
+//
+// 'run_status()' - Poll the status of idle printers.
+//
+
+static void *				// O - Thread exit status
+run_status(pappl_system_t *system)	// I - System
+{
+  _pappl_plist_t	*plist;		// Printer list
+  pappl_printer_t	*printer;	// Current printer
+  int			i,		// Looping var
+			interval;	// Seconds between status polls
+  time_t		curtime,	// Current time
+			next;		// Time of next poll
+  struct timespec	timeout;	// Timeout for condition
+
+
+  pthread_mutex_lock(&system->status_mutex);
+
+  while (!system->status_shutdown)
+  {
+    interval = system->status_interval;
+
+    pthread_mutex_unlock(&system->status_mutex);
+
+    // Poll any printers that are due...
+    curtime = time(NULL);
+    next    = curtime + interval;
+
+    plist = _papplSystemGetPrinters(system);
+
+    for (i = 0; i < plist->num_printers; i ++)
+    {
+      printer = plist->printers[i];
+
+      if (!printer->driver_data.status)
+        continue;
+
+      if (printer->status_next <= curtime)
+      {
+        if (printer->device_in_use || printer->processing_job)
+        {
+          // The driver reports status while the device is in use...
+          pthread_rwlock_wrlock(&printer->rwlock);
+          printer->status_next = curtime + interval;
+          pthread_rwlock_unlock(&printer->rwlock);
+        }
+        else
+          poll_status(printer, interval);
+      }
+
+      if (printer->status_next < next)
+        next = printer->status_next;
+    }
+
+    _papplSystemReleasePrinters(system, plist);
+
+    // Wait until the next poll is due or we are told to stop...
+    pthread_mutex_lock(&system->status_mutex);
+
+    if (!system->status_shutdown && next > time(NULL))
+    {
+      timeout.tv_sec  = next;
+      timeout.tv_nsec = 0;
+
+      pthread_cond_timedwait(&system->status_cond, &system->status_mutex, &timeout);
+    }
+  }
+
+  pthread_mutex_unlock(&system->status_mutex);
+
+  return (NULL);
+}
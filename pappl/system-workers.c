@@ -0,0 +1,427 @@
+//
+// Worker thread pool for the Printer Application Framework
+//
+// Copyright © 2020 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+//
+// Include necessary headers...
+//
+
+#include "pappl-private.h"
+
+
+//
+// Local functions...
+//
+
+static bool	add_work(_pappl_pool_t *pool, _pappl_work_cb_t cb, void *data);
+static void	get_metrics(_pappl_pool_t *pool, pappl_wmetrics_t *metrics);
+static void	*run_worker(_pappl_pool_t *pool);
+static void	stop_pool(_pappl_pool_t *pool);
+
+
+//
+// '_papplSystemAddClientWork()' - Queue a work item for the client worker pool.
+//
+// Client requests are run by a separate pool so that long-running print jobs
+// and pre-RIPs cannot starve the listener of worker threads.
+//
+
+bool					// O - `true` on success, `false` on failure
+_papplSystemAddClientWork(
+    pappl_system_t   *system,		// I - System
+    _pappl_work_cb_t cb,		// I - Work callback
+    void             *data)		// I - Work callback data
+{
+  return (add_work(&system->client_workers, cb, data));
+}
+
+
+//
+// '_papplSystemAddWork()' - Queue a work item for the job worker pool.
+//
+// Work items are run in the order they are queued.  A new worker thread is
+// started when there are more queued items than idle workers and the pool is
+// not yet at its maximum size.
+//
+
+bool					// O - `true` on success, `false` on failure
+_papplSystemAddWork(
+    pappl_system_t   *system,		// I - System
+    _pappl_work_cb_t cb,		// I - Work callback
+    void             *data)		// I - Work callback data
+{
+  return (add_work(&system->job_workers, cb, data));
+}
+
+
+//
+// 'papplSystemGetClientWorkerMetrics()' - Get the client worker pool metrics.
+//
+// The metrics report the size and occupancy of the client worker pool along
+// with the amount of time client requests have spent waiting in the queue for
+// a worker thread, and can be used to size the pool with
+// @link papplSystemSetMaxClientWorkers@.
+//
+
+pappl_wmetrics_t *			// O - Metrics data or `NULL` on error
+papplSystemGetClientWorkerMetrics(
+    pappl_system_t   *system,		// I - System
+    pappl_wmetrics_t *metrics)		// I - Buffer for metrics data
+{
+  if (!system || !metrics)
+    return (NULL);
+
+  get_metrics(&system->client_workers, metrics);
+
+  return (metrics);
+}
+
+
+//
+// 'papplSystemGetMaxClientWorkers()' - Get the maximum number of client worker threads.
+//
+
+int					// O - Maximum number of client worker threads
+papplSystemGetMaxClientWorkers(
+    pappl_system_t *system)		// I - System
+{
+  int	ret = 0;			// Return value
+
+
+  if (system)
+  {
+    pthread_mutex_lock(&system->client_workers.mutex);
+    ret = system->client_workers.max_workers;
+    pthread_mutex_unlock(&system->client_workers.mutex);
+  }
+
+  return (ret);
+}
+
+
+//
+// 'papplSystemGetMaxWorkers()' - Get the maximum number of job worker threads.
+//
+
+int					// O - Maximum number of job worker threads
+papplSystemGetMaxWorkers(
+    pappl_system_t *system)		// I - System
+{
+  int	ret = 0;			// Return value
+
+
+  if (system)
+  {
+    pthread_mutex_lock(&system->job_workers.mutex);
+    ret = system->job_workers.max_workers;
+    pthread_mutex_unlock(&system->job_workers.mutex);
+  }
+
+  return (ret);
+}
+
+
+//
+// 'papplSystemGetWorkerMetrics()' - Get the job worker pool metrics.
+//
+// The metrics report the size and occupancy of the job worker pool along with
+// the amount of time work items (print jobs) have spent waiting in the queue
+// for a worker thread, and can be used to size the pool with
+// @link papplSystemSetMaxWorkers@.
+//
+
+pappl_wmetrics_t *			// O - Metrics data or `NULL` on error
+papplSystemGetWorkerMetrics(
+    pappl_system_t   *system,		// I - System
+    pappl_wmetrics_t *metrics)		// I - Buffer for metrics data
+{
+  if (!system || !metrics)
+    return (NULL);
+
+  get_metrics(&system->job_workers, metrics);
+
+  return (metrics);
+}
+
+
+//
+// '_papplSystemIsSaturated()' - Determine whether the client worker pool is saturated.
+//
+// The client worker pool is saturated when all client worker threads are busy,
+// no more client worker threads can be started, and client requests are
+// waiting in the queue.  Print jobs and pre-RIPs run on the job worker pool and
+// do not count towards saturation.
+//
+
+bool					// O - `true` if saturated, `false` otherwise
+_papplSystemIsSaturated(
+    pappl_system_t *system)		// I - System
+{
+  bool		ret;			// Return value
+  _pappl_pool_t	*pool = &system->client_workers;
+					// Client worker pool
+
+
+  pthread_mutex_lock(&pool->mutex);
+  ret = pool->work_queued > (size_t)pool->idle_workers && pool->num_workers >= pool->max_workers;
+  pthread_mutex_unlock(&pool->mutex);
+
+  return (ret);
+}
+
+
+//
+// 'papplSystemSetMaxClientWorkers()' - Set the maximum number of client worker threads.
+//
+// Client worker threads run HTTP and IPP requests and are started as needed,
+// up to the specified maximum.  Requests received while all client worker
+// threads are busy wait until a client worker thread becomes available.
+//
+// The default maximum number of client worker threads is `16`.
+//
+
+void
+papplSystemSetMaxClientWorkers(
+    pappl_system_t *system,		// I - System
+    int            max_workers)		// I - Maximum number of client worker threads
+{
+  if (system && max_workers > 0)
+  {
+    pthread_mutex_lock(&system->client_workers.mutex);
+    system->client_workers.max_workers = max_workers;
+    pthread_mutex_unlock(&system->client_workers.mutex);
+  }
+}
+
+
+//
+// 'papplSystemSetMaxWorkers()' - Set the maximum number of job worker threads.
+//
+// Job worker threads run print jobs and pre-RIPs and are started as needed, up
+// to the specified maximum.  Work queued while all job worker threads are busy
+// waits until a job worker thread becomes available, so the maximum should be
+// larger than the number of printers.  Client requests are run by a separate
+// pool - see @link papplSystemSetMaxClientWorkers@.
+//
+// The default maximum number of job worker threads is `32`.
+//
+
+void
+papplSystemSetMaxWorkers(
+    pappl_system_t *system,		// I - System
+    int            max_workers)		// I - Maximum number of job worker threads
+{
+  if (system && max_workers > 0)
+  {
+    pthread_mutex_lock(&system->job_workers.mutex);
+    system->job_workers.max_workers = max_workers;
+    pthread_mutex_unlock(&system->job_workers.mutex);
+  }
+}
+
+
+//
+// '_papplSystemStopWorkers()' - Stop all worker threads.
+//
+// This function waits for any busy worker threads to finish their current
+// work item.  Client workers are stopped first since client requests can
+// queue new jobs.
+//
+
+void
+_papplSystemStopWorkers(
+    pappl_system_t *system)		// I - System
+{
+  stop_pool(&system->client_workers);
+  stop_pool(&system->job_workers);
+}
+
+
+//
+// 'add_work()' - Queue a work item for a worker pool.
+//
+
+static bool				// O - `true` on success, `false` on failure
+add_work(_pappl_pool_t    *pool,	// I - Worker pool
+         _pappl_work_cb_t cb,		// I - Work callback
+         void             *data)	// I - Work callback data
+{
+  _pappl_work_t	*work;			// New work item
+  pthread_t	tid;			// Worker thread ID
+
+
+  if ((work = calloc(1, sizeof(_pappl_work_t))) == NULL)
+  {
+    papplLog(pool->system, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for work item: %s", strerror(errno));
+    return (false);
+  }
+
+  work->cb   = cb;
+  work->data = data;
+  gettimeofday(&work->queued, NULL);
+
+  pthread_mutex_lock(&pool->mutex);
+
+  if (pool->work_last)
+    pool->work_last->next = work;
+  else
+    pool->work_first = work;
+
+  pool->work_last = work;
+  pool->work_queued ++;
+
+  if (pool->work_queued > (size_t)pool->idle_workers && pool->num_workers < pool->max_workers)
+  {
+    // Start another worker thread...
+    if (pthread_create(&tid, NULL, (void *(*)(void *))run_worker, pool))
+    {
+      papplLog(pool->system, PAPPL_LOGLEVEL_ERROR, "Unable to create worker thread: %s", strerror(errno));
+
+      if (pool->num_workers == 0)
+      {
+        // No workers to run the work item, remove it from the queue...
+	pool->work_first = pool->work_last = NULL;
+	pool->work_queued = 0;
+
+	pthread_mutex_unlock(&pool->mutex);
+
+	free(work);
+	return (false);
+      }
+    }
+    else
+    {
+      // Detach the worker thread since we never join it...
+      pthread_detach(tid);
+      pool->num_workers ++;
+    }
+  }
+
+  pthread_cond_signal(&pool->cond);
+  pthread_mutex_unlock(&pool->mutex);
+
+  return (true);
+}
+
+
+//
+// 'get_metrics()' - Get the metrics for a worker pool.
+//
+
+static void
+get_metrics(_pappl_pool_t    *pool,	// I - Worker pool
+            pappl_wmetrics_t *metrics)	// I - Buffer for metrics data
+{
+  pthread_mutex_lock(&pool->mutex);
+
+  metrics->max_workers    = pool->max_workers;
+  metrics->num_workers    = pool->num_workers;
+  metrics->busy_workers   = pool->num_workers - pool->idle_workers;
+  metrics->queued         = pool->work_queued;
+  metrics->completed      = pool->work_completed;
+  metrics->wait_msecs     = pool->work_wait_msecs;
+  metrics->max_wait_msecs = pool->work_max_wait_msecs;
+
+  pthread_mutex_unlock(&pool->mutex);
+}
+
+
+//
+// 'run_worker()' - Run queued work items.
+//
+
+static void *				// O - Thread exit status
+run_worker(_pappl_pool_t *pool)		// I - Worker pool
+{
+  _pappl_work_t		*work;		// Current work item
+  struct timeval	curtime;	// Current time
+  size_t		wait_msecs;	// Milliseconds spent in the queue
+
+
+  pthread_mutex_lock(&pool->mutex);
+
+  for (;;)
+  {
+    // Wait for something to do...
+    pool->idle_workers ++;
+
+    while (!pool->work_first && !pool->shutdown)
+      pthread_cond_wait(&pool->cond, &pool->mutex);
+
+    pool->idle_workers --;
+
+    if (pool->shutdown)
+      break;
+
+    // Pull the next work item off the queue...
+    work             = pool->work_first;
+    pool->work_first = work->next;
+
+    if (!pool->work_first)
+      pool->work_last = NULL;
+
+    pool->work_queued --;
+
+    gettimeofday(&curtime, NULL);
+    wait_msecs = (size_t)(1000 * (curtime.tv_sec - work->queued.tv_sec) + (curtime.tv_usec - work->queued.tv_usec) / 1000);
+
+    pool->work_wait_msecs += wait_msecs;
+    if (wait_msecs > pool->work_max_wait_msecs)
+      pool->work_max_wait_msecs = wait_msecs;
+
+    pthread_mutex_unlock(&pool->mutex);
+
+    // Do the work...
+    (work->cb)(work->data);
+    free(work);
+
+    pthread_mutex_lock(&pool->mutex);
+
+    pool->work_completed ++;
+  }
+
+  // Let stop_pool know we are done...
+  pool->num_workers --;
+  pthread_cond_broadcast(&pool->cond);
+
+  pthread_mutex_unlock(&pool->mutex);
+
+  return (NULL);
+}
+
+
+//
+// 'stop_pool()' - Stop the worker threads in a pool.
+//
+
+static void
+stop_pool(_pappl_pool_t *pool)		// I - Worker pool
+{
+  _pappl_work_t	*work;			// Current work item
+
+
+  pthread_mutex_lock(&pool->mutex);
+
+  pool->shutdown = true;
+  pthread_cond_broadcast(&pool->cond);
+
+  while (pool->num_workers > 0)
+    pthread_cond_wait(&pool->cond, &pool->mutex);
+
+  // Free any work items that were never run...
+  while ((work = pool->work_first) != NULL)
+  {
+    pool->work_first = work->next;
+    free(work);
+  }
+
+  pool->work_last   = NULL;
+  pool->work_queued = 0;
+
+  pthread_mutex_unlock(&pool->mutex);
+}
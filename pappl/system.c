@@ -84,7 +84,7 @@ void
 _papplSystemConfigChanged(
     pappl_system_t *system)		// I - System
 {
-  pthread_rwlock_wrlock(&system->rwlock);
+  _papplSystemWRLock(system);
 
   if (system->is_running)
     system->config_changes ++;
@@ -122,6 +122,19 @@ papplSystemCreate(
 
   // Initialize values...
   pthread_rwlock_init(&system->rwlock, NULL);
+  pthread_mutex_init(&system->job_workers.mutex, NULL);
+  pthread_cond_init(&system->job_workers.cond, NULL);
+  pthread_mutex_init(&system->client_workers.mutex, NULL);
+  pthread_cond_init(&system->client_workers.cond, NULL);
+  pthread_mutex_init(&system->status_mutex, NULL);
+  pthread_cond_init(&system->status_cond, NULL);
+  pthread_mutex_init(&system->clients_mutex, NULL);
+  pthread_mutex_init(&system->plist_mutex, NULL);
+  pthread_mutex_init(&system->router_mutex, NULL);
+  pthread_mutex_init(&system->auth_mutex, NULL);
+  pthread_mutex_init(&system->save_mutex, NULL);
+  pthread_cond_init(&system->save_cond, NULL);
+  pthread_mutex_init(&system->save_file_mutex, NULL);
 
   system->options         = options;
   system->start_time      = time(NULL);
@@ -132,16 +145,29 @@ papplSystemCreate(
   system->logfile         = logfile ? strdup(logfile) : NULL;
   system->loglevel        = loglevel;
   system->logmaxsize      = 1024 * 1024;
+  system->compression     = _PAPPL_COMPRESSION;
   system->next_client     = 1;
   system->next_printer_id = 1;
   system->tls_only        = tls_only;
   system->admin_gid       = (gid_t)-1;
+  system->save_interval   = _PAPPL_SAVE_INTERVAL;
+  system->status_interval = _PAPPL_STATUS_INTERVAL;
+  system->clients_fd      = -1;
+  system->max_clients     = _PAPPL_MAX_CLIENTS;
+  system->header_timeout  = _PAPPL_HEADER_TIMEOUT;
+
+  system->job_workers.system         = system;
+  system->job_workers.max_workers    = _PAPPL_MAX_WORKERS;
+  system->client_workers.system      = system;
+  system->client_workers.max_workers = _PAPPL_MAX_CLIENT_WORKERS;
 
   if (subtypes)
     system->subtypes = strdup(subtypes);
   if (auth_service)
     system->auth_service = strdup(auth_service);
 
+  snprintf(system->auth_salt, sizeof(system->auth_salt), "%08x%08x%08x%08x", _papplGetRand(), _papplGetRand(), _papplGetRand(), _papplGetRand());
+
   // Make sure the system name and UUID are initialized...
   papplSystemSetHostname(system, NULL);
   papplSystemSetUUID(system, NULL);
@@ -230,6 +256,7 @@ papplSystemDelete(
   if (!system || system->is_running)
     return;
 
+  _papplSystemStopWorkers(system);
   _papplSystemUnregisterDNSSDNoLock(system);
 
   free(system->uuid);
@@ -251,16 +278,54 @@ papplSystemDelete(
     close(system->listeners[i].fd);
 
   cupsArrayDelete(system->filters);
+  free(system->filter_list);
+  cupsArrayDelete(system->header_clients);
+  cupsArrayDelete(system->addrs);
   cupsArrayDelete(system->links);
-  cupsArrayDelete(system->printers);
-  cupsArrayDelete(system->resources);
+  _papplSystemDeletePrinters(system);
+
+  _papplSystemDeleteResources(system);
 
   pthread_rwlock_destroy(&system->rwlock);
+  pthread_mutex_destroy(&system->job_workers.mutex);
+  pthread_cond_destroy(&system->job_workers.cond);
+  pthread_mutex_destroy(&system->client_workers.mutex);
+  pthread_cond_destroy(&system->client_workers.cond);
+  pthread_mutex_destroy(&system->status_mutex);
+  pthread_cond_destroy(&system->status_cond);
+  pthread_mutex_destroy(&system->clients_mutex);
+  pthread_mutex_destroy(&system->plist_mutex);
+  pthread_mutex_destroy(&system->router_mutex);
+  pthread_mutex_destroy(&system->auth_mutex);
+  pthread_mutex_destroy(&system->save_mutex);
+  pthread_cond_destroy(&system->save_cond);
+  pthread_mutex_destroy(&system->save_file_mutex);
 
   free(system);
 }
 
 
+//
+// '_papplSystemRDLock()' - Lock the system for reading.
+//
+// The number of read locks and the number of times a reader had to wait for
+// a writer are counted for `papplSystemGetLockMetrics`.
+//
+
+void
+_papplSystemRDLock(
+    pappl_system_t *system)		// I - System
+{
+  atomic_fetch_add_explicit(&system->read_locks, 1, memory_order_relaxed);
+
+  if (pthread_rwlock_tryrdlock(&system->rwlock))
+  {
+    atomic_fetch_add_explicit(&system->read_waits, 1, memory_order_relaxed);
+    pthread_rwlock_rdlock(&system->rwlock);
+  }
+}
+
+
 //
 // 'papplSystemRun()' - Run the printer service.
 //
@@ -268,9 +333,6 @@ papplSystemDelete(
 void
 papplSystemRun(pappl_system_t *system)// I - System
 {
-  int			i,		// Looping var
-			count;		// Number of listeners that fired
-  pappl_client_t	*client;	// New client
   char			header[HTTP_MAX_VALUE];
 					// Server: header value
 
@@ -345,10 +407,16 @@ papplSystemRun(pappl_system_t *system)// I - System
   // Start the raw socket listeners as needed...
   if (system->options & PAPPL_SOPTIONS_RAW_SOCKET)
   {
+    _pappl_plist_t	*plist;		// Printer list
+    int			i;		// Looping var
     pappl_printer_t	*printer;	// Current printer
 
-    for (printer = (pappl_printer_t *)cupsArrayFirst(system->printers); printer; printer = (pappl_printer_t *)cupsArrayNext(system->printers))
+    plist = _papplSystemGetPrinters(system);
+
+    for (i = 0; i < plist->num_printers; i ++)
     {
+      printer = plist->printers[i];
+
       if (printer->num_listeners > 0)
       {
 	pthread_t	tid;		// Thread ID
@@ -365,6 +433,23 @@ papplSystemRun(pappl_system_t *system)// I - System
 	}
       }
     }
+
+    _papplSystemReleasePrinters(system, plist);
+  }
+
+  // Start polling printer status in the background...
+  _papplSystemStartStatus(system);
+
+  // Save configuration changes in the background...
+  _papplSystemStartSave(system);
+
+  // Start accepting client connections...
+  if (!_papplSystemStartClients(system))
+  {
+    _papplSystemStopStatus(system);
+    _papplSystemStopSave(system);
+    system->is_running = false;
+    return;
   }
 
   // Loop until we are shutdown or have a hard error...
@@ -376,87 +461,61 @@ papplSystemRun(pappl_system_t *system)// I - System
       _papplLogOpen(system);
     }
 
-    if ((count = poll(system->listeners, (nfds_t)system->num_listeners, 1000)) < 0 && errno != EINTR && errno != EAGAIN)
-    {
-      papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to accept new connections: %s", strerror(errno));
+    // Accept and dispatch client connections...
+    if (!_papplSystemRunClients(system, 1000))
       break;
-    }
-
-    if (count > 0)
-    {
-      // Accept client connections as needed...
-      for (i = 0; i < system->num_listeners; i ++)
-      {
-	if (system->listeners[i].revents & POLLIN)
-	{
-	  if ((client = papplClientCreate(system, system->listeners[i].fd)) != NULL)
-	  {
-	    if (pthread_create(&client->thread_id, NULL, (void *(*)(void *))_papplClientRun, client))
-	    {
-	      // Unable to create client thread...
-	      papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create client thread: %s", strerror(errno));
-	      papplClientDelete(client);
-	    }
-	    else
-	    {
-	      // Detach the main thread from the client thread to prevent hangs...
-	      pthread_detach(client->thread_id);
-	    }
-	  }
-	}
-      }
-    }
 
     if (system->dns_sd_any_collision)
     {
       // Handle name collisions...
-      pappl_printer_t	*printer;	// Current printer
+      _pappl_plist_t	*plist;		// Printer list
+      int		i;		// Looping var
+      bool		renamed;	// Was a service renamed?
+
+      _papplSystemRDLock(system);
 
-      pthread_rwlock_rdlock(&system->rwlock);
+      renamed = system->dns_sd_collision;
 
       if (system->dns_sd_collision)
         _papplSystemRegisterDNSSDNoLock(system);
 
-      for (printer = (pappl_printer_t *)cupsArrayFirst(system->printers); printer; printer = (pappl_printer_t *)cupsArrayNext(system->printers))
+      plist = _papplSystemGetPrinters(system);
+
+      for (i = 0; i < plist->num_printers; i ++)
       {
-        if (printer->dns_sd_collision)
-          _papplPrinterRegisterDNSSDNoLock(printer);
+        if (plist->printers[i]->dns_sd_collision)
+        {
+          _papplPrinterRegisterDNSSDNoLock(plist->printers[i]);
+          renamed = true;
+        }
       }
 
+      _papplSystemReleasePrinters(system, plist);
+
       system->dns_sd_any_collision = false;
       pthread_rwlock_unlock(&system->rwlock);
-    }
-
-    if (system->config_changes > system->save_changes)
-    {
-      system->save_changes = system->config_changes;
 
-      if (system->save_cb)
-      {
-        // Save the configuration...
-	(system->save_cb)(system, system->save_cbdata);
-      }
+      // Save the new service names...
+      if (renamed)
+        _papplSystemConfigChanged(system);
     }
 
     if (system->shutdown_time)
     {
       // Shutdown requested, see if we can do so safely...
-      int		count = 0;	// Number of active jobs
-      pappl_printer_t	*printer;	// Current printer
+      int		i,		// Looping var
+			count = 0;	// Number of active jobs
+      _pappl_plist_t	*plist;		// Printer list
 
       // Force shutdown after 60 seconds
       if ((time(NULL) - system->shutdown_time) > 60)
         break;
 
       // Otherwise shutdown immediately if there are no more active jobs...
-      pthread_rwlock_rdlock(&system->rwlock);
-      for (printer = (pappl_printer_t *)cupsArrayFirst(system->printers); printer; printer = (pappl_printer_t *)cupsArrayNext(system->printers))
-      {
-        pthread_rwlock_rdlock(&printer->rwlock);
-        count += cupsArrayCount(printer->active_jobs);
-        pthread_rwlock_unlock(&printer->rwlock);
-      }
-      pthread_rwlock_unlock(&system->rwlock);
+      plist = _papplSystemGetPrinters(system);
+      for (i = 0; i < plist->num_printers; i ++)
+        count += papplPrinterGetNumberOfActiveJobs(plist->printers[i]);
+      _papplSystemReleasePrinters(system, plist);
 
       if (count == 0)
         break;
@@ -469,11 +528,11 @@ papplSystemRun(pappl_system_t *system)// I - System
 
   papplLog(system, PAPPL_LOGLEVEL_INFO, "Shutting down system.");
 
-  if (system->save_changes < system->config_changes && system->save_cb)
-  {
-    // Save the configuration...
-    (system->save_cb)(system, system->save_cbdata);
-  }
+  _papplSystemStopClients(system);
+  _papplSystemStopStatus(system);
+
+  // Save any remaining changes...
+  _papplSystemStopSave(system);
 
   system->is_running = false;
 }
@@ -518,6 +577,45 @@ _papplSystemMakeUUID(
 }
 
 
+//
+// '_papplSystemStateChanged()' - Mark the system state as changed.
+//
+// This function is used for changes to counters such as the next job ID and
+// number of impressions completed that need to be saved but do not change the
+// configuration or cached attributes.
+//
+
+void
+_papplSystemStateChanged(
+    pappl_system_t *system)		// I - System
+{
+  _papplSystemWRLock(system);
+
+  if (system->is_running)
+    system->state_changes ++;
+
+  pthread_rwlock_unlock(&system->rwlock);
+}
+
+
+//
+// '_papplSystemWRLock()' - Lock the system for writing.
+//
+
+void
+_papplSystemWRLock(
+    pappl_system_t *system)		// I - System
+{
+  atomic_fetch_add_explicit(&system->write_locks, 1, memory_order_relaxed);
+
+  if (pthread_rwlock_trywrlock(&system->rwlock))
+  {
+    atomic_fetch_add_explicit(&system->write_waits, 1, memory_order_relaxed);
+    pthread_rwlock_wrlock(&system->rwlock);
+  }
+}
+
+
 //
 // 'sighup_handler()' - SIGHUP handler
 //
@@ -42,10 +42,31 @@ enum pappl_soptions_e			// System option bits
   PAPPL_SOPTIONS_TLS = 0x0020,			// Include TLS settings page
   PAPPL_SOPTIONS_LOG = 0x0040,			// Include link to log file
   PAPPL_SOPTIONS_DNSSD_HOST = 0x0080,		// Use hostname in DNS-SD service names instead of serial number/UUID
-  PAPPL_SOPTIONS_RAW_SOCKET = 0x0100		// Accept jobs via raw sockets
+  PAPPL_SOPTIONS_RAW_SOCKET = 0x0100,		// Accept jobs via raw sockets
+  PAPPL_SOPTIONS_RASTER_SPOOL = 0x0200		// Spool streamed raster jobs when busy
 };
 typedef unsigned pappl_soptions_t;	// Bitfield for system options
 
+typedef struct pappl_cmetrics_s		// Client connection metrics
+{
+  int		max_clients,			// Maximum number of client connections
+		num_clients;			// Current number of client connections
+  size_t	rejected_clients,		// Number of connections rejected by the global limit
+		rejected_address,		// Number of connections rejected by the per-address limit
+		rejected_rate,			// Number of requests rejected by the per-address rate limit
+		rejected_busy,			// Number of requests rejected while the worker pool was saturated
+		header_timeouts;		// Number of connections closed by the header timeout
+} pappl_cmetrics_t;
+
+typedef struct pappl_lmetrics_s		// System lock metrics
+{
+  size_t	read_locks,			// Number of system read locks
+		read_waits,			// Number of system read locks that had to wait
+		write_locks,			// Number of system write locks
+		write_waits,			// Number of system write locks that had to wait
+		printer_snapshots;		// Number of printer lists published
+} pappl_lmetrics_t;
+
 typedef struct pappl_version_s		// Firmware version information
 {
   char			name[64],		// "xxx-firmware-name" value
@@ -54,6 +75,17 @@ typedef struct pappl_version_s		// Firmware version information
   unsigned short	version[4];		// "xxx-firmware-version" value
 } pappl_version_t;
 
+typedef struct pappl_wmetrics_s		// Worker pool metrics
+{
+  int		max_workers,			// Maximum number of worker threads
+		num_workers,			// Current number of worker threads
+		busy_workers;			// Number of busy worker threads
+  size_t	queued,				// Number of queued work items
+		completed,			// Total number of completed work items
+		wait_msecs,			// Total number of milliseconds work items waited in queue
+		max_wait_msecs;			// Maximum number of milliseconds a work item waited in queue
+} pappl_wmetrics_t;
+
 
 //
 // Callback function types...
@@ -95,27 +127,40 @@ extern void		papplSystemDelete(pappl_system_t *system) _PAPPL_PUBLIC;
 extern pappl_printer_t	*papplSystemFindPrinter(pappl_system_t *system, const char *resource, int printer_id, const char *device_uri) _PAPPL_PUBLIC;
 extern char		*papplSystemGetAdminGroup(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern const char	*papplSystemGetAuthService(pappl_system_t *system) _PAPPL_PUBLIC;
+extern pappl_cmetrics_t	*papplSystemGetClientMetrics(pappl_system_t *system, pappl_cmetrics_t *metrics) _PAPPL_PUBLIC;
+extern pappl_wmetrics_t	*papplSystemGetClientWorkerMetrics(pappl_system_t *system, pappl_wmetrics_t *metrics) _PAPPL_PUBLIC;
+extern size_t		papplSystemGetCompressionThreshold(pappl_system_t *system) _PAPPL_PUBLIC;
 extern pappl_contact_t	*papplSystemGetContact(pappl_system_t *system, pappl_contact_t *contact) _PAPPL_PUBLIC;
 extern int		papplSystemGetDefaultPrinterID(pappl_system_t *system) _PAPPL_PUBLIC;
 extern char		*papplSystemGetDefaultPrintGroup(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern char		*papplSystemGetDNSSDName(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern const char	*papplSystemGetFooterHTML(pappl_system_t *system) _PAPPL_PUBLIC;
 extern char		*papplSystemGetGeoLocation(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
+extern int		papplSystemGetHeaderTimeout(pappl_system_t *system) _PAPPL_PUBLIC;
 extern char		*papplSystemGetHostname(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern char		*papplSystemGetLocation(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
+extern pappl_lmetrics_t	*papplSystemGetLockMetrics(pappl_system_t *system, pappl_lmetrics_t *metrics) _PAPPL_PUBLIC;
 extern pappl_loglevel_t  papplSystemGetLogLevel(pappl_system_t *system) _PAPPL_PUBLIC;
+extern int		papplSystemGetMaxClients(pappl_system_t *system) _PAPPL_PUBLIC;
+extern int		papplSystemGetMaxClientWorkers(pappl_system_t *system) _PAPPL_PUBLIC;
+extern int		papplSystemGetMaxClientsPerAddress(pappl_system_t *system) _PAPPL_PUBLIC;
 extern size_t  papplSystemGetMaxLogSize(pappl_system_t *system) _PAPPL_PUBLIC;
+extern int		papplSystemGetMaxWorkers(pappl_system_t *system) _PAPPL_PUBLIC;
 extern char		*papplSystemGetName(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern int		papplSystemGetNextPrinterID(pappl_system_t *system) _PAPPL_PUBLIC;
 extern pappl_soptions_t	papplSystemGetOptions(pappl_system_t *system) _PAPPL_PUBLIC;
 extern char		*papplSystemGetOrganization(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern char		*papplSystemGetOrganizationalUnit(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern char		*papplSystemGetPassword(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
+extern int		papplSystemGetRequestRate(pappl_system_t *system, int *burst) _PAPPL_PUBLIC;
 extern const char	*papplSystemGetServerHeader(pappl_system_t *system) _PAPPL_PUBLIC;
+extern int		papplSystemGetSaveInterval(pappl_system_t *system) _PAPPL_PUBLIC;
 extern char		*papplSystemGetSessionKey(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
+extern int		papplSystemGetStatusInterval(pappl_system_t *system) _PAPPL_PUBLIC;
 extern bool		papplSystemGetTLSOnly(pappl_system_t *system) _PAPPL_PUBLIC;
 extern const char	*papplSystemGetUUID(pappl_system_t *system) _PAPPL_PUBLIC;
 extern int		papplSystemGetVersions(pappl_system_t *system, int max_versions, pappl_version_t *versions) _PAPPL_PUBLIC;
+extern pappl_wmetrics_t	*papplSystemGetWorkerMetrics(pappl_system_t *system, pappl_wmetrics_t *metrics) _PAPPL_PUBLIC;
 extern char		*papplSystemHashPassword(pappl_system_t *system, const char *salt, const char *password, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern bool		papplSystemIsRunning(pappl_system_t *system) _PAPPL_PUBLIC;
 extern void		papplSystemIteratePrinters(pappl_system_t *system, pappl_printer_cb_t cb, void *data) _PAPPL_PUBLIC;
@@ -125,16 +170,22 @@ extern void		papplSystemRun(pappl_system_t *system) _PAPPL_PUBLIC;
 extern bool		papplSystemSaveState(pappl_system_t *system, const char *filename) _PAPPL_PUBLIC;
 
 extern void		papplSystemSetAdminGroup(pappl_system_t *system, const char *value) _PAPPL_PUBLIC;
+extern void		papplSystemSetCompressionThreshold(pappl_system_t *system, size_t threshold) _PAPPL_PUBLIC;
 extern void		papplSystemSetContact(pappl_system_t *system, pappl_contact_t *contact) _PAPPL_PUBLIC;
 extern void		papplSystemSetDefaultPrinterID(pappl_system_t *system, int default_printer_id) _PAPPL_PUBLIC;
 extern void		papplSystemSetDefaultPrintGroup(pappl_system_t *system, const char *value) _PAPPL_PUBLIC;
 extern void		papplSystemSetDNSSDName(pappl_system_t *system, const char *value) _PAPPL_PUBLIC;
 extern void		papplSystemSetFooterHTML(pappl_system_t *system, const char *html) _PAPPL_PUBLIC;
 extern void		papplSystemSetGeoLocation(pappl_system_t *system, const char *value) _PAPPL_PUBLIC;
+extern void		papplSystemSetHeaderTimeout(pappl_system_t *system, int timeout) _PAPPL_PUBLIC;
 extern void		papplSystemSetHostname(pappl_system_t *system, const char *value) _PAPPL_PUBLIC;
 extern void		papplSystemSetLocation(pappl_system_t *system, const char *value) _PAPPL_PUBLIC;
 extern void		papplSystemSetLogLevel(pappl_system_t *system, pappl_loglevel_t loglevel) _PAPPL_PUBLIC;
+extern void		papplSystemSetMaxClients(pappl_system_t *system, int max_clients) _PAPPL_PUBLIC;
+extern void		papplSystemSetMaxClientWorkers(pappl_system_t *system, int max_workers) _PAPPL_PUBLIC;
+extern void		papplSystemSetMaxClientsPerAddress(pappl_system_t *system, int max_clients) _PAPPL_PUBLIC;
 extern void		papplSystemSetMaxLogSize(pappl_system_t *system, size_t maxSize) _PAPPL_PUBLIC;
+extern void		papplSystemSetMaxWorkers(pappl_system_t *system, int max_workers) _PAPPL_PUBLIC;
 extern void		papplSystemSetMIMECallback(pappl_system_t *system, pappl_mime_cb_t cb, void *data) _PAPPL_PUBLIC;
 extern void		papplSystemSetNextPrinterID(pappl_system_t *system, int next_printer_id) _PAPPL_PUBLIC;
 extern void		papplSystemSetOperationCallback(pappl_system_t *system, pappl_ipp_op_cb_t cb, void *data) _PAPPL_PUBLIC;
@@ -142,7 +193,10 @@ extern void		papplSystemSetOrganization(pappl_system_t *system, const char *valu
 extern void		papplSystemSetOrganizationalUnit(pappl_system_t *system, const char *value) _PAPPL_PUBLIC;
 extern void		papplSystemSetPassword(pappl_system_t *system, const char *hash) _PAPPL_PUBLIC;
 extern void		papplSystemSetPrintDrivers(pappl_system_t *system, int num_names, const char * const *names, const char * const *desc, pappl_pdriver_cb_t cb, void *data) _PAPPL_PUBLIC;
+extern void		papplSystemSetRequestRate(pappl_system_t *system, int rate, int burst) _PAPPL_PUBLIC;
 extern void		papplSystemSetSaveCallback(pappl_system_t *system, pappl_save_cb_t cb, void *data) _PAPPL_PUBLIC;
+extern void		papplSystemSetSaveInterval(pappl_system_t *system, int interval) _PAPPL_PUBLIC;
+extern void		papplSystemSetStatusInterval(pappl_system_t *system, int interval) _PAPPL_PUBLIC;
 extern void		papplSystemSetUUID(pappl_system_t *system, const char *value) _PAPPL_PUBLIC;
 extern void		papplSystemSetVersions(pappl_system_t *system, int num_versions, pappl_version_t *versions) _PAPPL_PUBLIC;
 extern void		papplSystemShutdown(pappl_system_t *system) _PAPPL_PUBLIC;
@@ -17,11 +17,763 @@
 #endif // HAVE_SYS_RANDOM_H
 
 
+//
+// Local globals...
+//
+
+#define _PAPPL_RA_HASH	1024		// Size of attribute name hash table
+
+static const char * const ra_names[_PAPPL_RA_NAMES] =
+{					// Known attribute names
+  // Names with a _pappl_raname_t constant, in the same order...
+  "copies",
+  "date-time-at-completed",
+  "date-time-at-creation",
+  "date-time-at-processing",
+  "document-format",
+  "document-name",
+  "job-hold-until",
+  "job-id",
+  "job-impressions",
+  "job-impressions-completed",
+  "job-name",
+  "job-originating-user-name",
+  "job-printer-up-time",
+  "job-printer-uri",
+  "job-priority",
+  "job-state",
+  "job-state-message",
+  "job-state-reasons",
+  "job-uri",
+  "job-uuid",
+  "marker-colors",
+  "marker-high-levels",
+  "marker-levels",
+  "marker-low-levels",
+  "marker-names",
+  "marker-types",
+  "media",
+  "media-col",
+  "media-col-database",
+  "multiple-document-handling",
+  "orientation-requested",
+  "output-bin",
+  "print-color-mode",
+  "print-content-optimize",
+  "print-darkness",
+  "print-quality",
+  "print-scaling",
+  "print-speed",
+  "printer-creation-attributes-supported",
+  "printer-current-time",
+  "printer-firmware-name",
+  "printer-firmware-patches",
+  "printer-firmware-string-version",
+  "printer-firmware-version",
+  "printer-icons",
+  "printer-id",
+  "printer-impressions-completed",
+  "printer-is-accepting-jobs",
+  "printer-more-info",
+  "printer-resolution",
+  "printer-state",
+  "printer-state-change-date-time",
+  "printer-state-change-time",
+  "printer-state-message",
+  "printer-state-reasons",
+  "printer-strings-uri",
+  "printer-supply",
+  "printer-supply-description",
+  "printer-supply-info-uri",
+  "printer-up-time",
+  "printer-uri-supported",
+  "printer-uuid",
+  "printer-xri-supported",
+  "queued-job-count",
+  "sides",
+  "smi2699-device-command-supported",
+  "smi2699-device-uri-schemes-supported",
+  "system-config-change-date-time",
+  "system-config-change-time",
+  "system-configured-printers",
+  "system-contact-col",
+  "system-current-time",
+  "system-default-printer-id",
+  "system-firmware-name",
+  "system-firmware-patches",
+  "system-firmware-string-version",
+  "system-firmware-version",
+  "system-geo-location",
+  "system-location",
+  "system-mandatory-printer-attributes",
+  "system-organization",
+  "system-organizational-unit",
+  "system-settable-attributes-supported",
+  "system-state",
+  "system-state-change-date-time",
+  "system-state-change-time",
+  "system-state-reasons",
+  "system-up-time",
+  "time-at-completed",
+  "time-at-creation",
+  "time-at-processing",
+  "uri-authentication-supported",
+
+  // All other attribute names stored by PAPPL or listed in the groups that
+  // ippCreateRequestedArray expands ("all", "job-template",
+  // "printer-description", etc.), so that requests for the standard groups
+  // don't need to search the requested attributes array...
+  "auth-info-required",
+  "chamber-humidity-current",
+  "chamber-temperature-current",
+  "charset-configured",
+  "charset-supported",
+  "color-supported",
+  "compression-supplied",
+  "compression-supported",
+  "confirmation-sheet-print",
+  "confirmation-sheet-print-default",
+  "confirmation-sheet-print-supported",
+  "copies-actual",
+  "copies-default",
+  "copies-supported",
+  "cover-back",
+  "cover-back-actual",
+  "cover-back-default",
+  "cover-back-supported",
+  "cover-front",
+  "cover-front-actual",
+  "cover-front-default",
+  "cover-front-supported",
+  "cover-sheet-info",
+  "cover-sheet-info-default",
+  "cover-sheet-info-supported",
+  "current-page-order",
+  "destination-statuses",
+  "destination-uris",
+  "destination-uris-default",
+  "destination-uris-supported",
+  "device-service-count",
+  "device-uri",
+  "device-uuid",
+  "document-access-errors",
+  "document-charset",
+  "document-charset-default",
+  "document-charset-supplied",
+  "document-charset-supported",
+  "document-creation-attributes-supported",
+  "document-digital-signature",
+  "document-digital-signature-default",
+  "document-digital-signature-supplied",
+  "document-digital-signature-supported",
+  "document-format-default",
+  "document-format-details",
+  "document-format-details-default",
+  "document-format-details-supplied",
+  "document-format-details-supported",
+  "document-format-detected",
+  "document-format-supplied",
+  "document-format-supported",
+  "document-format-varying-attributes",
+  "document-format-version",
+  "document-format-version-default",
+  "document-format-version-detected",
+  "document-format-version-supported",
+  "document-job-id",
+  "document-job-uri",
+  "document-message",
+  "document-message-supplied",
+  "document-metadata",
+  "document-name-supplied",
+  "document-natural-language",
+  "document-natural-language-default",
+  "document-natural-language-supplied",
+  "document-natural-language-supported",
+  "document-number",
+  "document-overrides-actual",
+  "document-password-supported",
+  "document-printer-uri",
+  "document-privacy-attributes",
+  "document-privacy-scope",
+  "document-state",
+  "document-state-message",
+  "document-state-reasons",
+  "document-uri",
+  "document-uuid",
+  "errors-count",
+  "feed-orientation",
+  "feed-orientation-default",
+  "feed-orientation-supported",
+  "finishing-col-database",
+  "finishing-col-default",
+  "finishing-col-supported",
+  "finishing-template-supported",
+  "finishings",
+  "finishings-actual",
+  "finishings-col",
+  "finishings-col-actual",
+  "finishings-col-database",
+  "finishings-col-default",
+  "finishings-col-ready",
+  "finishings-col-supported",
+  "finishings-default",
+  "finishings-ready",
+  "finishings-supported",
+  "font-name-requested",
+  "font-name-requested-default",
+  "font-name-requested-supported",
+  "font-size-requested",
+  "font-size-requested-default",
+  "font-size-requested-supported",
+  "force-front-side",
+  "force-front-side-actual",
+  "force-front-side-default",
+  "force-front-side-supported",
+  "generated-natural-language-supported",
+  "identify-actions-default",
+  "identify-actions-supported",
+  "imposition-template",
+  "imposition-template-actual",
+  "imposition-template-default",
+  "imposition-template-supported",
+  "impressions",
+  "impressions-completed",
+  "impressions-completed-current-copy",
+  "input-source-supported",
+  "insert-sheet",
+  "insert-sheet-actual",
+  "insert-sheet-default",
+  "insert-sheet-supported",
+  "ipp-features-supported",
+  "ipp-versions-supported",
+  "ippget-event-life",
+  "job-account-id",
+  "job-account-id-actual",
+  "job-account-id-default",
+  "job-account-id-supported",
+  "job-accounting-sheets",
+  "job-accounting-sheets-actual",
+  "job-accounting-sheets-default",
+  "job-accounting-sheets-supported",
+  "job-accounting-user-id",
+  "job-accounting-user-id-actual",
+  "job-accounting-user-id-default",
+  "job-accounting-user-id-supported",
+  "job-attribute-fidelity",
+  "job-authorization-uri-supported",
+  "job-charge-info",
+  "job-collation-type",
+  "job-collation-type-actual",
+  "job-constraints-supported",
+  "job-copies",
+  "job-copies-actual",
+  "job-copies-default",
+  "job-copies-supported",
+  "job-cover-back",
+  "job-cover-back-actual",
+  "job-cover-back-default",
+  "job-cover-back-supported",
+  "job-cover-front",
+  "job-cover-front-actual",
+  "job-cover-front-default",
+  "job-cover-front-supported",
+  "job-creation-attributes-supported",
+  "job-delay-output-until",
+  "job-delay-output-until-default",
+  "job-delay-output-until-supported",
+  "job-delay-output-until-time",
+  "job-delay-output-until-time-default",
+  "job-delay-output-until-time-supported",
+  "job-detailed-status-message",
+  "job-document-access-errors",
+  "job-error-action",
+  "job-error-action-default",
+  "job-error-action-supported",
+  "job-error-sheet",
+  "job-error-sheet-actual",
+  "job-error-sheet-default",
+  "job-error-sheet-supported",
+  "job-finishings",
+  "job-finishings-actual",
+  "job-finishings-col",
+  "job-finishings-col-actual",
+  "job-finishings-col-default",
+  "job-finishings-col-ready",
+  "job-finishings-col-supported",
+  "job-finishings-default",
+  "job-finishings-ready",
+  "job-finishings-supported",
+  "job-hold-until-actual",
+  "job-hold-until-default",
+  "job-hold-until-supported",
+  "job-hold-until-time",
+  "job-hold-until-time-default",
+  "job-hold-until-time-supported",
+  "job-ids-supported",
+  "job-impressions-col",
+  "job-impressions-completed-col",
+  "job-impressions-supported",
+  "job-k-limit",
+  "job-k-octets",
+  "job-k-octets-processed",
+  "job-k-octets-supported",
+  "job-mandatory-attributes",
+  "job-media-progress",
+  "job-media-sheets",
+  "job-media-sheets-col",
+  "job-media-sheets-completed",
+  "job-media-sheets-completed-col",
+  "job-media-sheets-supported",
+  "job-message-from-operator",
+  "job-message-to-operator",
+  "job-message-to-operator-default",
+  "job-message-to-operator-supported",
+  "job-more-info",
+  "job-originating-user-uri",
+  "job-page-limit",
+  "job-pages",
+  "job-pages-col",
+  "job-pages-completed",
+  "job-pages-completed-col",
+  "job-pages-completed-current-copy",
+  "job-password-encryption-supported",
+  "job-password-length-supported",
+  "job-password-repertoire-configured",
+  "job-password-repertoire-supported",
+  "job-password-supported",
+  "job-phone-number",
+  "job-phone-number-default",
+  "job-phone-number-supported",
+  "job-presets-supported",
+  "job-printer-state-message",
+  "job-printer-state-reasons",
+  "job-priority-actual",
+  "job-priority-default",
+  "job-priority-supported",
+  "job-privacy-attributes",
+  "job-privacy-scope",
+  "job-quota-period",
+  "job-recipient-name",
+  "job-recipient-name-default",
+  "job-recipient-name-supported",
+  "job-release-action-default",
+  "job-release-action-supported",
+  "job-resolvers-supported",
+  "job-retain-until",
+  "job-retain-until-default",
+  "job-retain-until-interval",
+  "job-retain-until-interval-default",
+  "job-retain-until-interval-supported",
+  "job-retain-until-supported",
+  "job-retain-until-time",
+  "job-retain-until-time-default",
+  "job-retain-until-time-supported",
+  "job-save-disposition",
+  "job-save-disposition-default",
+  "job-save-disposition-supported",
+  "job-save-printer-make-and-model",
+  "job-settable-attributes-supported",
+  "job-sheet-message",
+  "job-sheet-message-actual",
+  "job-sheet-message-default",
+  "job-sheet-message-supported",
+  "job-sheets",
+  "job-sheets-actual",
+  "job-sheets-col",
+  "job-sheets-col-actual",
+  "job-sheets-col-default",
+  "job-sheets-col-supported",
+  "job-sheets-default",
+  "job-sheets-supported",
+  "job-spooling-supported",
+  "job-triggers-supported",
+  "jpeg-features-supported",
+  "jpeg-k-octets-supported",
+  "jpeg-x-dimension-supported",
+  "jpeg-y-dimension-supported",
+  "k-octets",
+  "k-octets-processed",
+  "label-mode-configured",
+  "label-mode-supported",
+  "label-tear-offset-configured",
+  "label-tear-offset-supported",
+  "landscape-orientation-requested-preferred",
+  "last-document",
+  "marker-change-time",
+  "marker-message",
+  "materials-col",
+  "materials-col-actual",
+  "materials-col-database",
+  "materials-col-default",
+  "materials-col-ready",
+  "materials-col-supported",
+  "max-page-ranges-supported",
+  "media-actual",
+  "media-bottom-margin-supported",
+  "media-check-input-tray-actual",
+  "media-col-actual",
+  "media-col-default",
+  "media-col-ready",
+  "media-col-supported",
+  "media-default",
+  "media-input-tray-check",
+  "media-input-tray-check-default",
+  "media-input-tray-check-supported",
+  "media-left-margin-supported",
+  "media-left-offset-supported",
+  "media-ready",
+  "media-right-margin-supported",
+  "media-sheets",
+  "media-sheets-completed",
+  "media-size-supported",
+  "media-source-supported",
+  "media-supported",
+  "media-top-margin-supported",
+  "media-top-offset-supported",
+  "media-tracking-supported",
+  "media-type-supported",
+  "member-names",
+  "member-uris",
+  "mopria-certified",
+  "more-info",
+  "multiple-destination-uris-supported",
+  "multiple-document-handling-actual",
+  "multiple-document-handling-default",
+  "multiple-document-handling-supported",
+  "multiple-document-jobs-supported",
+  "multiple-object-handling",
+  "multiple-object-handling-actual",
+  "multiple-object-handling-default",
+  "multiple-object-handling-supported",
+  "multiple-operation-time-out",
+  "multiple-operation-time-out-action",
+  "natural-language-configured",
+  "notify-attributes",
+  "notify-attributes-supported",
+  "notify-charset",
+  "notify-events",
+  "notify-events-default",
+  "notify-events-supported",
+  "notify-job-id",
+  "notify-lease-duration",
+  "notify-lease-duration-default",
+  "notify-lease-duration-supported",
+  "notify-lease-expiration-time",
+  "notify-max-events-supported",
+  "notify-natural-language",
+  "notify-printer-up-time",
+  "notify-printer-uri",
+  "notify-pull-method",
+  "notify-pull-method-supported",
+  "notify-recipient-uri",
+  "notify-schemes-supported",
+  "notify-sequence-number",
+  "notify-status-code",
+  "notify-subscriber-user-name",
+  "notify-subscriber-user-uri",
+  "notify-subscription-id",
+  "notify-subscription-uuid",
+  "notify-system-up-time",
+  "notify-system-uri",
+  "notify-time-interval",
+  "notify-user-data",
+  "number-of-documents",
+  "number-of-intervening-jobs",
+  "number-of-retries",
+  "number-of-retries-default",
+  "number-of-retries-supported",
+  "number-up",
+  "number-up-actual",
+  "number-up-default",
+  "number-up-supported",
+  "operations-supported",
+  "orientation-requested-actual",
+  "orientation-requested-default",
+  "orientation-requested-supported",
+  "original-requesting-user-name",
+  "output-bin-actual",
+  "output-bin-default",
+  "output-bin-supported",
+  "output-device",
+  "output-device-assigned",
+  "output-device-default",
+  "output-device-document-state",
+  "output-device-supported",
+  "overrides",
+  "overrides-actual",
+  "overrides-default",
+  "overrides-supported",
+  "page-delivery",
+  "page-delivery-actual",
+  "page-delivery-default",
+  "page-delivery-supported",
+  "page-order-received",
+  "page-order-received-actual",
+  "page-order-received-default",
+  "page-order-received-supported",
+  "page-ranges",
+  "page-ranges-actual",
+  "page-ranges-default",
+  "page-ranges-supported",
+  "pages",
+  "pages-completed",
+  "pages-completed-current-copy",
+  "pages-per-minute",
+  "pages-per-minute-color",
+  "pages-per-subset",
+  "pages-per-subset-default",
+  "pages-per-subset-supported",
+  "pclm-raster-back-side",
+  "pclm-source-resolution",
+  "pclm-source-resolution-default",
+  "pclm-source-resolution-supported",
+  "pclm-strip-height-preferred",
+  "pclm-strip-height-supported",
+  "pdf-features-supported",
+  "pdf-k-octets-supported",
+  "pdf-versions-supported",
+  "pdl-init-file",
+  "pdl-init-file-default",
+  "pdl-init-file-supported",
+  "pdl-override-supported",
+  "platform-shape",
+  "platform-temperature",
+  "platform-temperature-actual",
+  "platform-temperature-default",
+  "platform-temperature-supported",
+  "port-monitor",
+  "port-monitor-supported",
+  "power-calendar-policy-col",
+  "power-event-policy-col",
+  "power-state-capabilities",
+  "power-state-counters",
+  "power-state-monitor",
+  "power-state-transitions",
+  "power-timeout-policy-col",
+  "preferred-attributes-supported",
+  "presentation-direction-number-up",
+  "presentation-direction-number-up-actual",
+  "presentation-direction-number-up-default",
+  "presentation-direction-number-up-supported",
+  "print-accuracy",
+  "print-accuracy-actual",
+  "print-accuracy-default",
+  "print-accuracy-supported",
+  "print-base",
+  "print-base-actual",
+  "print-base-default",
+  "print-base-supported",
+  "print-color-mode-actual",
+  "print-color-mode-default",
+  "print-color-mode-supported",
+  "print-content-optimize-actual",
+  "print-content-optimize-default",
+  "print-content-optimize-supported",
+  "print-darkness-default",
+  "print-darkness-supported",
+  "print-objects",
+  "print-objects-actual",
+  "print-objects-default",
+  "print-objects-supported",
+  "print-quality-actual",
+  "print-quality-default",
+  "print-quality-supported",
+  "print-rendering-intent",
+  "print-rendering-intent-actual",
+  "print-rendering-intent-default",
+  "print-rendering-intent-supported",
+  "print-scaling-actual",
+  "print-scaling-default",
+  "print-scaling-supported",
+  "print-speed-default",
+  "print-speed-supported",
+  "print-supports",
+  "print-supports-actual",
+  "print-supports-default",
+  "print-supports-supported",
+  "printer-alert",
+  "printer-alert-description",
+  "printer-camera-image-uri",
+  "printer-charge-info",
+  "printer-charge-info-uri",
+  "printer-commands",
+  "printer-config-change-date-time",
+  "printer-config-change-time",
+  "printer-config-changes",
+  "printer-contact-col",
+  "printer-darkness-configured",
+  "printer-darkness-supported",
+  "printer-detailed-status-messages",
+  "printer-device-id",
+  "printer-dns-sd-name",
+  "printer-driver-installer",
+  "printer-fax-log-uri",
+  "printer-fax-modem-info",
+  "printer-fax-modem-name",
+  "printer-fax-modem-number",
+  "printer-finisher",
+  "printer-finisher-description",
+  "printer-finisher-supplies",
+  "printer-finisher-supplies-description",
+  "printer-geo-location",
+  "printer-get-attributes-supported",
+  "printer-icc-profiles",
+  "printer-info",
+  "printer-input-tray",
+  "printer-is-shared",
+  "printer-is-temporary",
+  "printer-kind",
+  "printer-location",
+  "printer-make-and-model",
+  "printer-mandatory-job-attributes",
+  "printer-message-date-time",
+  "printer-message-from-operator",
+  "printer-message-time",
+  "printer-more-info-manufacturer",
+  "printer-name",
+  "printer-organization",
+  "printer-organizational-unit",
+  "printer-output-tray",
+  "printer-pkcs7-certificate",
+  "printer-privacy-policy-uri",
+  "printer-resolution-actual",
+  "printer-resolution-default",
+  "printer-resolution-supported",
+  "printer-service-type",
+  "printer-settable-attributes",
+  "printer-settable-attributes-supported",
+  "printer-speed-default",
+  "printer-static-resource-directory-uri",
+  "printer-static-resource-k-octets-free",
+  "printer-static-resource-k-octets-supported",
+  "printer-strings-languages-supported",
+  "printer-type",
+  "printer-uri",
+  "printer-wifi-password",
+  "printer-wifi-ssid",
+  "proof-print",
+  "proof-print-default",
+  "proof-print-supported",
+  "punching-hole-diameter-configured",
+  "punching-locations-supported",
+  "punching-offset-supported",
+  "punching-reference-edge-supported",
+  "pwg-raster-document-resolution-supported",
+  "pwg-raster-document-sheet-back",
+  "pwg-raster-document-type-supported",
+  "reference-uri-schemes-supported",
+  "repertoire-supported",
+  "requesting-user-name-allowed",
+  "requesting-user-name-denied",
+  "requesting-user-uri-supported",
+  "resource-format-supported",
+  "resource-settable-attributes-supported",
+  "resource-type-supported",
+  "retry-interval",
+  "retry-interval-default",
+  "retry-interval-supported",
+  "retry-time-out",
+  "retry-time-out-default",
+  "retry-time-out-supported",
+  "separator-sheets",
+  "separator-sheets-actual",
+  "separator-sheets-default",
+  "separator-sheets-supported",
+  "sheet-collate",
+  "sheet-collate-actual",
+  "sheet-collate-default",
+  "sheet-collate-supported",
+  "sheet-completed-copy-number",
+  "sides-actual",
+  "sides-default",
+  "sides-supported",
+  "smi2699-auth-print-group",
+  "smi2699-auth-proxy-group",
+  "smi2699-device-command",
+  "smi2699-device-format",
+  "smi2699-device-name",
+  "smi2699-device-uri",
+  "subordinate-printers-supported",
+  "subscription-privacy-attributes",
+  "subscription-privacy-scope",
+  "system-config-changes",
+  "system-configured-resources",
+  "system-device-id",
+  "system-impressions-completed",
+  "system-impressions-completed-col",
+  "system-info",
+  "system-make-and-model",
+  "system-mandatory-registration-attributes",
+  "system-message-from-operator",
+  "system-name",
+  "system-owner-col",
+  "system-serial-number",
+  "system-state-message",
+  "system-strings-languages-supported",
+  "system-strings-uri",
+  "system-time-source-configured",
+  "system-uri",
+  "system-uuid",
+  "system-xri-supported",
+  "trimming-offset-supported",
+  "trimming-reference-edge-supported",
+  "trimming-type-supported",
+  "trimming-when-supported",
+  "urf-supported",
+  "uri-security-supported",
+  "warnings-count",
+  "which-jobs-supported",
+  "x-image-position",
+  "x-image-position-actual",
+  "x-image-position-default",
+  "x-image-position-supported",
+  "x-image-shift",
+  "x-image-shift-actual",
+  "x-image-shift-default",
+  "x-image-shift-supported",
+  "x-side1-image-shift",
+  "x-side1-image-shift-actual",
+  "x-side1-image-shift-default",
+  "x-side1-image-shift-supported",
+  "x-side2-image-shift",
+  "x-side2-image-shift-actual",
+  "x-side2-image-shift-default",
+  "x-side2-image-shift-supported",
+  "xri-authentication-supported",
+  "xri-security-supported",
+  "xri-uri-scheme-supported",
+  "y-image-position",
+  "y-image-position-actual",
+  "y-image-position-default",
+  "y-image-position-supported",
+  "y-image-shift",
+  "y-image-shift-actual",
+  "y-image-shift-default",
+  "y-image-shift-supported",
+  "y-side1-image-shift",
+  "y-side1-image-shift-actual",
+  "y-side1-image-shift-default",
+  "y-side1-image-shift-supported",
+  "y-side2-image-shift",
+  "y-side2-image-shift-actual",
+  "y-side2-image-shift-default",
+  "y-side2-image-shift-supported"
+};
+static pthread_once_t	ra_once = PTHREAD_ONCE_INIT;
+					// One-time initialization
+static short		ra_hash[_PAPPL_RA_HASH],
+					// First name in each bucket, plus 1
+			ra_next[_PAPPL_RA_NAMES];
+					// Next name in bucket, plus 1
+
+
 //
 // Local functions...
 //
 
 static int	filter_cb(_pappl_ipp_filter_t *filter, ipp_t *dst, ipp_attribute_t *attr);
+static void	ra_init(void);
+static int	ra_lookup(const char *name);
 
 
 //
@@ -60,7 +812,7 @@ void
 _papplCopyAttributes(
     ipp_t        *to,			// I - Destination request
     ipp_t        *from,			// I - Source request
-    cups_array_t *ra,			// I - Requested attributes
+    _pappl_ra_t  *ra,			// I - Requested attributes
     ipp_tag_t    group_tag,		// I - Group to copy
     int          quickcopy)		// I - Do a quick copy?
 {
@@ -116,6 +868,116 @@ _papplGetRand(void)
 }
 
 
+//
+// '_papplHashString()' - Compute the FNV-1a hash of a string.
+//
+// Hashes of a string prefix can be extended one character at a time with the
+// `_PAPPL_HASH_STEP` macro, starting from `_PAPPL_HASH_INIT`.
+//
+
+unsigned				// O - Hash value
+_papplHashString(const char *s,		// I - String
+                 size_t     *slen)	// O - Length of string or `NULL`
+{
+  unsigned	hash = _PAPPL_HASH_INIT;// Hash value
+  const char	*ptr;			// Pointer into string
+
+
+  for (ptr = s; *ptr; ptr ++)
+    hash = _PAPPL_HASH_STEP(hash, *ptr);
+
+  if (slen)
+    *slen = (size_t)(ptr - s);
+
+  return (hash);
+}
+
+
+//
+// '_papplRACreate()' - Compile a requested attributes array.
+//
+// The array (typically from `ippCreateRequestedArray`) is owned by the
+// returned object and is freed by @link _papplRADelete@.  `NULL` is returned
+// when all attributes are requested.
+//
+// Known attribute names are recorded in a bitmap so that each inclusion test
+// with the `_PAPPL_REQUESTED` macro is a single bit lookup.
+//
+
+_pappl_ra_t *				// O - Requested attributes or `NULL` for all
+_papplRACreate(cups_array_t *array)	// I - Requested attributes array
+{
+  _pappl_ra_t	*ra;			// Requested attributes
+  const char	*name;			// Current attribute name
+  int		index;			// Known attribute index
+
+
+  if (!array)
+    return (NULL);
+
+  if ((ra = (_pappl_ra_t *)calloc(1, sizeof(_pappl_ra_t))) == NULL)
+  {
+    cupsArrayDelete(array);
+    return (NULL);
+  }
+
+  pthread_once(&ra_once, ra_init);
+
+  ra->array = array;
+
+  for (name = (const char *)cupsArrayFirst(array); name; name = (const char *)cupsArrayNext(array))
+  {
+    if ((index = ra_lookup(name)) >= 0)
+      ra->bits[index / 32] |= 1U << (index & 31);
+    else
+      ra->unknown = true;
+  }
+
+  return (ra);
+}
+
+
+//
+// '_papplRADelete()' - Free compiled requested attributes.
+//
+
+void
+_papplRADelete(_pappl_ra_t *ra)		// I - Requested attributes
+{
+  if (ra)
+  {
+    cupsArrayDelete(ra->array);
+    free(ra);
+  }
+}
+
+
+//
+// '_papplRAFind()' - Determine whether an attribute was requested.
+//
+// Use the `_PAPPL_REQUESTED` macro for attribute names with a constant in the
+// known attribute name table.
+//
+
+bool					// O - `true` if requested, `false` otherwise
+_papplRAFind(_pappl_ra_t *ra,		// I - Requested attributes or `NULL` for all
+             const char  *name)		// I - Attribute name
+{
+  int	index;				// Known attribute index
+
+
+  if (!ra)
+    return (true);
+
+  if ((index = ra_lookup(name)) >= 0)
+    return (_PAPPL_REQUESTED(ra, index) != 0);
+  else if (ra->unknown)
+    return (cupsArrayFind(ra->array, (void *)name) != NULL);
+  else
+    return (false);
+}
+
+
 //
 // 'filter_cb()' - Filter printer attributes based on the requested array.
 //
@@ -133,8 +995,51 @@ filter_cb(_pappl_ipp_filter_t *filter,	// I - Filter parameters
   ipp_tag_t group = ippGetGroupTag(attr);
   const char *name = ippGetName(attr);
 
-  if ((filter->group_tag != IPP_TAG_ZERO && group != filter->group_tag && group != IPP_TAG_ZERO) || !name || (!strcmp(name, "media-col-database") && !cupsArrayFind(filter->ra, (void *)name)))
+  if ((filter->group_tag != IPP_TAG_ZERO && group != filter->group_tag && group != IPP_TAG_ZERO) || !name || (!strcmp(name, "media-col-database") && (!filter->ra || !_PAPPL_REQUESTED(filter->ra, _PAPPL_RA_MEDIA_COL_DATABASE))))
     return (0);
 
-  return (!filter->ra || cupsArrayFind(filter->ra, (void *)name) != NULL);
+  return (_papplRAFind(filter->ra, name));
+}
+
+
+//
+// 'ra_init()' - Initialize the known attribute name hash table.
+//
+
+static void
+ra_init(void)
+{
+  int		i;			// Looping var
+  unsigned	hash;			// Hash bucket
+
+
+  for (i = _PAPPL_RA_NAMES - 1; i >= 0; i --)
+  {
+    if (!ra_names[i])
+      continue;
+
+    hash       = _papplHashString(ra_names[i], NULL) & (_PAPPL_RA_HASH - 1);
+    ra_next[i] = ra_hash[hash];
+    ra_hash[hash] = (short)(i + 1);
+  }
+}
+
+
+//
+// 'ra_lookup()' - Look up a known attribute name.
+//
+
+static int				// O - Index or `-1` if not known
+ra_lookup(const char *name)		// I - Attribute name
+{
+  int	i;				// Index, plus 1
+
+
+  for (i = ra_hash[_papplHashString(name, NULL) & (_PAPPL_RA_HASH - 1)]; i > 0; i = ra_next[i - 1])
+  {
+    if (!strcmp(ra_names[i - 1], name))
+      return (i - 1);
+  }
+
+  return (-1);
 }
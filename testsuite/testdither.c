@@ -0,0 +1,171 @@
+//
+// Dither unit test for the Printer Application Framework
+//
+// Copyright © 2020 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+// Usage:
+//
+//   testdither
+//
+// Each SIMD dither implementation supported by this CPU is compared with the
+// scalar implementation, which must produce bit-identical lines for all
+// starting columns, widths, and tails.
+//
+
+//
+// Include necessary headers...
+//
+
+#include <pappl/pappl-private.h>
+
+
+//
+// Constants...
+//
+
+#define TEST_MAX_WIDTH	300		// Maximum number of columns to test
+#define TEST_MAX_X	16		// Maximum starting column to test
+#define TEST_BYTES	((TEST_MAX_X + TEST_MAX_WIDTH + 7) / 8 + 2)
+					// Bytes in output line, with a guard byte
+
+
+//
+// Local functions...
+//
+
+static bool	test_dither(const char *name);
+static unsigned	test_random(void);
+
+
+//
+// Local globals...
+//
+
+static unsigned	test_seed = 42;		// Random number seed
+
+
+//
+// 'main()' - Main entry for dither unit test.
+//
+
+int					// O - Exit status
+main(void)
+{
+  int		i;			// Looping var
+  bool		ret = true;		// Test result
+  static const char * const names[] =	// SIMD implementations
+  {
+    "avx2",
+    "sse2",
+    "neon"
+  };
+
+
+  for (i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i ++)
+  {
+    if (!test_dither(names[i]))
+      ret = false;
+  }
+
+  return (ret ? 0 : 1);
+}
+
+
+//
+// 'test_dither()' - Compare a SIMD dither implementation with the scalar one.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_dither(const char *name)		// I - Implementation name
+{
+  unsigned char	pixels[TEST_MAX_WIDTH],	// Input pixels
+		dither[16],		// Dither matrix row
+		expected[TEST_BYTES],	// Scalar output
+		actual[TEST_BYTES];	// SIMD output
+  unsigned	pass,			// Current pass
+		x,			// Starting column
+		count,			// Number of columns
+		i;			// Looping var
+  int		black;			// Black or luminance pixels?
+  size_t	j;			// Byte in line
+
+
+  printf("_papplJobDitherLine(%s): ", name);
+  fflush(stdout);
+
+  if (!_papplJobDitherSelect(name))
+  {
+    puts("SKIP (not supported)");
+    return (true);
+  }
+
+  for (pass = 0; pass < 3; pass ++)
+  {
+    // Pass 0 uses random pixels and thresholds, pass 1 uses pixels equal to the
+    // thresholds, and pass 2 uses solid black and white pixels...
+    for (i = 0; i < 16; i ++)
+      dither[i] = (unsigned char)test_random();
+
+    for (x = 0; x < TEST_MAX_X; x ++)
+    {
+      for (count = 1; count <= TEST_MAX_WIDTH; count ++)
+      {
+	for (i = 0; i < count; i ++)
+	{
+	  if (pass == 0)
+	    pixels[i] = (unsigned char)test_random();
+	  else if (pass == 1)
+	    pixels[i] = dither[(x + i) & 15];
+	  else
+	    pixels[i] = (i & 1) ? 0xff : 0x00;
+	}
+
+	for (black = 0; black < 2; black ++)
+	{
+	  // Fill both lines with the same pattern so that changes outside the
+	  // columns are also compared...
+	  memset(expected, 0xa5, sizeof(expected));
+	  memset(actual, 0xa5, sizeof(actual));
+
+	  _papplJobDitherSelect("scalar");
+	  _papplJobDitherLine(expected, pixels, x, count, dither, black != 0);
+
+	  _papplJobDitherSelect(name);
+	  _papplJobDitherLine(actual, pixels, x, count, dither, black != 0);
+
+	  if (memcmp(expected, actual, sizeof(expected)))
+	  {
+	    for (j = 0; j < sizeof(expected); j ++)
+	    {
+	      if (expected[j] != actual[j])
+		break;
+	    }
+
+	    printf("FAIL (pass %u, x=%u, count=%u, black=%d: byte %u is 0x%02x, expected 0x%02x)\n", pass, x, count, black, (unsigned)j, actual[j], expected[j]);
+	    return (false);
+	  }
+	}
+      }
+    }
+  }
+
+  puts("PASS");
+
+  return (true);
+}
+
+
+//
+// 'test_random()' - Return a repeatable pseudo-random number.
+//
+
+static unsigned				// O - Random number from 0 to 255
+test_random(void)
+{
+  test_seed = test_seed * 1103515245 + 12345;
+
+  return ((test_seed >> 16) & 255);
+}
@@ -61,7 +61,7 @@ main(int  argc,				// I - Number of command-line arguments
   pappl_loglevel_t	level = PAPPL_LOGLEVEL_DEBUG;
   					// Log level
   bool			clean = false;	// Clean run?
-  pappl_soptions_t	soptions = PAPPL_SOPTIONS_MULTI_QUEUE | PAPPL_SOPTIONS_STANDARD | PAPPL_SOPTIONS_LOG | PAPPL_SOPTIONS_NETWORK | PAPPL_SOPTIONS_SECURITY | PAPPL_SOPTIONS_TLS | PAPPL_SOPTIONS_RAW_SOCKET;
+  pappl_soptions_t	soptions = PAPPL_SOPTIONS_MULTI_QUEUE | PAPPL_SOPTIONS_STANDARD | PAPPL_SOPTIONS_LOG | PAPPL_SOPTIONS_NETWORK | PAPPL_SOPTIONS_SECURITY | PAPPL_SOPTIONS_TLS | PAPPL_SOPTIONS_RAW_SOCKET | PAPPL_SOPTIONS_RASTER_SPOOL;
 					// System options
   pappl_system_t	*system;	// System
   pappl_printer_t	*printer;	// Printer
@@ -47,3 +47,7 @@
 #define HAVE_ARC4RANDOM 1
 /* #undef HAVE_GETRANDOM */
 /* #undef HAVE_GNUTLS_RND */
+
+
+// Event notification support
+/* #undef HAVE_SYS_EPOLL_H */